@@ -0,0 +1,140 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace boot_module::bench
+{
+// One measured configuration of a benchmark, e.g. getDevices at 1000 objects
+struct BenchResult
+{
+  std::string                   name;
+  std::map<std::string, double> params;
+  std::map<std::string, double> metrics;
+};
+
+class Reporter
+{
+public:
+  void record(BenchResult result);
+  void printTable(std::ostream& out) const;
+  // Machine-readable form for tracking regressions between releases:
+  // {"suite", "version", "timestamp", "results": [{name, params, metrics}]}
+  void writeJson(std::ostream& out) const;
+
+  const std::vector<BenchResult>& results() const { return m_results; }
+
+private:
+  std::vector<BenchResult> m_results;
+};
+
+using BenchFunction = std::function<void(Reporter&)>;
+
+// Benchmarks register themselves at static-initialisation time
+std::map<std::string, BenchFunction>& registry();
+
+struct Registrar
+{
+  Registrar(const std::string& name, BenchFunction function)
+  {
+    registry()[name] = std::move(function);
+  }
+};
+
+struct LatencyStats
+{
+  size_t samples = 0;
+  double meanUs  = 0;
+  double p50Us   = 0;
+  double p99Us   = 0;
+  double minUs   = 0;
+  double maxUs   = 0;
+
+  void addTo(std::map<std::string, double>& metrics) const
+  {
+    metrics["mean_us"] = meanUs;
+    metrics["p50_us"]  = p50Us;
+    metrics["p99_us"]  = p99Us;
+    metrics["min_us"]  = minUs;
+    metrics["max_us"]  = maxUs;
+  }
+};
+
+inline LatencyStats summarize(std::vector<double> samplesUs)
+{
+  LatencyStats stats;
+  if (samplesUs.empty())
+  {
+    return stats;
+  }
+
+  std::sort(samplesUs.begin(), samplesUs.end());
+  double total = 0;
+  for (double sample : samplesUs)
+  {
+    total += sample;
+  }
+
+  stats.samples = samplesUs.size();
+  stats.meanUs  = total / samplesUs.size();
+  stats.p50Us   = samplesUs[samplesUs.size() / 2];
+  stats.p99Us   = samplesUs[(samplesUs.size() * 99) / 100];
+  stats.minUs   = samplesUs.front();
+  stats.maxUs   = samplesUs.back();
+  return stats;
+}
+
+// Silences std::cout while in scope, for code under test that reports
+// progress on every call
+class QuietStdout
+{
+public:
+  QuietStdout() : m_previous(std::cout.rdbuf(&m_null)) {}
+  ~QuietStdout() { std::cout.rdbuf(m_previous); }
+
+  QuietStdout(const QuietStdout&)            = delete;
+  QuietStdout& operator=(const QuietStdout&) = delete;
+
+private:
+  struct NullBuffer : std::streambuf
+  {
+    int overflow(int c) override { return c; }
+  };
+
+  NullBuffer      m_null;
+  std::streambuf* m_previous;
+};
+
+// Time `iterations` calls of fn, after a short warm-up
+template <typename Function>
+LatencyStats measureLatency(size_t iterations, Function&& fn)
+{
+  using Clock = std::chrono::steady_clock;
+
+  for (size_t i = 0; i < std::min<size_t>(iterations / 10 + 1, 10); i++)
+  {
+    fn();
+  }
+
+  std::vector<double> samples;
+  samples.reserve(iterations);
+  for (size_t i = 0; i < iterations; i++)
+  {
+    auto start = Clock::now();
+    fn();
+    samples.push_back(
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+  }
+  return summarize(std::move(samples));
+}
+}  // namespace boot_module::bench
+
+#endif  // BENCH_H
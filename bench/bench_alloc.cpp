@@ -0,0 +1,234 @@
+// Heap allocations per notification on the thread that receives them, once
+// the subscription is warm: the typed PropertiesChanged handler the manager
+// used to install (property map plus a Value copy per packet), the
+// std::vector callback of enableNotifications, and pooled buffers, both
+// released at once and held for a while by the consumer.
+//
+// This file replaces the global operator new/delete with versions that
+// count calls per thread, so it is built into bscm-bench-alloc on its own
+// rather than into bscm-bench. Allocations libsystemd makes with malloc for
+// the incoming message itself are not counted; they happen whatever the
+// client does.
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/bluez_constants.hpp"
+#include "private_bus.hpp"
+
+namespace
+{
+thread_local uint64_t t_allocations = 0;
+
+void* countedAlloc(std::size_t size)
+{
+  t_allocations++;
+  if (void* memory = std::malloc(size ? size : 1))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return countedAlloc(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t NOTIFICATIONS = 2000;
+// Enough for the pool, sdbus and the event loop to reach steady state
+constexpr size_t WARMUP        = 200;
+constexpr size_t PAYLOAD_SIZE  = 20;
+// Buffers the holding consumer keeps before releasing the oldest
+constexpr size_t HELD_BUFFERS  = 4;
+
+// Samples the receiving thread's allocation count from inside the callback
+class AllocationProbe
+{
+public:
+  void onNotification()
+  {
+    size_t index = m_received;
+    if (index == WARMUP)
+    {
+      m_first = t_allocations;
+    }
+    m_last = t_allocations;
+    m_received++;
+  }
+
+  bool waitForAll() const
+  {
+    auto deadline = Clock::now() + std::chrono::seconds(30);
+    while (m_received < NOTIFICATIONS && Clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return m_received == NOTIFICATIONS;
+  }
+
+  void report(Reporter& reporter, const char* name) const
+  {
+    BenchResult result{
+      name, {{"notifications", NOTIFICATIONS}, {"warmup", WARMUP}}, {}};
+    result.metrics["received"] = static_cast<double>(m_received);
+    result.metrics["allocs_per_notification"] =
+      static_cast<double>(m_last - m_first) / (NOTIFICATIONS - WARMUP - 1);
+    reporter.record(std::move(result));
+  }
+
+private:
+  std::atomic<size_t>   m_received{0};
+  std::atomic<uint64_t> m_first{0};
+  std::atomic<uint64_t> m_last{0};
+};
+
+void sendNotifications(StubEnvironment& env)
+{
+  std::vector<uint8_t> payload(PAYLOAD_SIZE);
+  for (size_t i = 0; i < NOTIFICATIONS; i++)
+  {
+    payload[0] = static_cast<uint8_t>(i);
+    env.bluez().notify(0, 0, 0, payload);
+  }
+}
+
+void benchTypedHandler(Reporter& reporter)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  auto connection = env.connect();
+  auto proxy      = sdbus::createProxy(
+    *connection,
+    sdbus::ServiceName(BLUEZ_SERVICE),
+    sdbus::ObjectPath(env.bluez().characteristicPath(0, 0, 0)));
+
+  AllocationProbe probe;
+  proxy->uponSignal("PropertiesChanged")
+    .onInterface(PROPERTIES_INTERFACE)
+    .call([&probe](const std::string&                           interface,
+                   const std::map<std::string, sdbus::Variant>& changed,
+                   const std::vector<std::string>&) {
+      if (interface == GATT_CHAR_INTERFACE && changed.count("Value"))
+      {
+        auto value = changed.at("Value").get<std::vector<uint8_t>>();
+        probe.onNotification();
+      }
+    });
+  connection->enterEventLoopAsync();
+
+  sendNotifications(env);
+  probe.waitForAll();
+  connection->leaveEventLoop();
+
+  probe.report(reporter, "alloc/typedHandler");
+}
+
+void benchVectorCallback(Reporter& reporter)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  AllocationProbe probe;
+  manager.enableNotifications(
+    env.bluez().characteristicPath(0, 0, 0),
+    [&probe](const std::vector<uint8_t>&) { probe.onNotification(); });
+
+  sendNotifications(env);
+  probe.waitForAll();
+  manager.stopEventLoop();
+
+  probe.report(reporter, "alloc/vectorCallback");
+}
+
+void benchPooled(Reporter& reporter, bool hold)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  std::string     path = env.bluez().characteristicPath(0, 0, 0);
+  AllocationProbe probe;
+  std::array<PooledBuffer, HELD_BUFFERS> held;
+  size_t                                 next = 0;
+  manager.enablePooledNotifications(path, [&, hold](PooledBuffer buffer) {
+    probe.onNotification();
+    if (hold)
+    {
+      // Moving in releases the oldest held buffer back to the pool
+      held[next++ % held.size()] = std::move(buffer);
+    }
+  });
+
+  sendNotifications(env);
+  probe.waitForAll();
+  auto stats = manager.notificationPoolStats(path);
+  manager.stopEventLoop();
+
+  probe.report(reporter, hold ? "alloc/pooledHeld" : "alloc/pooled");
+  BenchResult pool{hold ? "alloc/pooledHeldStats" : "alloc/pooledStats",
+                   {{"held", hold ? HELD_BUFFERS : 0}},
+                   {}};
+  pool.metrics["buffers"] = static_cast<double>(stats.buffers);
+  pool.metrics["misses"]  = static_cast<double>(stats.misses);
+  reporter.record(std::move(pool));
+}
+
+void benchAlloc(Reporter& reporter)
+{
+  QuietStdout quiet;
+  benchTypedHandler(reporter);
+  benchVectorCallback(reporter);
+  benchPooled(reporter, false);
+  benchPooled(reporter, true);
+}
+
+Registrar registrar("alloc", benchAlloc);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,84 @@
+// Reading every characteristic of a device one blocking readCharacteristic
+// at a time versus issuing all readCharacteristicAsync calls up front, with
+// the stand-in service adding a fixed per-request latency like a BLE link.
+
+#include <future>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+constexpr size_t SERVICES        = 4;
+constexpr size_t CHARACTERISTICS = 5;  // per service
+constexpr size_t ROUNDS          = 20;
+
+void benchAsyncReads(Reporter& reporter, std::chrono::microseconds latency)
+{
+  stub::StubBluezConfig config;
+  config.devices                   = 1;
+  config.servicesPerDevice         = SERVICES;
+  config.characteristicsPerService = CHARACTERISTICS;
+  config.latency                   = latency;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  std::vector<std::string> paths;
+  for (size_t s = 0; s < SERVICES; s++)
+  {
+    for (size_t c = 0; c < CHARACTERISTICS; c++)
+    {
+      paths.push_back(env.bluez().characteristicPath(0, s, c));
+    }
+  }
+
+  std::map<std::string, double> params{
+    {"reads", paths.size()},
+    {"latency_us", static_cast<double>(latency.count())}};
+  QuietStdout quiet;
+
+  BenchResult serial{"async/serialReads", params, {}};
+  measureLatency(ROUNDS, [&]() {
+    for (const auto& path : paths)
+    {
+      manager.readCharacteristic(path);
+    }
+  }).addTo(serial.metrics);
+
+  BenchResult concurrent{"async/concurrentReads", params, {}};
+  measureLatency(ROUNDS, [&]() {
+    std::vector<std::future<std::vector<uint8_t>>> reads;
+    reads.reserve(paths.size());
+    for (const auto& path : paths)
+    {
+      reads.push_back(manager.readCharacteristicAsync(path));
+    }
+    for (auto& read : reads)
+    {
+      read.get();
+    }
+  }).addTo(concurrent.metrics);
+
+  concurrent.metrics["speedup"] =
+    serial.metrics["mean_us"] / concurrent.metrics["mean_us"];
+  reporter.record(std::move(serial));
+  reporter.record(std::move(concurrent));
+  manager.stopEventLoop();
+}
+
+void benchAsync(Reporter& reporter)
+{
+  for (auto latency : {0, 2000, 10000})
+  {
+    benchAsyncReads(reporter, std::chrono::microseconds(latency));
+  }
+}
+
+Registrar registrar("async", benchAsync);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,118 @@
+// Sustained capture rate: a million 20-byte notifications appended to a
+// CaptureLog with small segments so rotation is part of the measurement,
+// once directly and once through the std::function a notification
+// subscription delivers to. The log has to keep well ahead of the 100k
+// notifications per second a busy multi-device session can produce.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include "bench.hpp"
+#include "boot_module/capture_log.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t RECORDS        = 1000000;
+constexpr size_t PAYLOAD        = 20;
+constexpr size_t SEGMENT_BYTES  = size_t{16} << 20;
+constexpr size_t MAX_SEGMENTS   = 4;
+constexpr size_t CHARACTERISTIC = 7;
+
+void removeSegments(const CaptureLog& log, uint64_t segments)
+{
+  for (uint64_t segment = 0; segment < segments; segment++)
+  {
+    unlink(log.segmentPath(segment).c_str());
+  }
+}
+
+void report(Reporter&          reporter,
+            const std::string& name,
+            Clock::time_point  start,
+            const CaptureLog&  log)
+{
+  double seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  auto stats = log.stats();
+  reporter.record({name,
+                   {{"records", RECORDS},
+                    {"payload_bytes", PAYLOAD},
+                    {"segment_mib", SEGMENT_BYTES >> 20}},
+                   {{"ns_per_record", seconds * 1e9 / RECORDS},
+                    {"records_per_s", RECORDS / seconds},
+                    {"segments", static_cast<double>(stats.segments)},
+                    {"dropped", static_cast<double>(stats.dropped)}}});
+}
+
+void benchCapture(Reporter& reporter)
+{
+  std::string prefix =
+    "/tmp/bscm-bench-capture-" + std::to_string(getpid());
+
+  CaptureOptions options;
+  options.segmentBytes = SEGMENT_BYTES;
+  options.maxSegments  = MAX_SEGMENTS;
+
+  std::vector<uint8_t> value(PAYLOAD);
+  for (size_t i = 0; i < value.size(); i++)
+  {
+    value[i] = static_cast<uint8_t>(i);
+  }
+
+  {
+    auto log = CaptureLog::create(prefix, options);
+    if (!log)
+    {
+      return;
+    }
+    log->describe(CHARACTERISTIC, "/org/bluez/hci0/dev_00/service0/char0");
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < RECORDS; i++)
+    {
+      value[0] = static_cast<uint8_t>(i);
+      log->append(
+        CHARACTERISTIC, value.data(), value.size(), CaptureLog::now());
+    }
+    log->close();
+    report(reporter, "capture/append", start, *log);
+    removeSegments(*log, log->stats().segments);
+  }
+
+  {
+    std::shared_ptr<CaptureLog> log = CaptureLog::create(prefix, options);
+    if (!log)
+    {
+      return;
+    }
+    log->describe(CHARACTERISTIC, "/org/bluez/hci0/dev_00/service0/char0");
+
+    // Same shape as the callback captureNotifications subscribes
+    std::function<void(const std::vector<uint8_t>&)> callback =
+      [log](const std::vector<uint8_t>& data) {
+        log->append(CHARACTERISTIC, data.data(), data.size(),
+                    CaptureLog::now());
+      };
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < RECORDS; i++)
+    {
+      value[0] = static_cast<uint8_t>(i);
+      callback(value);
+    }
+    log->close();
+    report(reporter, "capture/callback", start, *log);
+    removeSegments(*log, log->stats().segments);
+  }
+}
+
+Registrar registrar("capture", benchCapture);
+}  // namespace
+}  // namespace boot_module::bench
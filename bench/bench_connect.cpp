@@ -0,0 +1,107 @@
+// Time from calling connectDevice until GATT is usable (Connected and
+// ServicesResolved both set) against the stand-in service, and bringing up a
+// fleet of devices through ConnectionManager at several parallelism limits.
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/connection_manager.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+void benchConnect(Reporter& reporter)
+{
+  using Clock = std::chrono::steady_clock;
+
+  stub::StubBluezConfig config;
+  config.devices = 4;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  std::string      address = env.bluez().deviceAddress(0);
+
+  QuietStdout         quiet;
+  std::vector<double> samples;
+  for (int i = 0; i < 50; i++)
+  {
+    auto start = Clock::now();
+    if (!manager.connectDevice(address))
+    {
+      throw std::runtime_error("connectDevice failed against stub");
+    }
+    samples.push_back(
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    manager.disconnectDevice(address);
+  }
+
+  BenchResult result{"connect/connectDevice", {}, {}};
+  summarize(std::move(samples)).addTo(result.metrics);
+  reporter.record(std::move(result));
+}
+
+void benchConnectAll(Reporter& reporter, size_t parallelism)
+{
+  using Clock = std::chrono::steady_clock;
+
+  constexpr size_t FLEET_SIZE = 30;
+
+  stub::StubBluezConfig config;
+  config.devices = FLEET_SIZE;
+  // Roughly what an LE connection plus service discovery costs
+  config.latency = std::chrono::milliseconds(50);
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  std::vector<std::string> addresses;
+  for (size_t i = 0; i < FLEET_SIZE; i++)
+  {
+    addresses.push_back(env.bluez().deviceAddress(i));
+  }
+
+  QuietStdout       quiet;
+  ConnectionManager connections(manager, parallelism);
+  auto              start   = Clock::now();
+  auto              devices = connections.connectAll(addresses);
+  double            totalMs =
+    std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  std::vector<double> readyUs;
+  size_t              ready = 0;
+  for (const auto& device : devices)
+  {
+    if (device.state == DeviceState::Ready)
+    {
+      ready++;
+      readyUs.push_back(static_cast<double>(device.timeToReady().count()));
+    }
+  }
+
+  BenchResult result{
+    "connect/connectAll",
+    {{"devices", FLEET_SIZE},
+     {"parallelism", parallelism},
+     {"latency_ms", 50}},
+    {}};
+  summarize(std::move(readyUs)).addTo(result.metrics);
+  result.metrics["ready"]    = static_cast<double>(ready);
+  result.metrics["total_ms"] = totalMs;
+  reporter.record(std::move(result));
+  manager.stopEventLoop();
+}
+
+void benchConnectFleet(Reporter& reporter)
+{
+  benchConnect(reporter);
+  for (size_t parallelism : {1, 3, 10})
+  {
+    benchConnectAll(reporter, parallelism);
+  }
+}
+
+Registrar registrar("connect", benchConnectFleet);
+}  // namespace
+}  // namespace boot_module::bench
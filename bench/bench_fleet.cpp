@@ -0,0 +1,86 @@
+// Fleet flashing through FleetFlasher: 32 stand-in boot targets, each sent
+// the same 64 KiB image, with 1, 4 and 8 devices flashing at once. Connects
+// are delayed as a BLE round trip would, so the wall time shows how much of
+// each device's connect and ack waits the other devices' work overlaps.
+
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/fleet_flasher.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+constexpr size_t DEVICES    = 32;
+constexpr size_t IMAGE_SIZE = 64 * 1024;
+
+void benchFleetOnce(Reporter& reporter, const std::string& image, size_t jobs)
+{
+  stub::StubBluezConfig config;
+  config.devices            = DEVICES;
+  config.latency            = std::chrono::milliseconds(5);
+  config.bootTarget.enabled = true;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  const auto&  boot = config.bootTarget;
+  FleetOptions options;
+  options.parallelism = jobs;
+  options.dataCharacteristic =
+    Uuid::fromShort(0x2a00 + static_cast<uint32_t>(boot.dataCharacteristic));
+  options.statusCharacteristic =
+    Uuid::fromShort(0x2a00 + static_cast<uint32_t>(boot.statusCharacteristic));
+
+  std::vector<FleetJob> fleet;
+  for (size_t i = 0; i < DEVICES; i++)
+  {
+    fleet.push_back({env.bluez().deviceAddress(i), image});
+  }
+
+  QuietStdout quiet;
+  auto        report = FleetFlasher(manager, options).run(fleet);
+  manager.stopEventLoop();
+
+  size_t completed = 0;
+  for (size_t i = 0; i < DEVICES; i++)
+  {
+    completed += env.bluez().completedUploads(i);
+  }
+  reporter.record(
+    {"fleet/flash",
+     {{"devices", DEVICES}, {"bytes", IMAGE_SIZE}, {"jobs", jobs}},
+     {{"succeeded", static_cast<double>(report.succeeded)},
+      {"completed", static_cast<double>(completed)},
+      {"seconds", report.elapsed.count() / 1000.0},
+      {"kbytes_per_sec", report.bytesPerSecond / 1024.0}}});
+}
+
+void benchFleet(Reporter& reporter)
+{
+  std::string path = "/tmp/bscm-bench-fleet-" + std::to_string(getpid());
+  {
+    std::ofstream file(path, std::ios::binary);
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+    {
+      file.put(static_cast<char>(i * 31));
+    }
+  }
+
+  for (size_t jobs : {1, 4, 8})
+  {
+    benchFleetOnce(reporter, path, jobs);
+  }
+  unlink(path.c_str());
+}
+
+Registrar registrar("fleet", benchFleet);
+}  // namespace
+}  // namespace boot_module::bench
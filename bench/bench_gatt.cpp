@@ -0,0 +1,53 @@
+// Read and write round trips through BluetoothManager against the stand-in
+// service with no added latency, so what is measured is the bus and the
+// manager's own overhead: blocking ReadValue and WriteValue by path and by
+// interned handle, and the async variants waited on one at a time.
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+constexpr size_t ITERATIONS = 1000;
+
+void benchGatt(Reporter& reporter)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  std::string path   = env.bluez().characteristicPath(0, 0, 0);
+  GattHandle  handle = manager.characteristicHandle(path);
+
+  std::vector<uint8_t> value(config.valueSize, 0x5a);
+  QuietStdout          quiet;
+
+  auto run = [&](const char* name, auto&& fn) {
+    BenchResult result{name, {{"value_size", config.valueSize}}, {}};
+    measureLatency(ITERATIONS, fn).addTo(result.metrics);
+    reporter.record(std::move(result));
+  };
+
+  run("gatt/readByPath", [&]() { manager.readCharacteristic(path); });
+  run("gatt/readByHandle", [&]() { manager.readCharacteristic(handle); });
+  run("gatt/writeByPath",
+      [&]() { manager.writeCharacteristic(path, value); });
+  run("gatt/writeByHandle",
+      [&]() { manager.writeCharacteristic(handle, value); });
+  run("gatt/readAsync",
+      [&]() { manager.readCharacteristicAsync(path).get(); });
+  run("gatt/writeAsync",
+      [&]() { manager.writeCharacteristicAsync(path, value).get(); });
+
+  manager.stopEventLoop();
+}
+
+Registrar registrar("gatt", benchGatt);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,218 @@
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.hpp"
+
+#ifndef BSCM_VERSION
+#define BSCM_VERSION "unknown"
+#endif
+
+#ifndef BSCM_BENCH_SUITE
+#define BSCM_BENCH_SUITE "bscm-bench"
+#endif
+
+namespace boot_module::bench
+{
+namespace
+{
+void writeJsonString(std::ostream& out, const std::string& text)
+{
+  out << '"';
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      out << '\\' << c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+          << static_cast<int>(c) << std::dec << std::setfill(' ');
+    }
+    else
+    {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void writeJsonObject(std::ostream&                        out,
+                     const std::map<std::string, double>& values)
+{
+  out << '{';
+  const char* separator = "";
+  for (const auto& [name, value] : values)
+  {
+    out << separator;
+    writeJsonString(out, name);
+    // JSON has no NaN or infinity
+    if (std::isfinite(value))
+    {
+      out << ": " << value;
+    }
+    else
+    {
+      out << ": null";
+    }
+    separator = ", ";
+  }
+  out << '}';
+}
+
+std::string utcTimestamp()
+{
+  std::time_t now = std::time(nullptr);
+  std::tm     utc{};
+  gmtime_r(&now, &utc);
+  char text[32];
+  std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  return text;
+}
+
+void printUsage(const char* program)
+{
+  std::cerr << "Usage: " << program << " [--json FILE] [--list] [NAME...]\n"
+            << "  --json FILE  also write results as JSON to FILE ('-' for "
+               "stdout, replacing the table)\n"
+            << "  --list       list benchmark names and exit\n"
+            << "  NAME...      run only these benchmarks" << std::endl;
+}
+}  // namespace
+
+std::map<std::string, BenchFunction>& registry()
+{
+  static std::map<std::string, BenchFunction> benchmarks;
+  return benchmarks;
+}
+
+void Reporter::record(BenchResult result)
+{
+  m_results.push_back(std::move(result));
+}
+
+void Reporter::printTable(std::ostream& out) const
+{
+  for (const auto& result : m_results)
+  {
+    out << std::left << std::setw(36) << result.name;
+    for (const auto& [name, value] : result.params)
+    {
+      out << " " << name << "=" << value;
+    }
+    out << " |";
+    for (const auto& [name, value] : result.metrics)
+    {
+      out << " " << name << "=" << std::fixed << std::setprecision(2) << value;
+    }
+    out << std::defaultfloat << std::endl;
+  }
+}
+
+void Reporter::writeJson(std::ostream& out) const
+{
+  out << std::setprecision(10);
+  out << "{\n  \"suite\": ";
+  writeJsonString(out, BSCM_BENCH_SUITE);
+  out << ",\n  \"version\": ";
+  writeJsonString(out, BSCM_VERSION);
+  out << ",\n  \"timestamp\": ";
+  writeJsonString(out, utcTimestamp());
+  out << ",\n  \"results\": [";
+
+  const char* separator = "\n";
+  for (const auto& result : m_results)
+  {
+    out << separator << "    {\"name\": ";
+    writeJsonString(out, result.name);
+    out << ", \"params\": ";
+    writeJsonObject(out, result.params);
+    out << ", \"metrics\": ";
+    writeJsonObject(out, result.metrics);
+    out << '}';
+    separator = ",\n";
+  }
+  out << "\n  ]\n}" << std::endl;
+}
+}  // namespace boot_module::bench
+
+int main(int argc, char* argv[])
+{
+  using namespace boot_module::bench;
+
+  std::string              jsonPath;
+  std::vector<std::string> selected;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--json" && i + 1 < argc)
+    {
+      jsonPath = argv[++i];
+    }
+    else if (arg == "--list")
+    {
+      for (const auto& [name, function] : registry())
+      {
+        std::cout << name << std::endl;
+      }
+      return 0;
+    }
+    else if (arg.rfind("--", 0) == 0)
+    {
+      printUsage(argv[0]);
+      return 2;
+    }
+    else if (registry().count(arg))
+    {
+      selected.push_back(arg);
+    }
+    else
+    {
+      std::cerr << "Unknown benchmark: " << arg << std::endl;
+      return 2;
+    }
+  }
+
+  Reporter reporter;
+  try
+  {
+    for (const auto& [name, function] : registry())
+    {
+      if (!selected.empty() &&
+          std::find(selected.begin(), selected.end(), name) == selected.end())
+      {
+        continue;
+      }
+
+      std::cerr << "Running " << name << "..." << std::endl;
+      function(reporter);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (jsonPath == "-")
+  {
+    reporter.writeJson(std::cout);
+    return 0;
+  }
+
+  reporter.printTable(std::cout);
+  if (!jsonPath.empty())
+  {
+    std::ofstream file(jsonPath);
+    reporter.writeJson(file);
+    if (!file)
+    {
+      std::cerr << "Could not write " << jsonPath << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
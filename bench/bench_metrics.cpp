@@ -0,0 +1,86 @@
+// Cost of the bookkeeping added to every D-Bus call: a bare record(), a
+// full OperationTimer (two clock reads plus the record), the same from
+// several threads at once, and summing a snapshot. Recording is meant to
+// stay well below 50 ns so it is lost in the noise of a bus round trip.
+
+#include <thread>
+
+#include "bench.hpp"
+#include "boot_module/metrics.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t ITERATIONS = 10000000;
+constexpr size_t THREADS    = 4;
+constexpr size_t SNAPSHOTS  = 1000;
+
+double nsPer(Clock::time_point start, size_t count)
+{
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+           .count() /
+         count;
+}
+
+void benchMetrics(Reporter& reporter)
+{
+  Metrics metrics;
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < ITERATIONS; i++)
+  {
+    // Spread over the buckets as real latencies would be
+    metrics.record(Operation::ReadValue, (i * 7919) % 5000000, true);
+  }
+  reporter.record({"metrics/record",
+                   {{"iterations", ITERATIONS}},
+                   {{"ns_per_op", nsPer(start, ITERATIONS)}}});
+
+  start = Clock::now();
+  for (size_t i = 0; i < ITERATIONS; i++)
+  {
+    OperationTimer timer(metrics, Operation::WriteValue);
+    timer.succeeded();
+  }
+  reporter.record({"metrics/operationTimer",
+                   {{"iterations", ITERATIONS}},
+                   {{"ns_per_op", nsPer(start, ITERATIONS)}}});
+
+  // Threads never contend: each writes its own cells
+  std::vector<std::thread> threads;
+  start = Clock::now();
+  for (size_t t = 0; t < THREADS; t++)
+  {
+    threads.emplace_back([&metrics]() {
+      for (size_t i = 0; i < ITERATIONS; i++)
+      {
+        metrics.record(Operation::GetAll, i % 100000, true);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  reporter.record({"metrics/recordThreaded",
+                   {{"iterations", ITERATIONS}, {"threads", THREADS}},
+                   {{"ns_per_op", nsPer(start, ITERATIONS)}}});
+
+  uint64_t total = 0;
+  start          = Clock::now();
+  for (size_t i = 0; i < SNAPSHOTS; i++)
+  {
+    total += metrics.snapshot()[Operation::GetAll].count;
+  }
+  reporter.record({"metrics/snapshot",
+                   {{"threads", THREADS + 1}},
+                   {{"us_per_op", nsPer(start, SNAPSHOTS) / 1000.0},
+                    {"calls", static_cast<double>(total / SNAPSHOTS)}}});
+}
+
+Registrar registrar("metrics", benchMetrics);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,228 @@
+// Notification throughput and delivery latency for a burst of notifications:
+// the previous CLI loop (one processPendingEvent per 20 ms tick), the
+// BluetoothManager event loop thread, and AcquireNotify sockets read off the
+// bus entirely. A second case puts a slow consumer on one characteristic and
+// measures what that does to a neighbouring subscription, with the slow one
+// called directly versus fed through a notification ring.
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/bluez_constants.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t BURST_SIZE   = 500;
+constexpr size_t PAYLOAD_SIZE = 20;
+// Stands in for something like the CLI's terminal hex dump
+constexpr std::chrono::microseconds SLOW_CONSUMER_COST{500};
+
+uint64_t nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           Clock::now().time_since_epoch())
+    .count();
+}
+
+// Collects per-notification latency from the send timestamp in the payload
+class Receiver
+{
+public:
+  Receiver() { m_latenciesUs.reserve(BURST_SIZE); }
+
+  void onValue(const std::vector<uint8_t>& value)
+  {
+    uint64_t sent = 0;
+    if (value.size() >= sizeof(sent))
+    {
+      std::memcpy(&sent, value.data(), sizeof(sent));
+    }
+    m_latenciesUs.push_back(static_cast<double>(nowNs() - sent) / 1000.0);
+    m_lastNs = nowNs();
+    m_received++;
+  }
+
+  bool waitForAll(std::chrono::seconds timeout) const
+  {
+    auto deadline = Clock::now() + timeout;
+    while (m_received < BURST_SIZE && Clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return m_received == BURST_SIZE;
+  }
+
+  void report(Reporter& reporter, const char* name, uint64_t startNs)
+  {
+    BenchResult result{name, {{"burst", BURST_SIZE}}, {}};
+    summarize(m_latenciesUs).addTo(result.metrics);
+    result.metrics["received"] = static_cast<double>(m_received);
+    if (m_lastNs > startNs)
+    {
+      result.metrics["msgs_per_sec"] =
+        m_received * 1e9 / static_cast<double>(m_lastNs - startNs);
+    }
+    reporter.record(std::move(result));
+  }
+
+private:
+  std::vector<double>   m_latenciesUs;
+  std::atomic<uint64_t> m_lastNs{0};
+  std::atomic<size_t>   m_received{0};
+};
+
+uint64_t sendBurst(StubEnvironment& env)
+{
+  uint64_t             start = nowNs();
+  std::vector<uint8_t> payload(PAYLOAD_SIZE);
+  for (size_t i = 0; i < BURST_SIZE; i++)
+  {
+    uint64_t sent = nowNs();
+    std::memcpy(payload.data(), &sent, sizeof(sent));
+    env.bluez().notify(0, 0, 0, payload);
+  }
+  return start;
+}
+
+void benchPolling(Reporter& reporter)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  auto connection = env.connect();
+  auto proxy      = sdbus::createProxy(
+    *connection,
+    sdbus::ServiceName(BLUEZ_SERVICE),
+    sdbus::ObjectPath(env.bluez().characteristicPath(0, 0, 0)));
+
+  Receiver receiver;
+  proxy->uponSignal("PropertiesChanged")
+    .onInterface(PROPERTIES_INTERFACE)
+    .call([&receiver](const std::string&                           interface,
+                      const std::map<std::string, sdbus::Variant>& changed,
+                      const std::vector<std::string>&) {
+      if (interface == GATT_CHAR_INTERFACE && changed.count("Value"))
+      {
+        receiver.onValue(changed.at("Value").get<std::vector<uint8_t>>());
+      }
+    });
+
+  // The loop BluetoothCLI used to run while notifications were enabled
+  std::atomic<bool> running{true};
+  std::thread       pump([&]() {
+    while (running)
+    {
+      connection->processPendingEvent();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  });
+
+  uint64_t start = sendBurst(env);
+  receiver.waitForAll(std::chrono::seconds(30));
+  running = false;
+  pump.join();
+
+  receiver.report(reporter, "notify/polling20ms", start);
+}
+
+void benchManager(Reporter& reporter, NotifyMode mode, const char* name)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  Receiver receiver;
+  manager.enableNotifications(
+    env.bluez().characteristicPath(0, 0, 0),
+    [&receiver](const std::vector<uint8_t>& value) {
+      receiver.onValue(value);
+    },
+    mode);
+
+  uint64_t start = sendBurst(env);
+  receiver.waitForAll(std::chrono::seconds(30));
+  manager.stopEventLoop();
+
+  receiver.report(reporter, name, start);
+}
+
+void benchSlowNeighbour(Reporter& reporter, bool useRing)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  std::string slowPath = env.bluez().characteristicPath(0, 0, 1);
+  if (useRing)
+  {
+    manager.enableRingNotifications(slowPath, [](const NotificationView&) {
+      std::this_thread::sleep_for(SLOW_CONSUMER_COST);
+    });
+  }
+  else
+  {
+    manager.enableNotifications(slowPath, [](const std::vector<uint8_t>&) {
+      std::this_thread::sleep_for(SLOW_CONSUMER_COST);
+    });
+  }
+
+  Receiver fast;
+  manager.enableNotifications(
+    env.bluez().characteristicPath(0, 0, 0),
+    [&fast](const std::vector<uint8_t>& value) { fast.onValue(value); });
+
+  uint64_t             start = nowNs();
+  std::vector<uint8_t> payload(PAYLOAD_SIZE);
+  for (size_t i = 0; i < BURST_SIZE; i++)
+  {
+    env.bluez().notify(0, 0, 1, payload);
+    uint64_t sent = nowNs();
+    std::memcpy(payload.data(), &sent, sizeof(sent));
+    env.bluez().notify(0, 0, 0, payload);
+  }
+  fast.waitForAll(std::chrono::seconds(30));
+
+  auto stats = manager.ringStats(slowPath);
+  manager.disableNotifications(slowPath);
+  manager.stopEventLoop();
+
+  fast.report(reporter,
+              useRing ? "notify/slowNeighbourRing" : "notify/slowNeighbour",
+              start);
+  if (useRing)
+  {
+    BenchResult ring{"notify/ringStats", {{"slots", stats.capacity}}, {}};
+    ring.metrics["pushed"]     = static_cast<double>(stats.pushed);
+    ring.metrics["dropped"]    = static_cast<double>(stats.dropped);
+    ring.metrics["high_water"] = static_cast<double>(stats.highWater);
+    reporter.record(std::move(ring));
+  }
+}
+
+void benchNotify(Reporter& reporter)
+{
+  benchPolling(reporter);
+  benchManager(reporter, NotifyMode::Signal, "notify/eventLoop");
+  benchManager(reporter, NotifyMode::AcquireFd, "notify/acquireFd");
+  benchSlowNeighbour(reporter, false);
+  benchSlowNeighbour(reporter, true);
+}
+
+Registrar registrar("notify", benchNotify);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,76 @@
+// Query latency against object tree size: one GetManagedObjects round trip
+// per query (the previous implementation) versus the in-process mirror and
+// the GATT handle index.
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/bluez_constants.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using ManagedObjects = std::map<sdbus::ObjectPath, InterfaceMap>;
+
+size_t countDevicesWithRoundTrip(sdbus::IProxy& root)
+{
+  ManagedObjects objects;
+  root.callMethod("GetManagedObjects")
+    .onInterface(OBJECT_MANAGER_INTERFACE)
+    .storeResultsTo(objects);
+
+  size_t devices = 0;
+  for (const auto& [path, interfaces] : objects)
+  {
+    devices += interfaces.count(DEVICE_INTERFACE);
+  }
+  return devices;
+}
+
+void benchObjectTree(Reporter& reporter)
+{
+  // Roughly 10, 100, 1k and 10k exported objects
+  for (size_t target : {10, 100, 1000, 10000})
+  {
+    stub::StubBluezConfig config;
+    size_t perDevice = 1 + config.servicesPerDevice *
+                             (1 + config.characteristicsPerService);
+    config.devices = std::max<size_t>(target / perDevice, 1);
+    StubEnvironment env(config);
+
+    const double objects    = static_cast<double>(env.bluez().objectCount());
+    const size_t iterations = target >= 10000 ? 20
+                              : target >= 1000 ? 50
+                                               : 200;
+
+    auto rootConnection = env.connect();
+    auto root           = sdbus::createProxy(*rootConnection,
+                                   sdbus::ServiceName(BLUEZ_SERVICE),
+                                   sdbus::ObjectPath{"/"});
+
+    BluetoothManager manager(env.connect());
+    std::string      address     = env.bluez().deviceAddress(0);
+    std::string      servicePath = env.bluez().servicePath(0, 0);
+
+    auto run = [&](const char* name, auto&& fn) {
+      BenchResult result{name, {{"objects", objects}}, {}};
+      measureLatency(iterations, fn).addTo(result.metrics);
+      reporter.record(std::move(result));
+    };
+
+    run("object_tree/getManagedObjects",
+        [&]() { countDevicesWithRoundTrip(*root); });
+    run("object_tree/getDevices", [&]() { manager.getDevices(); });
+    run("object_tree/getServices", [&]() { manager.getServices(address); });
+    run("object_tree/getCharacteristics",
+        [&]() { manager.getCharacteristics(servicePath); });
+    GattHandle service = manager.gatt().find(servicePath);
+    run("object_tree/getCharacteristicsByHandle",
+        [&]() { manager.getCharacteristics(service); });
+  }
+}
+
+Registrar registrar("object_tree", benchObjectTree);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,56 @@
+// ReadValue round trips with a fresh proxy per call (the previous
+// implementation) versus a proxy taken from the pool.
+
+#include "bench.hpp"
+#include "boot_module/bluez_constants.hpp"
+#include "boot_module/proxy_pool.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+void readValue(sdbus::IProxy& proxy)
+{
+  std::map<std::string, sdbus::Variant> options;
+  std::vector<uint8_t>                  value;
+  proxy.callMethod("ReadValue")
+    .onInterface(GATT_CHAR_INTERFACE)
+    .withArguments(options)
+    .storeResultsTo(value);
+}
+
+void benchProxyPool(Reporter& reporter)
+{
+  stub::StubBluezConfig config;
+  config.devices = 4;
+  StubEnvironment env(config);
+
+  auto         connection = env.connect();
+  ProxyPool    pool(*connection);
+  std::string  path       = env.bluez().characteristicPath(0, 0, 0);
+  const size_t iterations = 2000;
+
+  BenchResult fresh{"proxy_pool/createProxyPerCall", {}, {}};
+  measureLatency(iterations, [&]() {
+    auto proxy = sdbus::createProxy(*connection,
+                                    sdbus::ServiceName(BLUEZ_SERVICE),
+                                    sdbus::ObjectPath(path));
+    readValue(*proxy);
+  }).addTo(fresh.metrics);
+  reporter.record(std::move(fresh));
+
+  BenchResult pooled{"proxy_pool/pooled", {}, {}};
+  measureLatency(iterations, [&]() {
+    readValue(*pool.get(path));
+  }).addTo(pooled.metrics);
+
+  auto stats               = pool.stats();
+  pooled.metrics["hits"]   = static_cast<double>(stats.hits);
+  pooled.metrics["misses"] = static_cast<double>(stats.misses);
+  reporter.record(std::move(pooled));
+}
+
+Registrar registrar("proxy_pool", benchProxyPool);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,147 @@
+// Device bookkeeping at 10k simulated advertisers, in process with no bus:
+// DeviceRegistry inserts, address lookups, RSSI updates and path lookups,
+// against the string-keyed map, the linear scan over a DeviceInfo vector
+// the CLI used, and getDevicePath's string rebuild.
+
+#include "bench.hpp"
+#include "boot_module/device_registry.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t DEVICES = 10000;
+// Lookups for the linear scan, which is too slow to run DEVICES of
+constexpr size_t SCAN_LOOKUPS = 500;
+
+const std::string ADAPTER_PATH = "/org/bluez/hci0";
+
+struct SimulatedDevice
+{
+  std::string address;
+  std::string path;
+  PropertyMap props;
+};
+
+std::vector<SimulatedDevice> simulateDevices()
+{
+  std::vector<SimulatedDevice> devices(DEVICES);
+  for (size_t i = 0; i < DEVICES; i++)
+  {
+    // Sequential addresses under one vendor prefix, the worst case for a
+    // weak hash
+    MacAddress mac = 0xC098E5000000 | i;
+
+    auto& device   = devices[i];
+    device.address = formatMac(mac);
+    device.path    = ADAPTER_PATH + "/dev_" + formatMac(mac, '_');
+
+    std::vector<std::string> uuids = {"0000180f-0000-1000-8000-00805f9b34fb",
+                                      "0000180a-0000-1000-8000-00805f9b34fb"};
+    device.props["Address"]   = sdbus::Variant(device.address);
+    device.props["Name"]      = sdbus::Variant("sensor-" + std::to_string(i));
+    device.props["RSSI"]      = sdbus::Variant(static_cast<int16_t>(-60));
+    device.props["Connected"] = sdbus::Variant(false);
+    device.props["Paired"]    = sdbus::Variant(false);
+    device.props["UUIDs"]     = sdbus::Variant(uuids);
+  }
+  return devices;
+}
+
+class Recorder
+{
+public:
+  explicit Recorder(Reporter& reporter) : m_reporter(reporter) {}
+
+  // Time count calls of fn(i), which returns how many lookups succeeded
+  template <typename Function>
+  void run(const char* name, size_t count, Function&& fn)
+  {
+    size_t found = 0;
+    auto   start = Clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+      found += fn(i);
+    }
+    double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    BenchResult result{name, {{"devices", DEVICES}}, {}};
+    result.metrics["ns_per_op"] = ns / count;
+    result.metrics["found"]     = static_cast<double>(found);
+    m_reporter.record(std::move(result));
+  }
+
+private:
+  Reporter& m_reporter;
+};
+
+void benchRegistry(Reporter& reporter)
+{
+  auto     devices = simulateDevices();
+  Recorder recorder(reporter);
+
+  DeviceRegistry registry;
+  recorder.run("registry/upsert", DEVICES, [&](size_t i) {
+    registry.upsert(devices[i].path, devices[i].props);
+    return 1;
+  });
+
+  recorder.run("registry/lookup", DEVICES, [&](size_t i) {
+    MacAddress   mac;
+    DeviceStatus status;
+    return parseMac(devices[i].address, mac) && registry.status(mac, status);
+  });
+
+  std::map<std::string, DeviceInfo> byString;
+  for (const auto& device : devices)
+  {
+    byString[device.address].address = device.address;
+  }
+  recorder.run("string_map/lookup", DEVICES, [&](size_t i) {
+    return byString.count(devices[i].address);
+  });
+
+  auto cached = registry.snapshot();
+  recorder.run("vector/linearScan", SCAN_LOOKUPS, [&](size_t i) {
+    const auto& address = devices[i * (DEVICES / SCAN_LOOKUPS)].address;
+    for (const auto& device : cached)
+    {
+      if (device.address == address)
+      {
+        return true;
+      }
+    }
+    return false;
+  });
+
+  PropertyMap rssi{{"RSSI", sdbus::Variant(static_cast<int16_t>(-70))}};
+  recorder.run("registry/rssiUpdate", DEVICES, [&](size_t i) {
+    return registry.apply(devices[i].path, rssi);
+  });
+
+  recorder.run("registry/devicePath", DEVICES, [&](size_t i) {
+    MacAddress mac;
+    return parseMac(devices[i].address, mac) && !registry.path(mac).empty();
+  });
+
+  // What getDevicePath did before the registry
+  recorder.run("string/devicePath", DEVICES, [&](size_t i) {
+    std::string devAddress = devices[i].address;
+    std::replace(devAddress.begin(), devAddress.end(), ':', '_');
+    return !(ADAPTER_PATH + "/dev_" + devAddress).empty();
+  });
+
+  recorder.run("registry/seenSince", 100, [&](size_t) {
+    return registry.seenSince(0).size() == DEVICES;
+  });
+  recorder.run("registry/snapshot", 10, [&](size_t) {
+    return registry.snapshot().size() == DEVICES;
+  });
+}
+
+Registrar registrar("registry", benchRegistry);
+}  // namespace
+}  // namespace boot_module::bench
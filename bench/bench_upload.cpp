@@ -0,0 +1,88 @@
+// Firmware upload through FirmwareUploader against the stand-in boot target:
+// a 1 MiB image from a memory-mapped file, acked every 8 packets, at a few
+// window sizes and with credit-based flow control. The stub checks every
+// packet for gaps, so a completed upload also proves the pacing kept the
+// image intact.
+
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/firmware_upload.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+constexpr size_t IMAGE_SIZE = 1024 * 1024;
+
+void benchUploadOnce(Reporter&            reporter,
+                     const FirmwareImage& image,
+                     FlowControl          flow,
+                     size_t               window)
+{
+  stub::StubBluezConfig config;
+  config.devices            = 1;
+  config.bootTarget.enabled = true;
+  config.bootTarget.credits = flow == FlowControl::Credits;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+
+  const auto&   boot = config.bootTarget;
+  UploadOptions options;
+  options.dataPath = env.bluez().characteristicPath(
+    0, boot.service, boot.dataCharacteristic);
+  options.statusPath = env.bluez().characteristicPath(
+    0, boot.service, boot.statusCharacteristic);
+  options.flow   = flow;
+  options.window = window;
+
+  FirmwareUploader uploader(manager);
+  auto             result = uploader.upload(image, options);
+  manager.stopEventLoop();
+
+  reporter.record(
+    {flow == FlowControl::Credits ? "upload/credits" : "upload/window",
+     {{"bytes", IMAGE_SIZE}, {"mtu", config.mtu}, {"window", window}},
+     {{"complete",
+       static_cast<double>(result.ok() &&
+                           env.bluez().completedUploads(0) == 1)},
+      {"seconds", result.elapsed.count() / 1000.0},
+      {"kbytes_per_sec", result.bytesPerSecond / 1024.0},
+      {"packets", static_cast<double>(result.packets)},
+      {"retransmitted", static_cast<double>(result.retransmitted)}}});
+}
+
+void benchUpload(Reporter& reporter)
+{
+  std::string path = "/tmp/bscm-bench-image-" + std::to_string(getpid());
+  {
+    std::ofstream file(path, std::ios::binary);
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+    {
+      file.put(static_cast<char>(i * 31));
+    }
+  }
+  auto image = FirmwareImage::open(path);
+  unlink(path.c_str());
+  if (!image)
+  {
+    return;
+  }
+
+  for (size_t window : {4, 16, 64})
+  {
+    benchUploadOnce(reporter, *image, FlowControl::Window, window);
+  }
+  benchUploadOnce(reporter, *image, FlowControl::Credits, 16);
+}
+
+Registrar registrar("upload", benchUpload);
+}  // namespace
+}  // namespace boot_module::bench
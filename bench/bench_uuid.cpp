@@ -0,0 +1,121 @@
+// Service filtering over 10k devices advertising several UUIDs each, looking
+// for any of several services: string compares with std::find (what
+// getDevices did) against parsed Uuid values, plus the parse itself and the
+// registry's filtered snapshot that now backs getDevices.
+
+#include "bench.hpp"
+#include "boot_module/device_registry.hpp"
+#include "boot_module/uuid.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t DEVICES          = 10000;
+constexpr size_t UUIDS_PER_DEVICE = 4;
+constexpr size_t PASSES           = 20;
+
+// Common SIG services; every device advertises a rotating subset
+const std::vector<uint16_t> SERVICES = {
+  0x180a, 0x180f, 0x1809, 0x180d, 0x1816, 0x181a, 0x1819, 0x1826};
+
+// Rare enough that the filters match a few percent of devices
+const std::vector<std::string> FILTER = {
+  "0000fe59-0000-1000-8000-00805f9b34fb",
+  "00001826-0000-1000-8000-00805f9b34fb",
+  "0000fd6f-0000-1000-8000-00805f9b34fb"};
+
+std::vector<std::vector<std::string>> simulateAdvertisements()
+{
+  std::vector<std::vector<std::string>> devices(DEVICES);
+  for (size_t i = 0; i < DEVICES; i++)
+  {
+    for (size_t j = 0; j < UUIDS_PER_DEVICE; j++)
+    {
+      // Only every tenth device reaches the last, filtered-for service
+      size_t service = (i + j) % (i % 10 == 0 ? SERVICES.size()
+                                              : SERVICES.size() - 1);
+      devices[i].push_back(Uuid::fromShort(SERVICES[service]).toString());
+    }
+  }
+  return devices;
+}
+
+template <typename Function>
+void run(Reporter& reporter, const char* name, size_t passes, Function&& fn)
+{
+  size_t matched = 0;
+  auto   start   = Clock::now();
+  for (size_t pass = 0; pass < passes; pass++)
+  {
+    matched = fn();
+  }
+  double ns =
+    std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  BenchResult result{name,
+                     {{"devices", DEVICES},
+                      {"uuids_per_device", UUIDS_PER_DEVICE},
+                      {"filter_uuids", FILTER.size()}},
+                     {}};
+  result.metrics["ns_per_device"] = ns / passes / DEVICES;
+  result.metrics["matched"]       = static_cast<double>(matched);
+  reporter.record(std::move(result));
+}
+
+void benchUuid(Reporter& reporter)
+{
+  auto advertised = simulateAdvertisements();
+
+  run(reporter, "uuid/stringFind", PASSES, [&]() {
+    size_t matched = 0;
+    for (const auto& uuids : advertised)
+    {
+      for (const auto& wanted : FILTER)
+      {
+        if (std::find(uuids.begin(), uuids.end(), wanted) != uuids.end())
+        {
+          matched++;
+          break;
+        }
+      }
+    }
+    return matched;
+  });
+
+  std::vector<std::vector<Uuid>> parsed;
+  run(reporter, "uuid/parse", 1, [&]() {
+    parsed.clear();
+    for (const auto& uuids : advertised)
+    {
+      parsed.push_back(parseUuids(uuids));
+    }
+    return parsed.size();
+  });
+
+  auto filter = parseUuids(FILTER);
+  run(reporter, "uuid/matchesAny", PASSES, [&]() {
+    size_t matched = 0;
+    for (const auto& uuids : parsed)
+    {
+      matched += matchesAny(uuids, filter);
+    }
+    return matched;
+  });
+
+  DeviceRegistry registry(DEVICES);
+  for (size_t i = 0; i < DEVICES; i++)
+  {
+    PropertyMap props{{"UUIDs", sdbus::Variant(advertised[i])}};
+    registry.upsert("/org/bluez/hci0/dev_" + formatMac(i, '_'), props);
+  }
+  run(reporter, "uuid/registrySnapshot", PASSES, [&]() {
+    return registry.snapshot(filter).size();
+  });
+}
+
+Registrar registrar("uuid", benchUuid);
+}  // namespace
+}  // namespace boot_module::bench
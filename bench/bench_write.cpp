@@ -0,0 +1,212 @@
+// Bulk write throughput: one WriteValue method call per MTU-sized chunk (what
+// writeCharacteristic does), pipelined WriteValue batches at several window
+// sizes, and a CharacteristicWriter streaming into the AcquireWrite socket,
+// plus the writer alone against a socketpair to show the ceiling without a
+// service on the other end.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#include "bench.hpp"
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/bluez_constants.hpp"
+#include "private_bus.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t UPLOAD_SIZE = 256 * 1024;
+
+void recordThroughput(Reporter&         reporter,
+                      const char*       name,
+                      uint16_t          mtu,
+                      size_t            packets,
+                      Clock::time_point start,
+                      bool              complete)
+{
+  double seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+
+  BenchResult result{name, {{"bytes", UPLOAD_SIZE}, {"mtu", mtu}}, {}};
+  result.metrics["complete"]       = complete ? 1 : 0;
+  result.metrics["seconds"]        = seconds;
+  result.metrics["writes_per_sec"] = packets / seconds;
+  result.metrics["kbytes_per_sec"] = UPLOAD_SIZE / 1024.0 / seconds;
+  reporter.record(std::move(result));
+}
+
+bool waitForBytes(StubEnvironment& env, uint64_t bytes)
+{
+  auto deadline = Clock::now() + std::chrono::seconds(60);
+  while (env.bluez().writes(0, 0, 0).bytes < bytes)
+  {
+    if (Clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return true;
+}
+
+void benchWriteValue(Reporter& reporter, const std::vector<uint8_t>& upload)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  auto connection = env.connect();
+  auto proxy      = sdbus::createProxy(
+    *connection,
+    sdbus::ServiceName(BLUEZ_SERVICE),
+    sdbus::ObjectPath(env.bluez().characteristicPath(0, 0, 0)));
+  size_t chunk = config.mtu - CharacteristicWriter::ATT_WRITE_HEADER;
+
+  std::map<std::string, sdbus::Variant> options;
+  size_t                                packets = 0;
+  auto                                  start   = Clock::now();
+  for (size_t offset = 0; offset < upload.size(); offset += chunk)
+  {
+    auto first = upload.begin() + offset;
+    auto last  = upload.begin() + std::min(upload.size(), offset + chunk);
+    proxy->callMethod("WriteValue")
+      .onInterface(GATT_CHAR_INTERFACE)
+      .withArguments(std::vector<uint8_t>(first, last), options);
+    packets++;
+  }
+
+  recordThroughput(reporter,
+                   "write/writeValue",
+                   config.mtu,
+                   packets,
+                   start,
+                   waitForBytes(env, upload.size()));
+}
+
+void benchPipelined(Reporter&                   reporter,
+                    const std::vector<uint8_t>& upload,
+                    WriteType                   type,
+                    size_t                      window)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  manager.startEventLoop();
+  // Connected so the chunks are sized from the device's MTU
+  QuietStdout quiet;
+  manager.connectDevice(env.bluez().deviceAddress(0));
+  auto stats = manager.writeCharacteristicChunked(
+    env.bluez().characteristicPath(0, 0, 0), upload, 0, type, window);
+  manager.stopEventLoop();
+
+  double      seconds = stats.elapsed.count() / 1e6;
+  BenchResult result{
+    type == WriteType::Command ? "write/pipelinedCommand"
+                               : "write/pipelinedRequest",
+    {{"bytes", UPLOAD_SIZE}, {"mtu", config.mtu}, {"window", window}},
+    {}};
+  result.metrics["complete"]       = stats.ok() ? 1 : 0;
+  result.metrics["seconds"]        = seconds;
+  result.metrics["writes_per_sec"] = stats.written / seconds;
+  result.metrics["kbytes_per_sec"] = stats.bytesPerSecond() / 1024.0;
+  reporter.record(std::move(result));
+}
+
+void benchAcquireWrite(Reporter& reporter, const std::vector<uint8_t>& upload)
+{
+  stub::StubBluezConfig config;
+  config.devices = 1;
+  StubEnvironment env(config);
+
+  BluetoothManager manager(env.connect());
+  auto writer = manager.acquireWriter(env.bluez().characteristicPath(0, 0, 0));
+  if (!writer)
+  {
+    return;
+  }
+
+  auto start = Clock::now();
+  bool sent  = writer->streamAll(upload.data(), upload.size());
+  bool done  = sent && waitForBytes(env, upload.size());
+
+  recordThroughput(reporter,
+                   "write/acquireWrite",
+                   config.mtu,
+                   writer->stats().packets,
+                   start,
+                   done);
+}
+
+void benchSocketpair(Reporter& reporter, const std::vector<uint8_t>& upload)
+{
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0)
+  {
+    return;
+  }
+
+  const uint16_t       mtu = stub::StubBluezConfig{}.mtu;
+  CharacteristicWriter writer(fds[1], mtu);
+
+  std::atomic<size_t> received{0};
+  std::thread         device([&]() {
+    std::vector<uint8_t> buffer(mtu);
+    ssize_t              bytes;
+    while ((bytes = recv(fds[0], buffer.data(), buffer.size(), 0)) > 0)
+    {
+      received += static_cast<size_t>(bytes);
+    }
+  });
+
+  auto start = Clock::now();
+  bool sent  = writer.streamAll(upload.data(), upload.size());
+  while (sent && received < upload.size())
+  {
+    std::this_thread::yield();
+  }
+  recordThroughput(reporter,
+                   "write/socketpair",
+                   mtu,
+                   writer.stats().packets,
+                   start,
+                   sent);
+
+  BenchResult pressure{"write/socketpair_backpressure", {}, {}};
+  pressure.metrics["would_block"] =
+    static_cast<double>(writer.stats().wouldBlock);
+  reporter.record(std::move(pressure));
+
+  writer.close();
+  device.join();
+  ::close(fds[0]);
+}
+
+void benchWrite(Reporter& reporter)
+{
+  std::vector<uint8_t> upload(UPLOAD_SIZE);
+  for (size_t i = 0; i < upload.size(); i++)
+  {
+    upload[i] = static_cast<uint8_t>(i);
+  }
+
+  benchWriteValue(reporter, upload);
+  for (size_t window : {1, 8, 32})
+  {
+    benchPipelined(reporter, upload, WriteType::Request, window);
+    benchPipelined(reporter, upload, WriteType::Command, window);
+  }
+  benchAcquireWrite(reporter, upload);
+  benchSocketpair(reporter, upload);
+}
+
+Registrar registrar("write", benchWrite);
+}  // namespace
+}  // namespace boot_module::bench
@@ -0,0 +1,147 @@
+#include "private_bus.hpp"
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "boot_module/bluez_constants.hpp"
+
+namespace boot_module::bench
+{
+namespace
+{
+const char* daemonBinary()
+{
+  const char* binary = std::getenv("BSCM_DBUS_DAEMON");
+  return binary ? binary : "dbus-daemon";
+}
+
+void writeConfig(const std::string& configPath, const std::string& socketPath)
+{
+  // Session-style bus with everything allowed and limits raised far enough
+  // for large object trees and many in-flight calls
+  std::ofstream config(configPath);
+  config << "<!DOCTYPE busconfig PUBLIC "
+            "\"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\" "
+            "\"http://www.freedesktop.org/standards/dbus/1.0/"
+            "busconfig.dtd\">\n"
+         << "<busconfig>\n"
+         << "  <type>session</type>\n"
+         << "  <listen>unix:path=" << socketPath << "</listen>\n"
+         << "  <auth>EXTERNAL</auth>\n"
+         << "  <policy context=\"default\">\n"
+         << "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+         << "    <allow eavesdrop=\"true\"/>\n"
+         << "    <allow own=\"*\"/>\n"
+         << "  </policy>\n"
+         << "  <limit name=\"max_incoming_bytes\">1000000000</limit>\n"
+         << "  <limit name=\"max_outgoing_bytes\">1000000000</limit>\n"
+         << "  <limit name=\"max_message_size\">1000000000</limit>\n"
+         << "  <limit name=\"max_replies_per_connection\">50000</limit>\n"
+         << "  <limit name=\"max_match_rules_per_connection\">50000</limit>\n"
+         << "</busconfig>\n";
+}
+}  // namespace
+
+PrivateBus::PrivateBus()
+{
+  char directory[] = "/tmp/bscm-bus-XXXXXX";
+  if (!mkdtemp(directory))
+  {
+    throw std::runtime_error("Failed to create private bus directory");
+  }
+  m_directory = directory;
+
+  std::string socketPath = m_directory + "/bus";
+  std::string configPath = m_directory + "/bus.conf";
+  writeConfig(configPath, socketPath);
+  m_address = "unix:path=" + socketPath;
+
+  std::string configArg = "--config-file=" + configPath;
+  m_pid                 = fork();
+  if (m_pid < 0)
+  {
+    shutdown();
+    throw std::runtime_error("Failed to fork dbus-daemon");
+  }
+  if (m_pid == 0)
+  {
+    execlp(daemonBinary(),
+           daemonBinary(),
+           configArg.c_str(),
+           "--nofork",
+           "--nopidfile",
+           static_cast<char*>(nullptr));
+    _exit(127);
+  }
+
+  // The daemon is ready once its socket exists
+  struct stat st;
+  for (int i = 0; i < 500; i++)
+  {
+    if (stat(socketPath.c_str(), &st) == 0)
+    {
+      return;
+    }
+    int status = 0;
+    if (waitpid(m_pid, &status, WNOHANG) == m_pid)
+    {
+      m_pid = -1;
+      shutdown();
+      throw std::runtime_error("dbus-daemon exited during startup");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  shutdown();
+  throw std::runtime_error("Timed out waiting for dbus-daemon");
+}
+
+PrivateBus::~PrivateBus()
+{
+  shutdown();
+}
+
+void PrivateBus::shutdown()
+{
+  if (m_pid > 0)
+  {
+    kill(m_pid, SIGTERM);
+    waitpid(m_pid, nullptr, 0);
+    m_pid = -1;
+  }
+  if (!m_directory.empty())
+  {
+    unlink((m_directory + "/bus").c_str());
+    unlink((m_directory + "/bus.conf").c_str());
+    rmdir(m_directory.c_str());
+    m_directory.clear();
+  }
+}
+
+std::unique_ptr<sdbus::IConnection> PrivateBus::connect() const
+{
+  return sdbus::createSessionBusConnectionWithAddress(m_address);
+}
+
+StubEnvironment::StubEnvironment(stub::StubBluezConfig config)
+{
+  m_serviceConnection = m_bus.connect();
+  m_bluez =
+    std::make_unique<stub::StubBluez>(*m_serviceConnection, std::move(config));
+  m_serviceConnection->requestName(sdbus::ServiceName{BLUEZ_SERVICE});
+  m_serviceConnection->enterEventLoopAsync();
+}
+
+StubEnvironment::~StubEnvironment()
+{
+  m_serviceConnection->leaveEventLoop();
+}
+}  // namespace boot_module::bench
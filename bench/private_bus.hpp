@@ -0,0 +1,62 @@
+#ifndef PRIVATE_BUS_H
+#define PRIVATE_BUS_H
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <sys/types.h>
+#include <memory>
+#include <string>
+
+#include "stub_bluez/stub_bluez.hpp"
+
+namespace boot_module::bench
+{
+// A throwaway dbus-daemon listening on a socket in a temporary directory.
+// Nothing outside the benchmark can see it, so no Bluetooth hardware or
+// system bus access is needed.
+class PrivateBus
+{
+public:
+  PrivateBus();
+  ~PrivateBus();
+
+  PrivateBus(const PrivateBus&)            = delete;
+  PrivateBus& operator=(const PrivateBus&) = delete;
+
+  const std::string&                  address() const { return m_address; }
+  std::unique_ptr<sdbus::IConnection> connect() const;
+
+private:
+  std::string m_directory;
+  std::string m_address;
+  pid_t       m_pid = -1;
+
+  // Stop the daemon and remove the directory, whichever exist; also used
+  // by the constructor before it throws, when the destructor will not run
+  void shutdown();
+};
+
+// Private bus plus a stand-in org.bluez service serving it from its own
+// event loop thread
+class StubEnvironment
+{
+public:
+  explicit StubEnvironment(stub::StubBluezConfig config);
+  ~StubEnvironment();
+
+  PrivateBus&      bus() { return m_bus; }
+  stub::StubBluez& bluez() { return *m_bluez; }
+
+  // New client connection on the private bus
+  std::unique_ptr<sdbus::IConnection> connect() const
+  {
+    return m_bus.connect();
+  }
+
+private:
+  PrivateBus                          m_bus;
+  std::unique_ptr<sdbus::IConnection> m_serviceConnection;
+  std::unique_ptr<stub::StubBluez>    m_bluez;
+};
+}  // namespace boot_module::bench
+
+#endif  // PRIVATE_BUS_H
@@ -0,0 +1,136 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/connection_manager.hpp"
+
+namespace boot_module
+{
+// One line of a batch script:
+//
+//   scan [SECONDS [UUID...]]       discover for SECONDS (default 5), for
+//                                  devices advertising any of the UUIDs
+//   connect ADDRESS [SECONDS]      connect, resolving services
+//   disconnect ADDRESS
+//   read ADDRESS CHAR
+//   write ADDRESS CHAR HEX [request|command]
+//   subscribe ADDRESS CHAR         report notifications until unsubscribed
+//   unsubscribe ADDRESS CHAR
+//   wait SECONDS                   let everything above finish, then sleep
+//
+// CHAR is a characteristic UUID, looked up among the device's services, or
+// an object path. '#' starts a comment; newlines or ';' separate commands.
+struct BatchCommand
+{
+  enum class Kind
+  {
+    Scan,
+    Connect,
+    Disconnect,
+    Read,
+    Write,
+    Subscribe,
+    Unsubscribe,
+    Wait
+  };
+
+  Kind                      kind = Kind::Wait;
+  // 1-based position in the script
+  size_t                    index = 0;
+  std::string               text;
+  std::string               device;
+  std::string               characteristic;
+  std::vector<uint8_t>      value;
+  WriteType                 writeType = WriteType::Request;
+  std::vector<Uuid>         services;
+  std::chrono::milliseconds duration{0};
+
+  // scan and wait order everything around them; the rest only order
+  // against commands for the same device
+  bool isBarrier() const { return kind == Kind::Scan || kind == Kind::Wait; }
+};
+
+const char* toString(BatchCommand::Kind kind);
+
+// Parse a whole script; on a malformed command returns false with error
+// naming it
+bool parseBatchScript(const std::string&         script,
+                      std::vector<BatchCommand>& commands,
+                      std::string&               error);
+
+// Runs a batch script against a BluetoothManager without any prompts.
+//
+// The script is cut into stages at every scan and wait. Within a stage the
+// commands for each device run in script order, while different devices
+// run concurrently, up to `jobs` at a time. Once a command fails, later
+// commands for that device are skipped. Every command reports one JSON
+// object per line on out, as does every notification of a subscription
+// and a final summary, so the output can be consumed while it is written.
+// The manager's event loop must be running.
+class BatchRunner
+{
+public:
+  static constexpr size_t DEFAULT_JOBS =
+    ConnectionManager::DEFAULT_PARALLELISM;
+
+  BatchRunner(BluetoothManager& manager,
+              std::ostream&     out,
+              size_t            jobs = DEFAULT_JOBS);
+
+  BatchRunner(const BatchRunner&)            = delete;
+  BatchRunner& operator=(const BatchRunner&) = delete;
+
+  // True if every command succeeded. Subscriptions still active at the end
+  // are disabled.
+  bool run(const std::vector<BatchCommand>& commands);
+
+private:
+  using Lane = std::vector<const BatchCommand*>;
+
+  BluetoothManager&                     m_manager;
+  std::ostream&                         m_out;
+  size_t                                m_jobs;
+  std::chrono::steady_clock::time_point m_start;
+
+  std::mutex m_outputMutex;
+  // Failed devices, resolved characteristic paths (device, then CHAR as
+  // written) and active subscriptions, shared by the lanes
+  std::mutex                                                m_stateMutex;
+  std::set<std::string>                                     m_failedDevices;
+  std::map<std::string, std::map<std::string, std::string>> m_paths;
+  std::set<std::string>                                     m_subscriptions;
+
+  std::atomic<size_t> m_succeeded{0};
+  std::atomic<size_t> m_failed{0};
+  std::atomic<size_t> m_skipped{0};
+  std::atomic<size_t> m_notifications{0};
+
+  void runStage(const std::vector<const BatchCommand*>& stage);
+  void runLane(const Lane& lane);
+  void runBarrier(const BatchCommand& command);
+  // Returns false if the command failed
+  bool execute(const BatchCommand& command, std::string& fields);
+  bool resolve(const std::string& device,
+               const std::string& characteristic,
+               std::string&       path);
+  void report(const BatchCommand& command,
+              const char*         status,
+              double              took,
+              const std::string&  fields);
+  void emit(const std::string& line);
+  double elapsedMs() const;
+};
+}  // namespace boot_module
+
+#endif  // BATCH_RUNNER_H
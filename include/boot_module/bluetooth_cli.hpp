@@ -21,11 +21,17 @@ private:
   std::vector<CharacteristicInfo>   m_cachedCharacteristics;
   std::string                       m_currentServicePath;
   std::atomic<bool>                 m_notifyActive{false};
+  // Image and offset of the last interrupted upload
+  std::string                       m_resumeImage;
+  size_t                            m_resumeOffset = 0;
 
   void printMainMenu();
 
   int getChoice();
 
+  // Prompt for a number; -1 if the input is not one
+  int getNumber(const std::string& prompt);
+
   std::string getInput(const std::string& prompt);
 
   void scanDevices();
@@ -34,6 +40,8 @@ private:
 
   void connectToDevice();
 
+  void connectMultipleDevices();
+
   void disconnectFromDevice();
 
   void forgetDevice();
@@ -49,5 +57,15 @@ private:
   void enableNotifications();
 
   void disableNotifications();
+
+  void showStatistics();
+
+  void writeTrace();
+
+  void captureNotifications();
+
+  void uploadFirmware();
+
+  void flashFleet();
 };
 }  // namespace boot_module
@@ -2,54 +2,159 @@
 #define BLUETOOTH_MANAGER_H
 
 #include <sdbus-c++/sdbus-c++.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "boot_module/capture_log.hpp"
+#include "boot_module/characteristic_writer.hpp"
+#include "boot_module/device_registry.hpp"
+#include "boot_module/gatt_index.hpp"
+#include "boot_module/metrics.hpp"
+#include "boot_module/notification_pool.hpp"
+#include "boot_module/notification_ring.hpp"
+#include "boot_module/notify_socket_reader.hpp"
+#include "boot_module/object_tree.hpp"
+#include "boot_module/proxy_pool.hpp"
+
 namespace boot_module
 {
-struct DeviceInfo
+enum class DiscoveryEvent
 {
-  std::string              address;
-  std::string              name;
-  std::string              alias;
-  bool                     paired;
-  bool                     connected;
-  bool                     trusted;
-  std::vector<std::string> uuids;
-  int16_t                  rssi = 0;
+  // First time the device is seen during this discovery, either added by
+  // BlueZ or heard advertising
+  Found,
+  // A later advertisement refreshed its RSSI, manufacturer data or services
+  Updated
 };
 
-struct CharacteristicInfo
+// Why discover() returned
+enum class DiscoveryStop
 {
-  std::string              path;
-  std::string              uuid;
-  std::vector<std::string> flags;
+  Timeout,
+  DeviceCount,
+  TargetFound,
+  Predicate,
+  Error
 };
 
-struct ServiceInfo
+const char* toString(DiscoveryStop reason);
+
+// What to look for and when to stop; discovery ends on whichever stop
+// condition is met first
+struct DiscoveryOptions
 {
-  std::string                     path;
-  std::string                     uuid;
-  std::vector<CharacteristicInfo> characteristics;
+  // Passed to SetDiscoveryFilter; devices advertising none of them are not
+  // reported
+  std::vector<Uuid>                      services;
+  std::chrono::milliseconds              timeout{5000};
+  // Stop once this many distinct devices were seen; 0 for no limit
+  size_t                                 maxDevices = 0;
+  // Stop as soon as this address is seen, given in either case; a malformed
+  // one ends discovery at once with DiscoveryStop::Error
+  std::string                            targetAddress;
+  // Stop when this returns true for a reported device
+  std::function<bool(const DeviceInfo&)> stopWhen;
+};
+
+struct DiscoveryResult
+{
+  // Devices seen during this discovery, in the order they were first seen
+  std::vector<DeviceInfo>   devices;
+  DiscoveryStop             reason = DiscoveryStop::Timeout;
+  std::chrono::microseconds elapsed{0};
+};
+
+enum class NotifyMode
+{
+  // PropertiesChanged signals relayed by dbus-daemon (StartNotify)
+  Signal,
+  // Datagrams read straight from the socket returned by AcquireNotify
+  AcquireFd,
+  // AcquireFd when the characteristic supports it, Signal otherwise
+  Auto
+};
+
+enum class WriteType
+{
+  // Command when the characteristic allows write-without-response
+  Auto,
+  // ATT write request, acknowledged by the device
+  Request,
+  // ATT write command, no acknowledgement
+  Command
+};
+
+// Outcome of a pipelined batch write
+struct BatchWriteStats
+{
+  WriteType                 type      = WriteType::Request;  // as resolved
+  size_t                    requested = 0;
+  size_t                    written   = 0;
+  size_t                    failed    = 0;
+  size_t                    bytes     = 0;
+  size_t                    window    = 0;
+  std::chrono::microseconds elapsed{0};
+
+  bool   ok() const { return written == requested; }
+  double bytesPerSecond() const
+  {
+    return elapsed.count() > 0 ? bytes * 1e6 / elapsed.count() : 0.0;
+  }
 };
 
 class BluetoothManager
 {
 public:
+  using ResultCallback   = std::function<void(bool)>;
+  using ValueCallback    = std::function<void(std::vector<uint8_t>)>;
+  using ServicesCallback = std::function<void(std::vector<ServiceInfo>)>;
+  using BufferCallback   = std::function<void(PooledBuffer)>;
+  using DiscoveryCallback =
+    std::function<void(const DeviceInfo& device, DiscoveryEvent event)>;
+
+  static constexpr std::chrono::milliseconds DEFAULT_CONNECT_TIMEOUT{10000};
+  // WriteValue calls kept in flight by the batch writers
+  static constexpr size_t DEFAULT_WRITE_WINDOW = 8;
+
   BluetoothManager();
+  // Use an existing bus connection, e.g. a private bus hosting a stand-in
+  // org.bluez service
+  explicit BluetoothManager(std::unique_ptr<sdbus::IConnection> connection);
   ~BluetoothManager();
 
   // Device scanning and discovery
-  void                    startDiscovery(const std::string& serviceUUID = "");
+  // UUIDs may be given in full or as 16/32-bit short forms
+  bool                    startDiscovery(const std::string& serviceUUID = "");
+  bool                    startDiscovery(const std::vector<Uuid>& services);
   void                    stopDiscovery();
   std::vector<DeviceInfo> getDevices(const std::string& filterServiceUUID = "");
+  // Devices advertising any of services, or all devices if it is empty
+  std::vector<DeviceInfo> getDevices(const std::vector<Uuid>& services);
+  // Known devices by address, kept current from the object tree
+  const DeviceRegistry&   devices() const { return *m_devices; }
+  // Run discovery until a stop condition in options is met, reporting every
+  // device that appears or advertises in the meantime to onDevice, on the
+  // thread dispatching events. Devices BlueZ already knew about count once
+  // they are heard advertising.
+  DiscoveryResult discover(const DiscoveryOptions& options,
+                           DiscoveryCallback       onDevice = nullptr);
 
   // Device operations
   std::string getDevicePath(const std::string& address);
-  bool        connectDevice(const std::string& address);
+  // Returns once the device is connected and its GATT services resolved
+  bool        connectDevice(
+           const std::string&        address,
+           std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
   bool        disconnectDevice(const std::string& address);
   bool        removeDevice(const std::string& address);
   void        cleanupDevice(const std::string& devicePath);
@@ -57,47 +162,264 @@ public:
            const std::string&                      devicePath,
            std::function<void(const std::string&)> onDisconnect);
 
-  // MTU operations
-  bool requestMTU(const std::string& deviceAddress, uint16_t mtu);
+  // MTU operations. BlueZ exchanges the MTU on its own once connected, up
+  // to the ExchangeMTU of its main.conf; a client cannot ask for a size.
+  // These report the outcome, taken from the MTU property of the device's
+  // characteristics (BlueZ 5.62 on), their PropertiesChanged signals or
+  // AcquireWrite / AcquireNotify, and cached per device until it
+  // disconnects.
+  //
+  // 0 if not known, e.g. not connected or an older BlueZ
+  uint16_t getMtu(const std::string& deviceAddress);
+  // Largest value one write to characteristic can carry: its device's MTU
+  // less the ATT header, or DEFAULT_WRITE_PAYLOAD while that is unknown
+  size_t   maxWritePayload(GattHandle characteristic);
+  size_t   maxWritePayload(const std::string& characteristicPath);
 
   // GATT operations
   std::vector<ServiceInfo>        getServices(const std::string& deviceAddress);
   std::vector<CharacteristicInfo> getCharacteristics(
     const std::string& servicePath);
+  std::vector<CharacteristicInfo> getCharacteristics(GattHandle service);
+  // Handle of a characteristic path, as also found in CharacteristicInfo;
+  // invalid if BlueZ never announced it. The handle overloads below skip
+  // resolving the path on every call.
+  GattHandle       characteristicHandle(const std::string& characteristicPath);
+  // Services and characteristics of every device, kept current from the
+  // object tree
+  const GattIndex& gatt() const { return *m_gatt; }
 
   // Characteristic operations
   bool enableNotifications(
     const std::string&                               characteristicPath,
-    std::function<void(const std::vector<uint8_t>&)> callback);
+    std::function<void(const std::vector<uint8_t>&)> callback,
+    NotifyMode                                       mode = NotifyMode::Signal);
+  bool enableNotifications(
+    GattHandle                                       characteristic,
+    std::function<void(const std::vector<uint8_t>&)> callback,
+    NotifyMode                                       mode = NotifyMode::Signal);
+  // Opt-in buffered delivery: notifications are copied into a preallocated
+  // lock-free ring and consumer runs on a dedicated thread, so a slow
+  // consumer cannot stall the thread that receives notifications
+  bool enableRingNotifications(
+    const std::string&       characteristicPath,
+    RingDispatcher::Consumer consumer,
+    const RingOptions&       options = RingOptions{},
+    NotifyMode               mode    = NotifyMode::Signal);
+  // Drop, high-water and delivery counters of a ring subscription
+  RingStats ringStats(const std::string& characteristicPath) const;
+  // Allocation-free delivery: each Value is decoded straight from the
+  // signal into a buffer from a per-subscription pool of poolSize buffers.
+  // The consumer owns the buffer until it destroys or releases it, and may
+  // hand it to another thread; the pool only allocates while all of its
+  // buffers are out. Notification signals only, no AcquireNotify.
+  bool enablePooledNotifications(
+    const std::string& characteristicPath,
+    BufferCallback     consumer,
+    size_t             poolSize = BufferPool::DEFAULT_BUFFERS);
+  PoolStats notificationPoolStats(const std::string& characteristicPath) const;
+  // Record every notification into log, timestamped on arrival and tagged
+  // with the characteristic's handle id. The log may be shared by many
+  // characteristics; disableNotifications ends the capture.
+  bool captureNotifications(
+    const std::string&          characteristicPath,
+    std::shared_ptr<CaptureLog> log,
+    NotifyMode                  mode = NotifyMode::Auto);
   bool disableNotifications(const std::string& characteristicPath);
+  bool disableNotifications(GattHandle characteristic);
   bool writeCharacteristic(const std::string&          characteristicPath,
                            const std::vector<uint8_t>& data);
+  bool writeCharacteristic(GattHandle                  characteristic,
+                           const std::vector<uint8_t>& data);
+  // Write each value in order with up to window WriteValue calls in flight.
+  // Stops issuing writes after the first failure.
+  BatchWriteStats writeCharacteristicBatch(
+    const std::string&                       characteristicPath,
+    const std::vector<std::vector<uint8_t>>& values,
+    WriteType                                type   = WriteType::Auto,
+    size_t                                   window = DEFAULT_WRITE_WINDOW);
+  // Same, splitting data into chunkSize pieces; 0 for the largest the
+  // MTU allows
+  BatchWriteStats writeCharacteristicChunked(
+    const std::string&          characteristicPath,
+    const std::vector<uint8_t>& data,
+    size_t                      chunkSize = 0,
+    WriteType                   type      = WriteType::Auto,
+    size_t                      window    = DEFAULT_WRITE_WINDOW);
   std::vector<uint8_t> readCharacteristic(
     const std::string& characteristicPath);
+  std::vector<uint8_t> readCharacteristic(GattHandle characteristic);
+  // Streaming write-without-response channel from AcquireWrite; nullptr if
+  // BlueZ refuses it (no write-without-response, or already acquired)
+  std::unique_ptr<CharacteristicWriter> acquireWriter(
+    const std::string& characteristicPath);
+
+  // Asynchronous variants. Each returns as soon as the request is sent and
+  // completes with what the blocking call would have returned (false or
+  // empty on failure), so many operations can be in flight across
+  // characteristics and devices. Completions run on the event loop thread;
+  // with the loop stopped they run inside processEvents(), which the caller
+  // must then pump. A failure detected up front completes immediately, on
+  // the calling thread. While the loop runs, a connect or services timeout
+  // that no bus traffic reveals completes on the manager's timer thread.
+  void connectDeviceAsync(
+    const std::string&        address,
+    ResultCallback            done,
+    std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
+  std::future<bool> connectDeviceAsync(
+    const std::string&        address,
+    std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
+  // Completes once the device's services are resolved
+  void getServicesAsync(
+    const std::string&        deviceAddress,
+    ServicesCallback          done,
+    std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
+  std::future<std::vector<ServiceInfo>> getServicesAsync(
+    const std::string&        deviceAddress,
+    std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
+  void readCharacteristicAsync(const std::string& characteristicPath,
+                               ValueCallback      done);
+  void readCharacteristicAsync(GattHandle characteristic, ValueCallback done);
+  std::future<std::vector<uint8_t>> readCharacteristicAsync(
+    const std::string& characteristicPath);
+  void writeCharacteristicAsync(
+    const std::string&          characteristicPath,
+    const std::vector<uint8_t>& data,
+    ResultCallback              done,
+    WriteType                   type = WriteType::Request);
+  void writeCharacteristicAsync(
+    GattHandle                  characteristic,
+    const std::vector<uint8_t>& data,
+    ResultCallback              done,
+    WriteType                   type = WriteType::Request);
+  std::future<bool> writeCharacteristicAsync(
+    const std::string&          characteristicPath,
+    const std::vector<uint8_t>& data,
+    WriteType                   type = WriteType::Request);
+
+  // Event dispatching. With the event loop running, signals and
+  // notification callbacks are delivered on its thread as soon as they
+  // arrive; otherwise the caller must pump processEvents().
+  void startEventLoop();
+  void stopEventLoop();
+  bool isEventLoopRunning() const;
+  // Dispatch everything pending, waiting up to timeoutMs for the first event
+  void processEvents(int timeoutMs = 100);
 
   // Utility
-  std::string getAdapterPath();
-  void        processEvents(int timeoutMs = 100);
+  std::string     getAdapterPath();
+  ProxyPoolStats  proxyPoolStats() const;
+  // Latency histograms of the D-Bus calls made so far, one per operation,
+  // and notification counts per subscribed characteristic
+  MetricsSnapshot metricsSnapshot() const;
 
 private:
-  std::unique_ptr<sdbus::IConnection>                   m_connection;
-  std::string                                           m_adapterPath;
-  std::map<std::string, std::unique_ptr<sdbus::IProxy>> m_deviceProxies;
-  std::map<std::string, std::function<void(const std::vector<uint8_t>&)>>
-    m_notifyCallbacks;
-  std::map<std::string, std::unique_ptr<sdbus::IProxy>>
-    m_deviceDisconnectProxies;
+  using ProxyMap = std::map<std::string, std::unique_ptr<sdbus::IProxy>>;
+  // Per-characteristic subscription state
+  template <typename T>
+  using HandleMap         = std::unordered_map<GattHandle, T>;
+  using NotifyProxyMap    = HandleMap<std::unique_ptr<sdbus::IProxy>>;
+  using RingDispatcherMap = HandleMap<std::shared_ptr<RingDispatcher>>;
+  struct ReadyWaiter
+  {
+    std::string                           devicePath;
+    std::chrono::steady_clock::time_point deadline;
+    ResultCallback                        done;
+  };
+  using NotifyCallback    = std::function<void(const std::vector<uint8_t>&)>;
+  using NotifyCallbackMap = HandleMap<NotifyCallback>;
+  using BufferPoolMap     = HandleMap<std::shared_ptr<BufferPool>>;
+
+  std::unique_ptr<sdbus::IConnection> m_connection;
+  // Shared with reply handlers, which may outlive the manager
+  std::shared_ptr<Metrics>            m_metrics;
+  std::unique_ptr<ObjectTree>         m_objectTree;
+  std::unique_ptr<ProxyPool>          m_proxyPool;
+  std::unique_ptr<DeviceRegistry>     m_devices;
+  std::unique_ptr<GattIndex>          m_gatt;
+  ObjectTree::ListenerId              m_treeListener = 0;
+  std::string                         m_adapterPath;
+  // Signal subscription proxies
+  NotifyProxyMap                      m_notifyProxies;
+  NotifyCallbackMap                   m_notifyCallbacks;
+  ProxyMap                            m_deviceDisconnectProxies;
+  // AcquireNotify sockets
+  HandleMap<int>                      m_notifyFds;
+  RingDispatcherMap                   m_ringDispatchers;
+  // Buffer pools of signal subscriptions, for their stats
+  BufferPoolMap                       m_notifyPools;
+  mutable std::mutex                  m_subscriptionMutex;
+  std::unique_ptr<NotifySocketReader> m_notifyReader;
+  std::atomic<bool>                   m_eventLoopRunning{false};
+  std::mutex                          m_waitMutex;
+  std::condition_variable             m_waitCondition;
+  // Async operations waiting for a device to become ready
+  std::mutex                          m_readyMutex;
+  std::vector<ReadyWaiter>            m_readyWaiters;
+  // Expires ready waiters whose deadline passes with no signal arriving
+  std::condition_variable             m_readyCondition;
+  bool                                m_readyTimerStop = false;
+  std::thread                         m_readyTimer;
+  // Negotiated ATT MTU by device handle, dropped on disconnect
+  std::mutex                          m_mtuMutex;
+  HandleMap<uint16_t>                 m_mtus;
+  // PropertiesChanged of every characteristic, for MTU changes
+  sdbus::Slot                         m_mtuSlot;
 
   std::string                           findAdapter();
+  // Called from the first tree listener, so later ones see current data;
+  // the GATT index is updated alongside
+  void updateDeviceRegistry(ObjectTree::Change change,
+                            const std::string& path,
+                            const PropertyMap& props);
   std::map<std::string, sdbus::Variant> getProperties(
     const std::string& objectPath,
     const std::string& interface);
+  // As above, but tells a failed call from an interface with no properties
+  bool getProperties(const std::string&                     objectPath,
+                     const std::string&                     interface,
+                     std::map<std::string, sdbus::Variant>& properties);
   void                     setProperty(const std::string&    objectPath,
                                        const std::string&    interface,
                                        const std::string&    property,
                                        const sdbus::Variant& value);
-  std::vector<std::string> getManagedObjects(const std::string& basePath);
+  void                     dispatchPendingEvents();
+  void                     waitForBusActivity(int timeoutMs);
+  void                     notifyWaiters();
+  bool waitUntil(const std::function<bool()>&          predicate,
+                 std::chrono::steady_clock::time_point deadline);
+  bool isDeviceReady(const std::string& devicePath) const;
+  // Call done(true) once devicePath is connected with services resolved, or
+  // done(false) once the deadline passes
+  void whenDeviceReady(const std::string&                    devicePath,
+                       std::chrono::steady_clock::time_point deadline,
+                       ResultCallback                        done);
+  void checkReadyWaiters(bool failAll = false);
+  // Timer thread: sleeps until the earliest waiter deadline and sweeps the
+  // waiters while the event loop runs; processEvents() sweeps otherwise
+  void runReadyTimer();
+  void wakeReadyTimer();
+  std::vector<ServiceInfo> collectServices(const std::string& devicePath) const;
+  void onCharacteristicChanged(sdbus::Message& message);
+  // Cache mtu for the device of a characteristic; 0 is ignored
+  void     noteMtu(GattHandle characteristic, uint16_t mtu);
+  uint16_t deviceMtu(GattHandle device);
+  static std::map<std::string, sdbus::Variant> writeOptions(WriteType type);
+  WriteType resolveWriteType(GattHandle characteristic, WriteType type);
+  BatchWriteStats writePipelined(
+    GattHandle                                         characteristic,
+    size_t                                             count,
+    const std::function<std::vector<uint8_t>(size_t)>& valueAt,
+    WriteType                                          type,
+    size_t                                             window);
+  bool enableFdNotifications(GattHandle     characteristic,
+                             NotifyCallback callback);
+  // StartNotify and route each Value through pool to deliver
+  bool subscribeValueSignal(GattHandle                  characteristic,
+                            std::shared_ptr<BufferPool> pool,
+                            BufferCallback              deliver);
 };
 
+}  // namespace boot_module
+
 #endif  // BLUETOOTH_MANAGER_H
-} // namespace boot_module
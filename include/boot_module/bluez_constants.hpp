@@ -0,0 +1,21 @@
+#ifndef BLUEZ_CONSTANTS_H
+#define BLUEZ_CONSTANTS_H
+
+#include <string>
+
+namespace boot_module
+{
+// BlueZ D-Bus constants
+inline const std::string BLUEZ_SERVICE          = "org.bluez";
+inline const std::string BLUEZ_ROOT_PATH        = "/org/bluez";
+inline const std::string ADAPTER_INTERFACE      = "org.bluez.Adapter1";
+inline const std::string DEVICE_INTERFACE       = "org.bluez.Device1";
+inline const std::string GATT_SERVICE_INTERFACE = "org.bluez.GattService1";
+inline const std::string GATT_CHAR_INTERFACE = "org.bluez.GattCharacteristic1";
+inline const std::string PROPERTIES_INTERFACE =
+  "org.freedesktop.DBus.Properties";
+inline const std::string OBJECT_MANAGER_INTERFACE =
+  "org.freedesktop.DBus.ObjectManager";
+}  // namespace boot_module
+
+#endif  // BLUEZ_CONSTANTS_H
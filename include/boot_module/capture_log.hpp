@@ -0,0 +1,199 @@
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace boot_module
+{
+// On-disk format of a capture segment, all fields little-endian as written
+// by the host: a CaptureFileHeader, then records back to back, each a
+// CaptureRecordHeader followed by its payload padded to 8 bytes. A record
+// of kind End (all zeros, as in the unwritten tail of a segment) or the end
+// of the file ends the segment.
+constexpr char     CAPTURE_MAGIC[8]      = {'B', 'S', 'C', 'M',
+                                            'C', 'A', 'P', 0};
+constexpr uint32_t CAPTURE_VERSION       = 1;
+constexpr size_t   CAPTURE_RECORD_ALIGN  = 8;
+constexpr char     CAPTURE_FILE_SUFFIX[] = ".bcap";
+
+struct CaptureFileHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t segment;
+  // Clocks read together at creation, to map record timestamps (steady
+  // clock) to wall-clock time
+  uint64_t createdRealtimeNs;
+  uint64_t createdSteadyNs;
+  uint8_t  reserved[24];
+};
+static_assert(sizeof(CaptureFileHeader) == 64, "capture header layout");
+
+enum class CaptureRecordKind : uint16_t
+{
+  End = 0,
+  // Payload is the notification value
+  Notification = 1,
+  // Payload is the object path of characteristic; precedes its first
+  // notification in every segment
+  Characteristic = 2
+};
+
+struct CaptureRecordHeader
+{
+  uint64_t timestampNs;
+  uint32_t characteristic;
+  uint16_t kind;
+  uint16_t size;
+};
+static_assert(sizeof(CaptureRecordHeader) == 16, "capture record layout");
+
+struct CaptureOptions
+{
+  static constexpr size_t DEFAULT_SEGMENT_BYTES = size_t{64} << 20;
+
+  // Size each segment file is preallocated to; a full segment is trimmed
+  // and the next one started
+  size_t segmentBytes = DEFAULT_SEGMENT_BYTES;
+  // Oldest segments are deleted beyond this many; 0 keeps them all
+  size_t maxSegments = 0;
+};
+
+struct CaptureStats
+{
+  uint64_t records  = 0;
+  uint64_t bytes    = 0;  // payload bytes of notifications
+  uint64_t segments = 0;
+  // Notifications lost to a failed rotation or too large for a segment
+  uint64_t dropped  = 0;
+};
+
+// Append-only binary log of notifications in memory-mapped, preallocated
+// segment files named <prefix>.0000.bcap, <prefix>.0001.bcap and so on.
+//
+// Appending copies the record into the mapping under an uncontended lock:
+// no system call happens outside rotation, only page faults as the mapping
+// is first touched. Segments are trimmed to their used size on rotation and
+// close; a crash leaves a zero tail that readers treat as the end. Thread
+// safe.
+class CaptureLog
+{
+public:
+  static constexpr size_t MAX_PAYLOAD = UINT16_MAX;
+
+  // Deletes the segments an earlier capture left under prefix first;
+  // nullptr if the first segment cannot be created
+  static std::unique_ptr<CaptureLog> create(
+    const std::string&    prefix,
+    const CaptureOptions& options = CaptureOptions{});
+  ~CaptureLog();
+
+  CaptureLog(const CaptureLog&)            = delete;
+  CaptureLog& operator=(const CaptureLog&) = delete;
+
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  // Name characteristic in the log; written ahead of its first
+  // notification in each segment
+  void describe(uint32_t characteristic, const std::string& path);
+
+  bool append(uint32_t       characteristic,
+              const uint8_t* data,
+              size_t         size,
+              uint64_t       timestampNs);
+  // Timestamped now
+  bool append(uint32_t characteristic, const std::vector<uint8_t>& value);
+
+  CaptureStats stats() const;
+  std::string  segmentPath(uint64_t segment) const;
+  // Trim and unmap the current segment; later appends are dropped
+  void         close();
+
+private:
+  const std::string    m_prefix;
+  const CaptureOptions m_options;
+
+  mutable std::mutex       m_mutex;
+  int                      m_fd      = -1;
+  uint8_t*                 m_base    = nullptr;
+  size_t                   m_offset  = 0;
+  uint64_t                 m_segment = 0;
+  // Indexed by characteristic id
+  std::vector<std::string> m_names;
+  std::vector<bool>        m_described;
+  CaptureStats             m_stats;
+
+  CaptureLog(const std::string& prefix, const CaptureOptions& options);
+
+  bool openSegment(uint64_t segment);
+  void closeSegment();
+  bool rotate();
+  void writeRecord(CaptureRecordKind kind,
+                   uint32_t          characteristic,
+                   uint64_t          timestampNs,
+                   const uint8_t*    data,
+                   size_t            size);
+};
+
+// A notification read back from a capture
+struct CaptureRecord
+{
+  uint64_t       timestampNs    = 0;
+  uint32_t       characteristic = 0;
+  const uint8_t* data           = nullptr;
+  size_t         size           = 0;
+};
+
+// Reads the segments a CaptureLog wrote under a prefix, oldest first, one
+// segment mapped at a time. Segments with a bad header are skipped with a
+// message; a truncated record ends its segment. Not thread safe.
+class CaptureReader
+{
+public:
+  // nullptr if no segment of prefix is found
+  static std::unique_ptr<CaptureReader> open(const std::string& prefix);
+  ~CaptureReader();
+
+  CaptureReader(const CaptureReader&)            = delete;
+  CaptureReader& operator=(const CaptureReader&) = delete;
+
+  // Next notification, false after the last one. record.data points into
+  // the mapping and stays valid until the next call.
+  bool next(CaptureRecord& record);
+  // Start over from the first segment
+  void rewind();
+
+  // Object path the log gave characteristic; empty until its
+  // Characteristic record has been read
+  const std::string&              characteristicPath(uint32_t id) const;
+  const std::vector<std::string>& segments() const { return m_segments; }
+
+private:
+  std::vector<std::string> m_segments;
+  size_t                   m_current = 0;
+  const uint8_t*           m_base    = nullptr;
+  size_t                   m_size    = 0;
+  size_t                   m_offset  = 0;
+  // Indexed by characteristic id
+  std::vector<std::string> m_names;
+
+  explicit CaptureReader(std::vector<std::string> segments);
+
+  bool openSegment(size_t index);
+  void closeSegment();
+};
+}  // namespace boot_module
+
+#endif  // CAPTURE_LOG_H
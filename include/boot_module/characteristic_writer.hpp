@@ -0,0 +1,107 @@
+#ifndef CHARACTERISTIC_WRITER_H
+#define CHARACTERISTIC_WRITER_H
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace boot_module
+{
+// ATT MTU every link starts with
+constexpr uint16_t DEFAULT_ATT_MTU = 23;
+
+enum class WriteStatus
+{
+  Ok,
+  // Socket buffer full; wait with waitWritable() and retry
+  WouldBlock,
+  // Payload larger than maxPayload()
+  TooLarge,
+  // Remote end gone, e.g. the device disconnected
+  Closed,
+  Error
+};
+
+struct WriterStats
+{
+  uint64_t packets = 0;
+  uint64_t bytes   = 0;
+  // Writes refused because the socket buffer was full
+  uint64_t wouldBlock = 0;
+};
+
+// Streams write-without-response datagrams into the socket returned by
+// BlueZ's AcquireWrite. Every send is one ATT write command, so nothing goes
+// through dbus-daemon and there is no per-write round trip.
+//
+// The writer never blocks on its own: when the socket buffer is full a call
+// returns WouldBlock (or a short count) and the caller decides whether to
+// wait with waitWritable(). Any SOCK_SEQPACKET or SOCK_DGRAM fd works, which
+// makes a socketpair a complete stand-in for the device.
+class CharacteristicWriter
+{
+public:
+  // ATT write command header (opcode + handle) that shares the MTU
+  static constexpr uint16_t ATT_WRITE_HEADER = 3;
+  // Datagrams handed to the kernel per sendmmsg() call
+  static constexpr size_t BATCH_SIZE = 64;
+
+  // Takes ownership of fd. mtu is the ATT MTU reported by AcquireWrite.
+  CharacteristicWriter(int fd, uint16_t mtu);
+  ~CharacteristicWriter();
+
+  CharacteristicWriter(const CharacteristicWriter&)            = delete;
+  CharacteristicWriter& operator=(const CharacteristicWriter&) = delete;
+
+  uint16_t mtu() const { return m_mtu; }
+  // Largest value a single write can carry
+  size_t maxPayload() const { return m_maxPayload; }
+  bool   isOpen() const { return m_fd >= 0; }
+  int    fd() const { return m_fd; }
+
+  // Send one value as one datagram
+  WriteStatus write(const uint8_t* data, size_t size);
+  WriteStatus write(const std::vector<uint8_t>& value);
+  // Gather parts (e.g. a header and a payload) into one datagram without
+  // copying them together first
+  WriteStatus writev(const iovec* parts, int count);
+
+  // Send as many of packets as the socket accepts with sendmmsg(), starting
+  // at packets[0]. Returns how many were sent; fewer than packets.size()
+  // means backpressure (or an error, see lastStatus()).
+  size_t writeBatch(const std::vector<std::vector<uint8_t>>& packets);
+
+  // Split data into maxPayload() chunks and send them in batches. Returns the
+  // number of bytes accepted, always a whole number of chunks.
+  size_t stream(const uint8_t* data, size_t size);
+  // stream() until everything is sent, waiting out backpressure. Fails on
+  // close, error or when no progress is possible within timeoutMs.
+  bool streamAll(const uint8_t* data, size_t size, int timeoutMs = 5000);
+
+  // Wait until the socket can take more data. Returns false on timeout or
+  // when the socket is closed.
+  bool waitWritable(int timeoutMs);
+
+  WriteStatus lastStatus() const { return m_lastStatus; }
+  WriterStats stats() const { return m_stats; }
+  void        close();
+
+private:
+  int         m_fd;
+  uint16_t    m_mtu;
+  size_t      m_maxPayload;
+  WriteStatus m_lastStatus = WriteStatus::Ok;
+  WriterStats m_stats;
+
+  WriteStatus sendMessages(const iovec* iov, size_t count, size_t& sent);
+  WriteStatus statusFromErrno();
+};
+
+// Write payload the default MTU leaves
+constexpr size_t DEFAULT_WRITE_PAYLOAD =
+  DEFAULT_ATT_MTU - CharacteristicWriter::ATT_WRITE_HEADER;
+}  // namespace boot_module
+
+#endif  // CHARACTERISTIC_WRITER_H
@@ -0,0 +1,78 @@
+#ifndef CONNECTION_MANAGER_H
+#define CONNECTION_MANAGER_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "boot_module/bluetooth_manager.hpp"
+
+namespace boot_module
+{
+enum class DeviceState
+{
+  // Waiting for a free connection slot
+  Queued,
+  // Connect sent, waiting for Connected and ServicesResolved
+  Connecting,
+  Ready,
+  Failed
+};
+
+const char* toString(DeviceState state);
+
+struct DeviceConnection
+{
+  std::string address;
+  DeviceState state = DeviceState::Queued;
+  // Time spent waiting for a slot, then in Connecting
+  std::chrono::microseconds queued{0};
+  std::chrono::microseconds connecting{0};
+
+  // From the start of connectAll until GATT was usable
+  std::chrono::microseconds timeToReady() const { return queued + connecting; }
+};
+
+// Brings up many devices at once on top of BluetoothManager's async connect.
+// At most `parallelism` connects are outstanding at any time, since adapters
+// start failing connects well before they run out of link slots; the rest
+// wait in the order given.
+class ConnectionManager
+{
+public:
+  static constexpr size_t                    DEFAULT_PARALLELISM = 3;
+  static constexpr std::chrono::milliseconds DEFAULT_TIMEOUT =
+    BluetoothManager::DEFAULT_CONNECT_TIMEOUT;
+
+  // Called on every state change, on the thread that completed the connect
+  using ProgressCallback = std::function<void(const DeviceConnection&)>;
+
+  explicit ConnectionManager(
+    BluetoothManager&         manager,
+    size_t                    parallelism = DEFAULT_PARALLELISM,
+    std::chrono::milliseconds timeout     = DEFAULT_TIMEOUT);
+
+  ConnectionManager(const ConnectionManager&)            = delete;
+  ConnectionManager& operator=(const ConnectionManager&) = delete;
+
+  // Connect every address and block until each one is Ready or Failed.
+  // Devices that are already connected and resolved count as Ready at once.
+  std::vector<DeviceConnection> connectAll(
+    const std::vector<std::string>& addresses,
+    ProgressCallback                onProgress = nullptr);
+
+  size_t                    parallelism() const { return m_parallelism; }
+  std::chrono::milliseconds timeout() const { return m_timeout; }
+
+private:
+  struct Run;
+
+  BluetoothManager&         m_manager;
+  size_t                    m_parallelism;
+  std::chrono::milliseconds m_timeout;
+};
+}  // namespace boot_module
+
+#endif  // CONNECTION_MANAGER_H
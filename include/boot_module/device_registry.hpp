@@ -0,0 +1,137 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boot_module/object_tree.hpp"
+#include "boot_module/path_table.hpp"
+#include "boot_module/uuid.hpp"
+
+namespace boot_module
+{
+struct DeviceInfo
+{
+  std::string                              address;
+  std::string                              name;
+  std::string                              alias;
+  bool                                     paired    = false;
+  bool                                     connected = false;
+  bool                                     trusted   = false;
+  std::vector<std::string>                 uuids;
+  int16_t                                  rssi = 0;
+  // Advertised manufacturer data by company identifier
+  std::map<uint16_t, std::vector<uint8_t>> manufacturerData;
+};
+
+// A Bluetooth device address packed into the low 48 bits
+using MacAddress = uint64_t;
+
+// Parse "AA:BB:CC:DD:EE:FF" in either case, with separator between the
+// bytes ('_' for BlueZ object paths). Returns false if text is malformed.
+bool        parseMac(std::string_view text,
+                     MacAddress&      mac,
+                     char             separator = ':');
+std::string formatMac(MacAddress mac, char separator = ':');
+// Address of a BlueZ device object path (".../dev_AA_BB_CC_DD_EE_FF")
+bool        macFromPath(std::string_view path, MacAddress& mac);
+
+// The frequently polled fields of one device
+struct DeviceStatus
+{
+  int16_t  rssi      = 0;
+  bool     connected = false;
+  bool     paired    = false;
+  // steady_clock time of the last advertisement or addition
+  uint64_t lastSeenNs = 0;
+};
+
+// Every org.bluez device the manager knows about, keyed by address.
+//
+// Addresses are 64-bit keys in an open-addressing table (linear probing,
+// kept at most half full) that maps them to rows of a struct-of-arrays
+// store: RSSI, flags and last-seen times sit in their own dense arrays, so
+// scanning them touches only those cache lines, while names, services and
+// manufacturer data live in a separate cold array. Object paths are
+// interned once per device and released when it is erased. Thread safe.
+class DeviceRegistry
+{
+public:
+  explicit DeviceRegistry(size_t expectedDevices = 64);
+
+  DeviceRegistry(const DeviceRegistry&)            = delete;
+  DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+  // Insert or replace a device from its full Device1 properties
+  void upsert(const std::string& path, const PropertyMap& props);
+  // Apply a PropertiesChanged update; false if the device is unknown
+  bool apply(const std::string& path, const PropertyMap& changed);
+  bool erase(MacAddress mac);
+
+  bool   contains(MacAddress mac) const;
+  bool   find(MacAddress mac, DeviceInfo& info) const;
+  bool   status(MacAddress mac, DeviceStatus& status) const;
+  // True if the device advertises any of services (or services is empty)
+  bool   advertises(MacAddress mac, const std::vector<Uuid>& services) const;
+  // Interned object path, or empty if the device is unknown
+  std::string path(MacAddress mac) const;
+  size_t      size() const;
+
+  // Every device advertising any of services (all of them if services is
+  // empty), in row order: insertion order until an erase, which moves the
+  // last device into the freed row
+  std::vector<DeviceInfo> snapshot(
+    const std::vector<Uuid>& services = {}) const;
+  // Devices heard from at or after sinceNs (steady_clock)
+  std::vector<MacAddress> seenSince(uint64_t sinceNs) const;
+
+private:
+  static constexpr MacAddress EMPTY_KEY = ~MacAddress{0};
+  static constexpr uint8_t    CONNECTED = 1 << 0;
+  static constexpr uint8_t    PAIRED    = 1 << 1;
+  static constexpr uint8_t    TRUSTED   = 1 << 2;
+
+  struct ColdFields
+  {
+    std::string                              name;
+    std::string                              alias;
+    std::vector<std::string>                 uuids;
+    // uuids parsed once, for filtering
+    std::vector<Uuid>                        serviceIds;
+    std::map<uint16_t, std::vector<uint8_t>> manufacturerData;
+  };
+
+  mutable std::mutex m_mutex;
+
+  // Hash table: address, or EMPTY_KEY, and the row it maps to
+  std::vector<MacAddress> m_keys;
+  std::vector<uint32_t>   m_rows;
+  unsigned                m_shift = 0;
+
+  // One row per device
+  std::vector<MacAddress>    m_macs;
+  std::vector<int16_t>       m_rssi;
+  std::vector<uint8_t>       m_flags;
+  std::vector<uint64_t>      m_lastSeenNs;
+  std::vector<PathTable::Id> m_pathIds;
+  std::vector<ColdFields>    m_cold;
+
+  PathTable m_paths;
+
+  // Slot where the probe for mac starts
+  size_t     homeOf(MacAddress mac) const;
+  // Slot holding mac, or the empty slot where it would go
+  size_t     slotOf(MacAddress mac) const;
+  bool       rowOf(MacAddress mac, size_t& row) const;
+  void       rehash(size_t capacity);
+  void       applyLocked(size_t row, const PropertyMap& props);
+  DeviceInfo infoAt(size_t row) const;
+};
+}  // namespace boot_module
+
+#endif  // DEVICE_REGISTRY_H
@@ -0,0 +1,183 @@
+#ifndef FIRMWARE_UPLOAD_H
+#define FIRMWARE_UPLOAD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boot_module/bluetooth_manager.hpp"
+
+namespace boot_module
+{
+// Boot module upload protocol. The image goes to a data characteristic as
+// packets of
+//
+//   u32 offset | image bytes from offset on
+//
+// with UPLOAD_LAST_PACKET set in the offset of the packet that ends the
+// image, so images are limited to 2 GiB. The module answers with
+// notifications on a status characteristic, integers little-endian:
+//
+//   0x01 u32 offset   Ack: everything below offset is stored
+//   0x02 u16 count    Credit: count more packets may be sent
+//   0x03 u32 offset   Resend: data from offset on was lost, send it again
+//   0x04 u8 code      Abort: the module refuses the image
+//
+// A module acks at least every few packets and always the last one, and
+// ignores packets past the first gap until it has asked for a resend.
+constexpr size_t   UPLOAD_HEADER_SIZE = 4;
+constexpr uint32_t UPLOAD_LAST_PACKET = 0x80000000;
+constexpr size_t   UPLOAD_MAX_IMAGE   = UPLOAD_LAST_PACKET;
+
+enum class UploadMessage : uint8_t
+{
+  Ack    = 0x01,
+  Credit = 0x02,
+  Resend = 0x03,
+  Abort  = 0x04
+};
+
+// Status notification carrying value (offset, count or code)
+std::vector<uint8_t> encodeUploadMessage(UploadMessage type, uint32_t value);
+
+// Read-only memory mapping of an image file
+class FirmwareImage
+{
+public:
+  // nullptr if the file cannot be mapped or is larger than UPLOAD_MAX_IMAGE
+  static std::unique_ptr<FirmwareImage> open(const std::string& path);
+  ~FirmwareImage();
+
+  FirmwareImage(const FirmwareImage&)            = delete;
+  FirmwareImage& operator=(const FirmwareImage&) = delete;
+
+  const std::string& path() const { return m_path; }
+  const uint8_t*     data() const { return m_data; }
+  size_t             size() const { return m_size; }
+
+private:
+  std::string    m_path;
+  const uint8_t* m_data = nullptr;
+  size_t         m_size = 0;
+
+  FirmwareImage(std::string path, const uint8_t* data, size_t size);
+};
+
+enum class FlowControl
+{
+  // Up to window packets past the last acked offset
+  Window,
+  // One packet per credit the module has granted
+  Credits
+};
+
+enum class UploadStatus
+{
+  Completed,
+  // Write channel closed or writes failing, e.g. the device went away;
+  // resume from UploadResult::acknowledged once reconnected
+  Disconnected,
+  // No ack within ackTimeout, even after retransmitting
+  TimedOut,
+  // The module sent Abort
+  Rejected,
+  Cancelled,
+  // Could not subscribe to the status characteristic, or bad options
+  Failed
+};
+
+const char* toString(UploadStatus status);
+
+struct UploadProgress
+{
+  size_t                    acknowledged = 0;
+  size_t                    total        = 0;
+  // Acked bytes per second since the start of this upload
+  double                    bytesPerSecond = 0;
+  std::chrono::milliseconds elapsed{0};
+};
+
+struct UploadOptions
+{
+  static constexpr size_t DEFAULT_WINDOW  = 32;
+  static constexpr size_t DEFAULT_RETRIES = 3;
+  static constexpr std::chrono::milliseconds DEFAULT_ACK_TIMEOUT{2000};
+  static constexpr std::chrono::milliseconds DEFAULT_PROGRESS_INTERVAL{250};
+
+  std::string dataPath;
+  std::string statusPath;
+  FlowControl flow = FlowControl::Window;
+  // Packets past the last ack (Window), or granted before the module's
+  // first Credit (Credits). Without AcquireWrite it also bounds the
+  // WriteValue calls in flight.
+  size_t      window = DEFAULT_WINDOW;
+  // Image bytes per packet; 0 for as many as the MTU allows
+  size_t      chunkSize = 0;
+  // Bytes the module already holds, from an interrupted upload
+  size_t      startOffset = 0;
+  std::chrono::milliseconds ackTimeout = DEFAULT_ACK_TIMEOUT;
+  // Times to go back to the last ack and resend after an ack timeout
+  size_t                    retries = DEFAULT_RETRIES;
+  std::chrono::milliseconds progressInterval = DEFAULT_PROGRESS_INTERVAL;
+  // Called on the uploading thread, at most every progressInterval (at
+  // least 1 ms)
+  std::function<void(const UploadProgress&)> progress;
+};
+
+struct UploadResult
+{
+  UploadStatus status = UploadStatus::Failed;
+  // Offset to resume from
+  size_t       acknowledged = 0;
+  size_t       total        = 0;
+  // Image bytes written, retransmissions included
+  size_t       sent          = 0;
+  size_t       retransmitted = 0;
+  size_t       packets       = 0;
+  size_t       chunkSize     = 0;
+  std::chrono::milliseconds elapsed{0};
+  double                    bytesPerSecond = 0;
+
+  bool ok() const { return status == UploadStatus::Completed; }
+};
+
+// Pushes a FirmwareImage to a boot module over GATT. Packets go out as ATT
+// write commands straight into the AcquireWrite socket when BlueZ offers
+// one, else as pipelined WriteValue calls; either way the image is sent
+// from the mapping without copying it whole. The status characteristic's
+// acks and credits pace the transfer, a Resend or an ack timeout rewinds
+// it to the last acked offset, and an interrupted upload can be resumed
+// with startOffset.
+//
+// upload() blocks; the manager's event loop must be running. One upload
+// per uploader at a time.
+class FirmwareUploader
+{
+public:
+  explicit FirmwareUploader(BluetoothManager& manager);
+
+  FirmwareUploader(const FirmwareUploader&)            = delete;
+  FirmwareUploader& operator=(const FirmwareUploader&) = delete;
+
+  UploadResult upload(const FirmwareImage& image, const UploadOptions& options);
+  // Make the running upload return Cancelled; safe from any thread
+  void         cancel();
+
+private:
+  struct Session;
+
+  BluetoothManager& m_manager;
+  std::atomic<bool> m_cancelled{false};
+  // Session of the running upload, for cancel() to wake
+  std::mutex               m_sessionMutex;
+  std::shared_ptr<Session> m_session;
+};
+}  // namespace boot_module
+
+#endif  // FIRMWARE_UPLOAD_H
@@ -0,0 +1,162 @@
+#ifndef FLEET_FLASHER_H
+#define FLEET_FLASHER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "boot_module/bluetooth_manager.hpp"
+#include "boot_module/firmware_upload.hpp"
+#include "boot_module/uuid.hpp"
+
+namespace boot_module
+{
+// One line of a fleet manifest:
+//
+//   ADDRESS IMAGE
+//
+// IMAGE is the path of the file to flash onto the device at ADDRESS. '#'
+// starts a comment. A device may appear only once.
+struct FleetJob
+{
+  std::string address;
+  std::string image;
+};
+
+// Parse a whole manifest; on a malformed line returns false with error
+// naming it
+bool parseFleetManifest(const std::string&     manifest,
+                        std::vector<FleetJob>& jobs,
+                        std::string&           error);
+
+struct FleetOptions
+{
+  static constexpr size_t DEFAULT_PARALLELISM = 8;
+  static constexpr size_t DEFAULT_ATTEMPTS    = 3;
+  static constexpr std::chrono::milliseconds DEFAULT_BACKOFF{2000};
+  static constexpr std::chrono::milliseconds DEFAULT_MAX_BACKOFF{30000};
+  static constexpr std::chrono::milliseconds DEFAULT_DISCOVERY_TIMEOUT{10000};
+
+  // Devices flashing at once
+  size_t parallelism = DEFAULT_PARALLELISM;
+  // Tries per device, the first included
+  size_t attempts = DEFAULT_ATTEMPTS;
+  // Wait before the second try, doubling for every further one
+  std::chrono::milliseconds backoff    = DEFAULT_BACKOFF;
+  std::chrono::milliseconds maxBackoff = DEFAULT_MAX_BACKOFF;
+  std::chrono::milliseconds connectTimeout =
+    BluetoothManager::DEFAULT_CONNECT_TIMEOUT;
+  // Scan this long at most for the devices BlueZ does not know yet before
+  // flashing starts; 0 to skip the scan and try them anyway
+  std::chrono::milliseconds discoveryTimeout = DEFAULT_DISCOVERY_TIMEOUT;
+  // Boot module characteristics, from the first service of each device
+  // that has both
+  Uuid dataCharacteristic;
+  Uuid statusCharacteristic;
+  // Pacing, timeouts and chunk size for every upload; the paths, the start
+  // offset and the progress callback are filled in per device
+  UploadOptions upload;
+  bool          disconnectAfter = true;
+};
+
+struct FleetDeviceResult
+{
+  std::string  address;
+  std::string  image;
+  // Adapter path the device was flashed through
+  std::string  adapter;
+  UploadStatus status = UploadStatus::Failed;
+  size_t       attempts = 0;
+  // Image size, and how much of it the device acknowledged
+  size_t       total        = 0;
+  size_t       acknowledged = 0;
+  // From the first connect until the device was done, backoff included
+  std::chrono::milliseconds duration{0};
+  // Spent in upload() over all attempts
+  std::chrono::milliseconds uploading{0};
+  // Acknowledged bytes per second of uploading
+  double                    bytesPerSecond = 0;
+  // Why the last attempt failed
+  std::string               error;
+
+  bool ok() const { return status == UploadStatus::Completed; }
+};
+
+struct FleetReport
+{
+  // In manifest order
+  std::vector<FleetDeviceResult> devices;
+  size_t                         succeeded = 0;
+  size_t                         failed    = 0;
+  std::chrono::milliseconds      elapsed{0};
+  // Acknowledged bytes over all devices per second of wall time
+  double                         bytesPerSecond = 0;
+
+  // Human-readable table, one device per line, and a summary
+  void writeText(std::ostream& out) const;
+};
+
+// One JSON object per line: a device's outcome, and the summary that
+// follows the last device
+std::string toJson(const FleetDeviceResult& result);
+std::string toJson(const FleetReport& report);
+
+// Flashes a manifest of devices with FirmwareUploader, keeping up to
+// `parallelism` devices busy at once, all through the manager's adapter.
+// Devices BlueZ has not seen are scanned for first; those the scan does not
+// find fail as not found without an attempt. A failed device goes back in
+// the queue after an exponential backoff and resumes from the offset it
+// acknowledged; a device that rejects its image is not retried.
+//
+// run() blocks; the manager's event loop must be running.
+class FleetFlasher
+{
+public:
+  // Called as each device finishes, on the thread that flashed it
+  using DoneCallback = std::function<void(const FleetDeviceResult&)>;
+
+  FleetFlasher(BluetoothManager& manager, const FleetOptions& options);
+
+  FleetFlasher(const FleetFlasher&)            = delete;
+  FleetFlasher& operator=(const FleetFlasher&) = delete;
+
+  FleetReport run(const std::vector<FleetJob>& jobs,
+                  DoneCallback                 onDone = nullptr);
+  // Cancel the running uploads and give up on the queued devices; safe from
+  // any thread
+  void        cancel();
+
+  const FleetOptions& options() const { return m_options; }
+
+private:
+  struct Run;
+
+  BluetoothManager& m_manager;
+  FleetOptions      m_options;
+
+  std::atomic<bool> m_cancelled{false};
+  // Uploads in progress and the run they belong to, for cancel() to stop
+  std::mutex                  m_activeMutex;
+  std::set<FirmwareUploader*> m_active;
+  std::shared_ptr<Run>        m_run;
+
+  // Discover the queued devices missing from the registry, and finish the
+  // ones discovery does not turn up
+  void locate(Run& run);
+  void worker(Run& run);
+  // One connect, resolve and upload of the device at index
+  void attempt(Run& run, size_t index);
+  bool resolve(const std::string& address,
+               std::string&       dataPath,
+               std::string&       statusPath);
+};
+}  // namespace boot_module
+
+#endif  // FLEET_FLASHER_H
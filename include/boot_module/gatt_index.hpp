@@ -0,0 +1,126 @@
+#ifndef GATT_INDEX_H
+#define GATT_INDEX_H
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boot_module/object_tree.hpp"
+#include "boot_module/path_table.hpp"
+
+namespace boot_module
+{
+// Small integer standing in for a GATT service or characteristic path.
+// Handles never change meaning, so they stay valid across disconnects and
+// can key maps or be held in hot loops instead of the path.
+struct GattHandle
+{
+  PathTable::Id id = PathTable::INVALID_ID;
+
+  bool valid() const { return id != PathTable::INVALID_ID; }
+
+  friend bool operator==(GattHandle a, GattHandle b) { return a.id == b.id; }
+  friend bool operator!=(GattHandle a, GattHandle b) { return a.id != b.id; }
+};
+
+struct CharacteristicInfo
+{
+  std::string              path;
+  std::string              uuid;
+  std::vector<std::string> flags;
+  GattHandle               handle;
+};
+
+struct ServiceInfo
+{
+  std::string                     path;
+  std::string                     uuid;
+  std::vector<CharacteristicInfo> characteristics;
+  GattHandle                      handle;
+};
+}  // namespace boot_module
+
+namespace std
+{
+template <>
+struct hash<boot_module::GattHandle>
+{
+  size_t operator()(boot_module::GattHandle handle) const noexcept
+  {
+    return handle.id;
+  }
+};
+}  // namespace std
+
+namespace boot_module
+{
+// The GATT services and characteristics of every device, as a tree of
+// interned handles.
+//
+// Each device, service and characteristic path is interned once in a
+// PathTable; the handle indexes a dense node array that records the
+// node's parent and children. Listing a device's services, a service's
+// characteristics or everything below a device visits just those
+// children, with no walk over the rest of the object tree and no path
+// prefix compares. Nodes are never dropped: objects BlueZ removes are only
+// marked absent, so their handles still lead to what was subscribed on
+// them. Kept current from the object tree; thread safe.
+class GattIndex
+{
+public:
+  GattIndex() = default;
+
+  GattIndex(const GattIndex&)            = delete;
+  GattIndex& operator=(const GattIndex&) = delete;
+
+  // Apply an object tree change; anything but GattService1 and
+  // GattCharacteristic1 is ignored
+  void apply(ObjectTree::Change change,
+             const std::string& path,
+             const std::string& interface,
+             const PropertyMap& props);
+
+  // Invalid if path was never seen
+  GattHandle find(std::string_view path) const;
+  // Empty for an invalid handle
+  const std::string& path(GattHandle handle) const;
+  bool hasFlag(GattHandle handle, std::string_view flag) const;
+  // Device a service or characteristic belongs to; the handle itself if it
+  // is a device, invalid if it is invalid
+  GattHandle device(GattHandle handle) const;
+
+  // Present services of device and characteristics of service, in the
+  // order they first appeared
+  std::vector<ServiceInfo>        services(GattHandle device) const;
+  std::vector<CharacteristicInfo> characteristics(GattHandle service) const;
+  // Every characteristic ever seen below device, present or not
+  std::vector<GattHandle>         subtree(GattHandle device) const;
+
+  // Number of interned paths
+  size_t size() const;
+
+private:
+  struct Node
+  {
+    bool                     present = false;
+    GattHandle               parent;
+    std::string              uuid;
+    std::vector<std::string> flags;
+    std::vector<GattHandle>  children;
+  };
+
+  mutable std::mutex m_mutex;
+  PathTable          m_paths;
+  // Indexed by handle id
+  std::vector<Node>  m_nodes;
+
+  // Intern path and, for the given number of levels, the paths above it
+  GattHandle internLocked(const std::string& path, int levels);
+  bool       presentLocked(GattHandle handle) const;
+};
+}  // namespace boot_module
+
+#endif  // GATT_INDEX_H
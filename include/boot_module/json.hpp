@@ -0,0 +1,13 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+
+namespace boot_module
+{
+// text as a quoted JSON string, with quotes, backslashes and control
+// characters escaped; shared by the line-per-object report writers
+std::string jsonString(const std::string& text);
+}  // namespace boot_module
+
+#endif  // JSON_H
@@ -0,0 +1,241 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "boot_module/gatt_index.hpp"
+#include "boot_module/trace.hpp"
+
+namespace boot_module
+{
+// D-Bus calls the manager makes, each with its own histogram
+enum class Operation : uint8_t
+{
+  GetManagedObjects,
+  GetAll,
+  Set,
+  Connect,
+  Disconnect,
+  ReadValue,
+  WriteValue,
+  StartNotify,
+  StopNotify,
+  AcquireNotify,
+  AcquireWrite,
+  Count
+};
+
+constexpr size_t OPERATION_COUNT = static_cast<size_t>(Operation::Count);
+
+const char* toString(Operation operation);
+
+// HDR-style log-linear buckets over nanoseconds: exact below 8 ns, then 8
+// sub-buckets per power of two, so any value is within 12.5% of its
+// bucket's lower bound. Values past 2^40 ns (about 18 minutes) share the
+// last bucket.
+struct LatencyBuckets
+{
+  static constexpr int    SUB_BUCKET_BITS = 3;
+  static constexpr int    MAX_EXPONENT    = 40;
+  static constexpr size_t SUB_BUCKETS     = size_t{1} << SUB_BUCKET_BITS;
+  static constexpr size_t COUNT =
+    (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+  static size_t   indexOf(uint64_t ns);
+  static uint64_t lowerBound(size_t index);
+};
+
+struct OperationStats
+{
+  uint64_t              count  = 0;
+  uint64_t              errors = 0;
+  uint64_t              sumNs  = 0;
+  uint64_t              minNs  = 0;
+  uint64_t              maxNs  = 0;
+  std::vector<uint64_t> buckets;  // LatencyBuckets::COUNT entries
+
+  double   meanNs() const { return count ? double(sumNs) / count : 0.0; }
+  // Lower bound of the bucket holding the given percentile (0-100)
+  uint64_t percentileNs(double percentile) const;
+};
+
+struct CharacteristicStats
+{
+  std::string path;
+  uint64_t    notifications = 0;
+  uint64_t    bytes         = 0;
+};
+
+struct MetricsSnapshot
+{
+  std::array<OperationStats, OPERATION_COUNT> operations;
+  std::vector<CharacteristicStats>            characteristics;
+
+  const OperationStats& operator[](Operation operation) const
+  {
+    return operations[static_cast<size_t>(operation)];
+  }
+};
+
+// Notification counters of one subscription, bumped by whichever thread
+// delivers its notifications
+struct NotificationCounters
+{
+  std::atomic<uint64_t> notifications{0};
+  std::atomic<uint64_t> bytes{0};
+
+  void add(size_t size)
+  {
+    notifications.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+};
+
+// Latency histograms and error counts per D-Bus operation, plus
+// notification counters per characteristic.
+//
+// Every thread records into its own cells, found through a thread_local
+// cache, so recording takes no lock and shares no cache line with other
+// threads; each cell has a single writer and is updated with plain relaxed
+// loads and stores. snapshot() sums the cells of all threads, which may be
+// mid-update: a snapshot is consistent per counter, not across counters.
+// Cells of a thread that exits keep their counts and go to the next thread
+// that records, so there are only as many as threads ever ran at once.
+class Metrics
+{
+public:
+  Metrics();
+  ~Metrics();
+
+  Metrics(const Metrics&)            = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  void record(Operation operation, uint64_t elapsedNs, bool ok);
+
+  // Counters for characteristic, created on first use and kept across
+  // resubscriptions
+  std::shared_ptr<NotificationCounters> notifications(
+    GattHandle         characteristic,
+    const std::string& path);
+
+  MetricsSnapshot snapshot() const;
+
+private:
+  struct Cells
+  {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> sumNs{0};
+    std::atomic<uint64_t> minNs{UINT64_MAX};
+    std::atomic<uint64_t> maxNs{0};
+    std::array<std::atomic<uint64_t>, LatencyBuckets::COUNT> buckets{};
+  };
+
+  struct ThreadCells
+  {
+    std::array<Cells, OPERATION_COUNT> operations;
+  };
+
+  // Every thread's cells, shared with the threads so that one exiting can
+  // hand its cells back even while the instance is being destroyed
+  struct CellPool
+  {
+    std::mutex                                mutex;
+    std::vector<std::unique_ptr<ThreadCells>> cells;
+    // Cells of exited threads, reused before new ones are added
+    std::vector<ThreadCells*>                 free;
+  };
+
+  // The cells a thread holds in each instance, returned when it exits
+  struct ThreadLeases;
+
+  struct Subscription
+  {
+    std::string                           path;
+    std::shared_ptr<NotificationCounters> counters;
+  };
+
+  // Distinguishes instances in the thread_local cache, even when a new one
+  // reuses a destroyed one's address
+  const uint64_t                               m_id;
+  const std::shared_ptr<CellPool>              m_cells;
+  // Guards m_subscriptions
+  mutable std::mutex                           m_mutex;
+  std::unordered_map<GattHandle, Subscription> m_subscriptions;
+
+  static thread_local ThreadLeases t_leases;
+
+  ThreadCells& threadCells();
+  ThreadCells& registerThread();
+};
+
+// Record an async call sent at startNs whose reply just arrived, and trace
+// it while tracing is on
+void recordReply(Metrics&  metrics,
+                 Operation operation,
+                 uint64_t  startNs,
+                 bool      ok);
+
+// Times one operation from construction; succeeded() records it as such,
+// anything else (an exception, an early return) as an error. Traced as a
+// span while tracing is on.
+class OperationTimer
+{
+public:
+  OperationTimer(Metrics& metrics, Operation operation)
+    : m_metrics(metrics), m_operation(operation), m_start(Metrics::now())
+  {
+  }
+  ~OperationTimer()
+  {
+    if (!m_recorded)
+    {
+      finish(false);
+    }
+  }
+
+  OperationTimer(const OperationTimer&)            = delete;
+  OperationTimer& operator=(const OperationTimer&) = delete;
+
+  void succeeded()
+  {
+    finish(true);
+    m_recorded = true;
+  }
+
+private:
+  Metrics&  m_metrics;
+  Operation m_operation;
+  uint64_t  m_start;
+  bool      m_recorded = false;
+
+  void finish(bool ok)
+  {
+    uint64_t end = Metrics::now();
+    m_metrics.record(m_operation, end - m_start, ok);
+    if (Tracer::instance().enabled())
+    {
+      Tracer::instance().complete(
+        toString(m_operation), "dbus", m_start, end, ok ? "" : "failed");
+    }
+  }
+};
+}  // namespace boot_module
+
+#endif  // METRICS_H
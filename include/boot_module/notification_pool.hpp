@@ -0,0 +1,100 @@
+#ifndef NOTIFICATION_POOL_H
+#define NOTIFICATION_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace boot_module
+{
+// Non-owning view of a notification payload
+struct ByteView
+{
+  const uint8_t* data = nullptr;
+  size_t         size = 0;
+
+  const uint8_t* begin() const { return data; }
+  const uint8_t* end() const { return data + size; }
+  bool           empty() const { return size == 0; }
+  uint8_t        operator[](size_t index) const { return data[index]; }
+};
+
+struct PoolStats
+{
+  // Buffers owned by the pool, whether handed out or not
+  size_t   buffers   = 0;
+  size_t   available = 0;
+  uint64_t acquired  = 0;
+  // acquire() calls that found the pool empty and had to allocate
+  uint64_t misses    = 0;
+};
+
+class BufferPool;
+
+// A buffer borrowed from a BufferPool. It goes back to the pool when the
+// holder destroys it or calls release(), which may happen on any thread and
+// after the pool itself is gone.
+class PooledBuffer
+{
+public:
+  PooledBuffer() = default;
+  ~PooledBuffer() { release(); }
+
+  PooledBuffer(PooledBuffer&& other) noexcept;
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+
+  PooledBuffer(const PooledBuffer&)            = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  const uint8_t* data() const { return m_buffer->data(); }
+  size_t         size() const { return m_buffer->size(); }
+  ByteView       view() const { return {m_buffer->data(), m_buffer->size()}; }
+  const std::vector<uint8_t>& bytes() const { return *m_buffer; }
+
+  // For the producer filling it in. Cleared on acquire, capacity kept.
+  std::vector<uint8_t>& storage() { return *m_buffer; }
+
+  explicit operator bool() const { return m_buffer != nullptr; }
+
+  void release();
+
+private:
+  friend class BufferPool;
+  struct Shared;
+
+  PooledBuffer(std::shared_ptr<Shared> shared, std::vector<uint8_t>* buffer)
+    : m_shared(std::move(shared)), m_buffer(buffer)
+  {
+  }
+
+  std::shared_ptr<Shared> m_shared;
+  std::vector<uint8_t>*   m_buffer = nullptr;
+};
+
+// Fixed set of preallocated payload buffers for one subscription, so the
+// notification path does not touch the heap once it is warm. When every
+// buffer is out, acquire() allocates a new one; the pool keeps at most the
+// number of buffers it was created with and frees any extras on release.
+class BufferPool
+{
+public:
+  static constexpr size_t DEFAULT_BUFFERS  = 8;
+  // Largest value an ATT attribute can hold
+  static constexpr size_t DEFAULT_CAPACITY = 512;
+
+  explicit BufferPool(size_t buffers  = DEFAULT_BUFFERS,
+                      size_t capacity = DEFAULT_CAPACITY);
+
+  BufferPool(const BufferPool&)            = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  PooledBuffer acquire();
+  PoolStats    stats() const;
+
+private:
+  std::shared_ptr<PooledBuffer::Shared> m_shared;
+};
+}  // namespace boot_module
+
+#endif  // NOTIFICATION_POOL_H
@@ -0,0 +1,89 @@
+#ifndef NOTIFICATION_REPLAY_H
+#define NOTIFICATION_REPLAY_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boot_module/capture_log.hpp"
+
+namespace boot_module
+{
+struct ReplayOptions
+{
+  // Playback rate against the recording: 1 keeps the original spacing, 10
+  // plays ten times faster, 0 delivers as fast as the callbacks return
+  double speed  = 1.0;
+  // Times to play the recording back to back; 0 repeats until stop()
+  size_t passes = 1;
+};
+
+struct ReplayStats
+{
+  uint64_t notifications = 0;
+  uint64_t bytes         = 0;
+  // Recorded for a characteristic nobody subscribed to
+  uint64_t skipped       = 0;
+  std::chrono::nanoseconds elapsed{0};
+  // Furthest a delivery fell behind its scheduled time, i.e. how far the
+  // callbacks failed to keep up with the requested speed
+  std::chrono::nanoseconds maxLag{0};
+};
+
+// Feeds a recorded notification stream (see CaptureLog) back through the
+// same callback contract as BluetoothManager::enableNotifications, so
+// consumer code can be driven without devices: at the recorded timing, N
+// times faster, or flat out. Notifications are delivered in recording
+// order on the thread calling run(), from a buffer reused across calls.
+class NotificationReplay
+{
+public:
+  using Callback = std::function<void(const std::vector<uint8_t>&)>;
+
+  NotificationReplay(std::unique_ptr<CaptureReader> reader,
+                     const ReplayOptions&           options = ReplayOptions{});
+
+  NotificationReplay(const NotificationReplay&)            = delete;
+  NotificationReplay& operator=(const NotificationReplay&) = delete;
+
+  // Deliver what was recorded for characteristicPath to callback. Call
+  // before run().
+  void subscribe(const std::string& characteristicPath, Callback callback);
+  // Deliver every characteristic without a callback of its own
+  void subscribeAll(Callback callback);
+
+  // Blocks until every pass is played or stop() is called
+  ReplayStats run();
+  // Safe from any thread, including from a callback
+  void        stop();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_ptr<CaptureReader>  m_reader;
+  ReplayOptions                   m_options;
+  std::map<std::string, Callback> m_callbacks;
+  Callback                        m_fallback;
+  // Callback of each characteristic id, resolved when first seen
+  std::vector<const Callback*>    m_routes;
+  std::vector<bool>               m_resolved;
+
+  std::mutex              m_stopMutex;
+  std::condition_variable m_stopCondition;
+  std::atomic<bool>       m_stopping{false};
+
+  const Callback* route(uint32_t characteristic);
+  // Sleep until due; false if stopped meanwhile
+  bool            waitUntil(Clock::time_point due);
+};
+}  // namespace boot_module
+
+#endif  // NOTIFICATION_REPLAY_H
@@ -0,0 +1,156 @@
+#ifndef NOTIFICATION_RING_H
+#define NOTIFICATION_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boot_module
+{
+enum class OverflowPolicy
+{
+  // Overwrite the oldest queued notification
+  DropOldest,
+  // Discard the notification that did not fit
+  DropNewest,
+  // Stall the producer (the D-Bus or socket reader thread) until there is
+  // room; nothing is lost but every other subscription waits too
+  Block
+};
+
+struct RingOptions
+{
+  // Rounded up to a power of two
+  size_t         slots    = 256;
+  // Longest notification kept whole; longer ones are truncated. 512 is the
+  // largest value an ATT attribute can hold.
+  size_t         slotSize = 512;
+  OverflowPolicy policy   = OverflowPolicy::DropOldest;
+};
+
+struct RingStats
+{
+  uint64_t pushed    = 0;
+  uint64_t delivered = 0;
+  uint64_t dropped   = 0;
+  // Notifications cut down to slotSize
+  uint64_t truncated = 0;
+  // Times the producer had to wait under OverflowPolicy::Block
+  uint64_t blocked   = 0;
+  // Most slots ever occupied at once
+  size_t   highWater = 0;
+  size_t   capacity  = 0;
+};
+
+// One notification as seen by a ring consumer. data points into the
+// consumer's own buffer and is only valid during the callback.
+struct NotificationView
+{
+  const uint8_t* data = nullptr;
+  size_t         size = 0;
+  // steady_clock time at which the producer queued it
+  uint64_t       timestampNs = 0;
+};
+
+// Lock-free single-producer/single-consumer queue of fixed-size slots, all
+// allocated up front.
+//
+// The producer owns the tail and the consumer the head. DropOldest is the one
+// case where the producer also advances the head; the consumer then detects
+// that its slot was recycled because its compare-and-swap on the head fails,
+// and retries with the next one.
+class NotificationRing
+{
+public:
+  explicit NotificationRing(const RingOptions& options);
+
+  NotificationRing(const NotificationRing&)            = delete;
+  NotificationRing& operator=(const NotificationRing&) = delete;
+
+  // Producer side. Returns false if the notification was dropped.
+  bool push(const uint8_t* data, size_t size, uint64_t timestampNs);
+  // Consumer side. Copies the oldest notification into buffer, which must
+  // hold slotSize() bytes.
+  bool pop(uint8_t* buffer, NotificationView& view);
+
+  // Wake a producer blocked in push() and make further pushes drop
+  void close();
+  // Consumer side: sleep until a notification may be available
+  void waitForData(std::chrono::milliseconds timeout);
+
+  size_t    slotSize() const { return m_slotSize; }
+  size_t    capacity() const { return m_capacity; }
+  RingStats stats() const;
+
+private:
+  struct SlotHeader
+  {
+    uint64_t timestampNs;
+    uint32_t size;
+  };
+
+  const size_t            m_capacity;
+  const size_t            m_mask;
+  const size_t            m_slotSize;
+  const OverflowPolicy    m_policy;
+  std::vector<SlotHeader> m_headers;
+  std::vector<uint8_t>    m_data;
+
+  // Separate cache lines so producer and consumer do not false-share
+  alignas(64) std::atomic<uint64_t> m_head{0};
+  alignas(64) std::atomic<uint64_t> m_tail{0};
+
+  alignas(64) std::atomic<uint64_t> m_pushed{0};
+  std::atomic<uint64_t> m_delivered{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<uint64_t> m_truncated{0};
+  std::atomic<uint64_t> m_blocked{0};
+  std::atomic<size_t>   m_highWater{0};
+  std::atomic<bool>     m_closed{false};
+
+  // Only used to park an idle consumer or a blocked producer
+  std::atomic<bool>       m_consumerWaiting{false};
+  std::atomic<bool>       m_producerWaiting{false};
+  std::mutex              m_wakeMutex;
+  std::condition_variable m_wake;
+
+  void wake(std::atomic<bool>& waiting);
+};
+
+// Runs a consumer thread that drains a NotificationRing into a callback, so
+// slow consumers never run on the thread that receives notifications.
+class RingDispatcher
+{
+public:
+  using Consumer = std::function<void(const NotificationView&)>;
+
+  RingDispatcher(const RingOptions& options, Consumer consumer);
+  // Delivers whatever is still queued, then joins the consumer thread
+  ~RingDispatcher();
+
+  RingDispatcher(const RingDispatcher&)            = delete;
+  RingDispatcher& operator=(const RingDispatcher&) = delete;
+
+  // Producer entry point; timestamps the notification on arrival
+  void push(const std::vector<uint8_t>& value);
+
+  RingStats stats() const { return m_ring.stats(); }
+
+private:
+  NotificationRing  m_ring;
+  Consumer          m_consumer;
+  std::atomic<bool> m_running{true};
+  std::thread       m_thread;
+
+  void run();
+};
+}  // namespace boot_module
+
+#endif  // NOTIFICATION_RING_H
@@ -0,0 +1,74 @@
+#ifndef NOTIFY_SOCKET_READER_H
+#define NOTIFY_SOCKET_READER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boot_module
+{
+// Reads GATT notifications straight from the sockets returned by BlueZ's
+// AcquireNotify, bypassing dbus-daemon and D-Bus marshalling.
+//
+// One epoll thread serves every acquired socket. Each readable socket is
+// drained completely per wakeup into a buffer that is allocated once per
+// subscription and reused for every datagram.
+class NotifySocketReader
+{
+public:
+  using Callback = std::function<void(const std::vector<uint8_t>&)>;
+  // Called on the reader thread when the remote end closes the socket, e.g.
+  // because the device disconnected
+  using ClosedCallback = std::function<void(int fd)>;
+
+  NotifySocketReader();
+  ~NotifySocketReader();
+
+  NotifySocketReader(const NotifySocketReader&)            = delete;
+  NotifySocketReader& operator=(const NotifySocketReader&) = delete;
+
+  // Takes ownership of fd. mtu bounds the size of a single notification.
+  bool add(int fd, uint16_t mtu, Callback callback, ClosedCallback onClosed);
+  // Closes fd. Once this returns the callback is not running and will not
+  // run again, unless called from the callback itself.
+  void remove(int fd);
+
+private:
+  struct Subscription
+  {
+    uint64_t             id;
+    int                  fd;
+    bool                 open = true;
+    Callback             callback;
+    ClosedCallback       onClosed;
+    std::vector<uint8_t> buffer;
+    size_t               capacity;
+  };
+
+  int               m_epollFd = -1;
+  int               m_wakeFd  = -1;
+  std::atomic<bool> m_running{true};
+  std::mutex        m_mutex;
+  uint64_t          m_nextId = 1;
+  // Keyed by id rather than fd so a stale event for a closed fd can never
+  // reach a new subscription that reused the number
+  std::map<uint64_t, std::shared_ptr<Subscription>> m_subscriptions;
+  std::map<int, uint64_t>                           m_idByFd;
+  // Held by the reader thread while it dispatches a batch of events
+  std::mutex  m_dispatchMutex;
+  std::thread m_thread;
+
+  void run();
+  // hungUp is set when epoll reported the peer closed; everything still
+  // queued, empty notifications included, is delivered before returning
+  bool drain(Subscription& subscription, bool hungUp);
+  void close(Subscription& subscription);
+};
+}  // namespace boot_module
+
+#endif  // NOTIFY_SOCKET_READER_H
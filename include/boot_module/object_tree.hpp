@@ -0,0 +1,104 @@
+#ifndef OBJECT_TREE_H
+#define OBJECT_TREE_H
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace boot_module
+{
+using PropertyMap  = std::map<std::string, sdbus::Variant>;
+using InterfaceMap = std::map<std::string, PropertyMap>;
+
+class Metrics;
+
+// In-process mirror of the org.bluez object tree.
+//
+// The tree is seeded from a single GetManagedObjects call and then kept
+// current from the InterfacesAdded, InterfacesRemoved and PropertiesChanged
+// signals, so queries never leave the process. Signals are applied on
+// whichever thread dispatches the connection's events; all accessors are
+// thread safe. Property changes on characteristics (Value, Notifying) are
+// not followed, so their entries keep the values they were added with.
+class ObjectTree
+{
+public:
+  enum class Change
+  {
+    InterfacesAdded,
+    InterfacesRemoved,
+    PropertiesChanged
+  };
+
+  using Visitor =
+    std::function<void(const std::string& path, const PropertyMap& props)>;
+
+  // Called after the mirror has been updated, on the dispatching thread.
+  // props holds the added or changed properties (empty for removals).
+  using Listener   = std::function<void(Change             change,
+                                        const std::string& path,
+                                        const std::string& interface,
+                                        const PropertyMap& props)>;
+  using ListenerId = uint64_t;
+
+  // GetManagedObjects calls are timed into metrics, if given
+  explicit ObjectTree(sdbus::IConnection& connection,
+                      Metrics*            metrics = nullptr);
+  ~ObjectTree();
+
+  ObjectTree(const ObjectTree&)            = delete;
+  ObjectTree& operator=(const ObjectTree&) = delete;
+
+  // Replace the mirror with a fresh GetManagedObjects snapshot
+  void refresh();
+
+  // Visit every object whose path starts with pathPrefix and that implements
+  // interface. Only the matching range of the tree is walked, in sorted path
+  // order; the visitor must not call back into the tree.
+  void forEach(const std::string& interface,
+               const std::string& pathPrefix,
+               const Visitor&     visitor) const;
+
+  // Copy the properties of one interface, returns false if not present
+  bool getInterface(const std::string& path,
+                    const std::string& interface,
+                    PropertyMap&       props) const;
+
+  bool   hasInterface(const std::string& path,
+                      const std::string& interface) const;
+  size_t size() const;
+
+  // Listeners may add or remove listeners, including themselves
+  ListenerId addListener(Listener listener);
+  void       removeListener(ListenerId id);
+
+private:
+  sdbus::IConnection&                 m_connection;
+  Metrics*                            m_metrics;
+  std::unique_ptr<sdbus::IProxy>      m_rootProxy;
+  std::vector<sdbus::Slot>            m_propertiesSlots;
+  mutable std::mutex                  m_mutex;
+  std::map<std::string, InterfaceMap> m_objects;
+
+  std::mutex                                      m_listenerMutex;
+  ListenerId                                      m_nextListenerId = 1;
+  std::map<ListenerId, std::shared_ptr<Listener>> m_listeners;
+
+  void onInterfacesAdded(const std::string&                        path,
+                         const std::map<std::string, PropertyMap>& added);
+  void onInterfacesRemoved(const std::string&              path,
+                           const std::vector<std::string>& removed);
+  void onPropertiesChanged(sdbus::Message& message);
+  void notify(Change             change,
+              const std::string& path,
+              const std::string& interface,
+              const PropertyMap& props);
+};
+}  // namespace boot_module
+
+#endif  // OBJECT_TREE_H
@@ -0,0 +1,54 @@
+#ifndef PATH_TABLE_H
+#define PATH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace boot_module
+{
+// Interns D-Bus object paths as dense 32-bit ids, so each path is stored
+// once and everything else can hold and compare a small integer. The
+// strings never move, and an id stays valid until it is released; a
+// released id is handed out again to a later path. Thread safe.
+class PathTable
+{
+public:
+  using Id = uint32_t;
+
+  static constexpr Id INVALID_ID = UINT32_MAX;
+
+  PathTable() = default;
+
+  PathTable(const PathTable&)            = delete;
+  PathTable& operator=(const PathTable&) = delete;
+
+  // Id of path, adding it if it was never seen
+  Id intern(const std::string& path);
+  // Drop the path of id, so a table that sees an unbounded stream of paths
+  // stays as large as the live ones; the id must not be used afterwards
+  void release(Id id);
+  // INVALID_ID if path was never interned, or was released
+  Id find(std::string_view path) const;
+  // id must have come from this table
+  const std::string& path(Id id) const;
+
+  // Paths interned and not released
+  size_t size() const;
+
+private:
+  mutable std::mutex                       m_mutex;
+  std::deque<std::string>                  m_paths;
+  // Keys view into m_paths
+  std::unordered_map<std::string_view, Id> m_ids;
+  // Released ids, reused before the table grows
+  std::vector<Id>                          m_free;
+};
+}  // namespace boot_module
+
+#endif  // PATH_TABLE_H
@@ -0,0 +1,65 @@
+#ifndef PROXY_POOL_H
+#define PROXY_POOL_H
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace boot_module
+{
+struct ProxyPoolStats
+{
+  uint64_t hits      = 0;
+  uint64_t misses    = 0;
+  uint64_t evictions = 0;
+  size_t   size      = 0;
+  size_t   capacity  = 0;
+};
+
+// Bounded, path-keyed cache of org.bluez method-call proxies.
+//
+// Creating a proxy means converting the service name and object path and
+// setting up sdbus-c++'s internal state, which costs more than a short D-Bus
+// call. The pool keeps the most recently used proxies alive and drops the
+// least recently used one once it is full. Proxies are handed out as
+// shared_ptr so an eviction never pulls one out from under a running call.
+class ProxyPool
+{
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 128;
+
+  explicit ProxyPool(sdbus::IConnection& connection,
+                     size_t              capacity = DEFAULT_CAPACITY);
+
+  ProxyPool(const ProxyPool&)            = delete;
+  ProxyPool& operator=(const ProxyPool&) = delete;
+
+  std::shared_ptr<sdbus::IProxy> get(const std::string& objectPath);
+
+  void evict(const std::string& objectPath);
+  // Drop the proxy for pathPrefix and every object below it
+  void evictSubtree(const std::string& pathPrefix);
+  void clear();
+
+  ProxyPoolStats stats() const;
+
+private:
+  using Entry   = std::pair<std::string, std::shared_ptr<sdbus::IProxy>>;
+  using EntryIt = std::list<Entry>::iterator;
+
+  sdbus::IConnection&                      m_connection;
+  const size_t                             m_capacity;
+  mutable std::mutex                       m_mutex;
+  std::list<Entry>                         m_lru;  // most recent first
+  std::unordered_map<std::string, EntryIt> m_index;
+  uint64_t                                 m_hits      = 0;
+  uint64_t                                 m_misses    = 0;
+  uint64_t                                 m_evictions = 0;
+};
+}  // namespace boot_module
+
+#endif  // PROXY_POOL_H
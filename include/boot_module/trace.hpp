@@ -0,0 +1,158 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace boot_module
+{
+// Opt-in Chrome trace-event recorder (chrome://tracing, ui.perfetto.dev).
+//
+// Spans are written into a buffer preallocated by start(): recording
+// claims a slot with one atomic increment and copies a fixed-size record,
+// with no allocation, lock or I/O, so tracing barely moves the timings it
+// shows. Once the buffer is full further spans are counted as dropped.
+// The buffer is turned into JSON only by flush(), on demand or when the
+// process exits. While stopped, recording costs one relaxed load.
+class Tracer
+{
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 18;
+  // Longer details (object paths, addresses) are truncated
+  static constexpr size_t DETAIL_SIZE = 64;
+
+  // The process-wide tracer
+  static Tracer& instance();
+
+  ~Tracer();
+
+  Tracer(const Tracer&)            = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  // Preallocate room for capacity spans and start recording. outputPath
+  // is where flush() and process exit write the trace.
+  void start(const std::string& outputPath,
+             size_t             capacity = DEFAULT_CAPACITY);
+  void stop();
+  bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  // A span on the calling thread; name and category must be string
+  // literals or otherwise outlive the tracer
+  void complete(const char*      name,
+                const char*      category,
+                uint64_t         startNs,
+                uint64_t         endNs,
+                std::string_view detail = {});
+  // A span that may overlap others on its thread, such as an async call
+  // from sending to its reply; shown on its own track
+  void async(const char*      name,
+             const char*      category,
+             uint64_t         startNs,
+             uint64_t         endNs,
+             std::string_view detail = {});
+
+  // Write the spans recorded so far to the output path and empty the
+  // buffer; recording resumes afterwards if it was on. False if the file
+  // could not be written.
+  bool flush();
+  // Same, to out
+  void writeJson(std::ostream& out);
+
+  size_t recorded() const;
+  size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+  enum class Kind : uint8_t
+  {
+    Complete,
+    Async
+  };
+
+  struct Event
+  {
+    const char* name;
+    const char* category;
+    uint64_t    startNs;
+    uint64_t    endNs;
+    uint64_t    id;
+    uint32_t    tid;
+    Kind        kind;
+    char        detail[DETAIL_SIZE];
+  };
+
+  Tracer() = default;
+
+  std::atomic<bool>        m_enabled{false};
+  // Recorders inside record(); flush waits for them to leave
+  std::atomic<size_t>      m_writers{0};
+  std::atomic<size_t>      m_next{0};
+  std::atomic<size_t>      m_dropped{0};
+  std::atomic<uint64_t>    m_nextAsyncId{1};
+  std::mutex               m_mutex;  // start, stop and flush
+  std::unique_ptr<Event[]> m_events;
+  size_t                   m_capacity = 0;
+  std::string              m_outputPath;
+
+  void record(Kind             kind,
+              const char*      name,
+              const char*      category,
+              uint64_t         startNs,
+              uint64_t         endNs,
+              std::string_view detail);
+  // Stop recording and wait out recorders still writing a slot
+  bool quiesce();
+  void writeJsonLocked(std::ostream& out);
+};
+
+// Records a span covering its own lifetime, if tracing was on when it was
+// created
+class TraceSpan
+{
+public:
+  TraceSpan(const char* name, const char* category, std::string_view detail)
+    : m_name(name),
+      m_category(category),
+      m_detail(detail),
+      m_start(Tracer::instance().enabled() ? Tracer::now() : 0)
+  {
+  }
+  TraceSpan(const char* name, const char* category)
+    : TraceSpan(name, category, {})
+  {
+  }
+  ~TraceSpan()
+  {
+    if (m_start != 0)
+    {
+      Tracer::instance().complete(
+        m_name, m_category, m_start, Tracer::now(), m_detail);
+    }
+  }
+
+  TraceSpan(const TraceSpan&)            = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+  const char*      m_name;
+  const char*      m_category;
+  // Only read while the span's scope, and so whatever it views, is alive
+  std::string_view m_detail;
+  uint64_t         m_start;
+};
+}  // namespace boot_module
+
+#endif  // TRACE_H
@@ -0,0 +1,68 @@
+#ifndef UUID_H
+#define UUID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace boot_module
+{
+// A 128-bit Bluetooth UUID held as two 64-bit halves, so equality is two
+// integer compares instead of a 36-character string compare.
+class Uuid
+{
+public:
+  // 00000000-0000-1000-8000-00805F9B34FB, which SIG short forms expand into
+  static constexpr uint64_t BASE_HIGH = 0x0000000000001000ULL;
+  static constexpr uint64_t BASE_LOW  = 0x800000805F9B34FBULL;
+
+  constexpr Uuid() = default;
+  constexpr Uuid(uint64_t high, uint64_t low) : m_high(high), m_low(low) {}
+
+  // 16- or 32-bit SIG assigned number expanded over the base UUID
+  static constexpr Uuid fromShort(uint32_t value)
+  {
+    return Uuid(BASE_HIGH | static_cast<uint64_t>(value) << 32, BASE_LOW);
+  }
+
+  // Accepts the canonical 36-character form BlueZ uses, the same without
+  // dashes, and 4 or 8 hex digit short forms ("180f", "0000180F"), in either
+  // case. Returns false if text is none of those.
+  static bool parse(std::string_view text, Uuid& uuid);
+
+  // Lower-case canonical form, as BlueZ reports it
+  std::string toString() const;
+  // True if this lies on the base UUID, i.e. has a 32-bit short form
+  bool        isShort() const;
+  uint64_t    high() const { return m_high; }
+  uint64_t    low() const { return m_low; }
+
+  friend constexpr bool operator==(const Uuid& a, const Uuid& b)
+  {
+    return a.m_high == b.m_high && a.m_low == b.m_low;
+  }
+  friend constexpr bool operator!=(const Uuid& a, const Uuid& b)
+  {
+    return !(a == b);
+  }
+  friend constexpr bool operator<(const Uuid& a, const Uuid& b)
+  {
+    return a.m_high != b.m_high ? a.m_high < b.m_high : a.m_low < b.m_low;
+  }
+
+private:
+  uint64_t m_high = 0;
+  uint64_t m_low  = 0;
+};
+
+// Parse every string that is a valid UUID, skipping the rest
+std::vector<Uuid> parseUuids(const std::vector<std::string>& texts);
+
+// True if any of uuids is in filter. An empty filter matches everything.
+bool matchesAny(const std::vector<Uuid>& uuids,
+                const std::vector<Uuid>& filter);
+}  // namespace boot_module
+
+#endif  // UUID_H
@@ -0,0 +1,605 @@
+#include "boot_module/batch_runner.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#include "boot_module/json.hpp"
+
+namespace boot_module
+{
+namespace
+{
+constexpr std::chrono::seconds DEFAULT_SCAN_DURATION{5};
+
+const std::map<std::string, BatchCommand::Kind> COMMANDS = {
+  {"scan", BatchCommand::Kind::Scan},
+  {"connect", BatchCommand::Kind::Connect},
+  {"disconnect", BatchCommand::Kind::Disconnect},
+  {"read", BatchCommand::Kind::Read},
+  {"write", BatchCommand::Kind::Write},
+  {"subscribe", BatchCommand::Kind::Subscribe},
+  {"unsubscribe", BatchCommand::Kind::Unsubscribe},
+  {"wait", BatchCommand::Kind::Wait}};
+
+std::string toHex(const std::vector<uint8_t>& bytes)
+{
+  static const char DIGITS[] = "0123456789abcdef";
+  std::string       hex;
+  hex.reserve(bytes.size() * 2);
+  for (uint8_t byte : bytes)
+  {
+    hex += DIGITS[byte >> 4];
+    hex += DIGITS[byte & 0x0f];
+  }
+  return hex;
+}
+
+int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  c = static_cast<char>(c | 0x20);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// "0a1b2c" or "0x0a1b2c"; an odd number of digits is malformed
+bool parseHex(std::string_view text, std::vector<uint8_t>& bytes)
+{
+  if (text.size() >= 2 && text[0] == '0' && (text[1] | 0x20) == 'x')
+  {
+    text.remove_prefix(2);
+  }
+  if (text.size() % 2 != 0)
+  {
+    return false;
+  }
+
+  bytes.clear();
+  for (size_t i = 0; i < text.size(); i += 2)
+  {
+    int high = hexDigit(text[i]);
+    int low  = hexDigit(text[i + 1]);
+    if (high < 0 || low < 0)
+    {
+      return false;
+    }
+    bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+  }
+  return true;
+}
+
+// Whole seconds or fractions of them, e.g. "2" or "0.5"
+bool parseSeconds(const std::string& text, std::chrono::milliseconds& value)
+{
+  try
+  {
+    size_t used    = 0;
+    double seconds = std::stod(text, &used);
+    if (used != text.size() || seconds < 0)
+    {
+      return false;
+    }
+    value = std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000));
+    return true;
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+bool parseAddress(const std::string& text, std::string& address)
+{
+  MacAddress mac = 0;
+  if (!parseMac(text, mac))
+  {
+    return false;
+  }
+  address = formatMac(mac);
+  return true;
+}
+
+bool parseCommand(const std::vector<std::string>& words,
+                  BatchCommand&                   command,
+                  std::string&                    error)
+{
+  auto kind = COMMANDS.find(words[0]);
+  if (kind == COMMANDS.end())
+  {
+    error = "unknown command '" + words[0] + "'";
+    return false;
+  }
+  command.kind = kind->second;
+
+  // Fixed arguments after the command name, then how many optional ones
+  size_t required = 0;
+  size_t optional = 0;
+  switch (command.kind)
+  {
+    case BatchCommand::Kind::Scan:
+      optional = SIZE_MAX;
+      break;
+    case BatchCommand::Kind::Connect:
+      required = 1;
+      optional = 1;
+      break;
+    case BatchCommand::Kind::Disconnect:
+      required = 1;
+      break;
+    case BatchCommand::Kind::Read:
+    case BatchCommand::Kind::Subscribe:
+    case BatchCommand::Kind::Unsubscribe:
+      required = 2;
+      break;
+    case BatchCommand::Kind::Write:
+      required = 3;
+      optional = 1;
+      break;
+    case BatchCommand::Kind::Wait:
+      required = 1;
+      break;
+  }
+
+  size_t arguments = words.size() - 1;
+  if (arguments < required || arguments - required > optional)
+  {
+    error = "wrong number of arguments";
+    return false;
+  }
+
+  if (command.kind == BatchCommand::Kind::Scan)
+  {
+    command.duration = DEFAULT_SCAN_DURATION;
+    if (words.size() > 1 && !parseSeconds(words[1], command.duration))
+    {
+      error = "invalid duration '" + words[1] + "'";
+      return false;
+    }
+    for (size_t i = 2; i < words.size(); i++)
+    {
+      Uuid uuid;
+      if (!Uuid::parse(words[i], uuid))
+      {
+        error = "invalid service UUID '" + words[i] + "'";
+        return false;
+      }
+      command.services.push_back(uuid);
+    }
+    return true;
+  }
+
+  if (command.kind == BatchCommand::Kind::Wait)
+  {
+    if (!parseSeconds(words[1], command.duration))
+    {
+      error = "invalid duration '" + words[1] + "'";
+      return false;
+    }
+    return true;
+  }
+
+  if (!parseAddress(words[1], command.device))
+  {
+    error = "invalid address '" + words[1] + "'";
+    return false;
+  }
+
+  if (command.kind == BatchCommand::Kind::Connect)
+  {
+    command.duration = BluetoothManager::DEFAULT_CONNECT_TIMEOUT;
+    if (words.size() > 2 && !parseSeconds(words[2], command.duration))
+    {
+      error = "invalid timeout '" + words[2] + "'";
+      return false;
+    }
+    return true;
+  }
+  if (command.kind == BatchCommand::Kind::Disconnect)
+  {
+    return true;
+  }
+
+  command.characteristic = words[2];
+  Uuid uuid;
+  if (command.characteristic[0] != '/' &&
+      !Uuid::parse(command.characteristic, uuid))
+  {
+    error = "invalid characteristic '" + command.characteristic + "'";
+    return false;
+  }
+
+  if (command.kind == BatchCommand::Kind::Write)
+  {
+    if (!parseHex(words[3], command.value))
+    {
+      error = "invalid hex value '" + words[3] + "'";
+      return false;
+    }
+    if (words.size() > 4)
+    {
+      if (words[4] == "command")
+      {
+        command.writeType = WriteType::Command;
+      }
+      else if (words[4] != "request")
+      {
+        error = "invalid write type '" + words[4] + "'";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+const char* toString(BatchCommand::Kind kind)
+{
+  for (const auto& [name, value] : COMMANDS)
+  {
+    if (value == kind)
+    {
+      return name.c_str();
+    }
+  }
+  return "unknown";
+}
+
+bool parseBatchScript(const std::string&         script,
+                      std::vector<BatchCommand>& commands,
+                      std::string&               error)
+{
+  // Comments run to the end of the line, past any ';'
+  std::string source;
+  bool        inComment = false;
+  for (char c : script)
+  {
+    inComment = c != '\n' && (inComment || c == '#');
+    if (!inComment)
+    {
+      source += c;
+    }
+  }
+
+  std::vector<BatchCommand> parsed;
+  size_t                    start = 0;
+  while (start <= source.size())
+  {
+    size_t end = source.find_first_of(";\n", start);
+    if (end == std::string::npos)
+    {
+      end = source.size();
+    }
+    std::string text = source.substr(start, end - start);
+    start            = end + 1;
+
+    std::istringstream       stream(text);
+    std::vector<std::string> words;
+    for (std::string word; stream >> word;)
+    {
+      words.push_back(word);
+    }
+    if (words.empty())
+    {
+      continue;
+    }
+
+    BatchCommand command;
+    command.index = parsed.size() + 1;
+    command.text  = text.substr(text.find_first_not_of(" \t\r"));
+    command.text.erase(command.text.find_last_not_of(" \t\r") + 1);
+    if (!parseCommand(words, command, error))
+    {
+      error = "command " + std::to_string(command.index) + " (" +
+              command.text + "): " + error;
+      return false;
+    }
+    parsed.push_back(std::move(command));
+  }
+
+  commands = std::move(parsed);
+  return true;
+}
+
+BatchRunner::BatchRunner(BluetoothManager& manager,
+                         std::ostream&     out,
+                         size_t            jobs)
+  : m_manager(manager), m_out(out), m_jobs(std::max<size_t>(jobs, 1))
+{
+}
+
+bool BatchRunner::run(const std::vector<BatchCommand>& commands)
+{
+  m_start = std::chrono::steady_clock::now();
+
+  std::vector<const BatchCommand*> stage;
+  for (const auto& command : commands)
+  {
+    if (!command.isBarrier())
+    {
+      stage.push_back(&command);
+      continue;
+    }
+    runStage(stage);
+    stage.clear();
+    runBarrier(command);
+  }
+  runStage(stage);
+
+  std::set<std::string> subscriptions;
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    subscriptions.swap(m_subscriptions);
+  }
+  for (const auto& path : subscriptions)
+  {
+    m_manager.disableNotifications(path);
+  }
+
+  std::ostringstream summary;
+  summary << std::fixed << std::setprecision(3)
+          << "{\"summary\":{\"commands\":" << commands.size()
+          << ",\"succeeded\":" << m_succeeded << ",\"failed\":" << m_failed
+          << ",\"skipped\":" << m_skipped
+          << ",\"notifications\":" << m_notifications
+          << ",\"elapsed_ms\":" << elapsedMs() << "}}";
+  emit(summary.str());
+
+  return m_failed == 0 && m_skipped == 0;
+}
+
+void BatchRunner::runStage(const std::vector<const BatchCommand*>& stage)
+{
+  // One lane per device, in order of first appearance
+  std::vector<Lane>             lanes;
+  std::map<std::string, size_t> laneOf;
+  for (const BatchCommand* command : stage)
+  {
+    auto [it, added] = laneOf.emplace(command->device, lanes.size());
+    if (added)
+    {
+      lanes.emplace_back();
+    }
+    lanes[it->second].push_back(command);
+  }
+
+  std::atomic<size_t> next{0};
+  auto                worker = [this, &lanes, &next]() {
+    for (size_t lane = next++; lane < lanes.size(); lane = next++)
+    {
+      runLane(lanes[lane]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min(m_jobs, lanes.size()); i++)
+  {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : workers)
+  {
+    thread.join();
+  }
+}
+
+void BatchRunner::runLane(const Lane& lane)
+{
+  for (const BatchCommand* command : lane)
+  {
+    bool skip = false;
+    {
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      skip = m_failedDevices.count(command->device) > 0;
+    }
+    if (skip)
+    {
+      m_skipped++;
+      report(*command, "skipped", 0, "");
+      continue;
+    }
+
+    std::string fields;
+    double      start = elapsedMs();
+    bool        ok    = execute(*command, fields);
+    double      took  = elapsedMs() - start;
+    if (ok)
+    {
+      m_succeeded++;
+    }
+    else
+    {
+      m_failed++;
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      m_failedDevices.insert(command->device);
+    }
+    report(*command, ok ? "ok" : "failed", took, fields);
+  }
+}
+
+void BatchRunner::runBarrier(const BatchCommand& command)
+{
+  double start = elapsedMs();
+  if (command.kind == BatchCommand::Kind::Wait)
+  {
+    // Subscriptions keep reporting in the meantime
+    std::this_thread::sleep_for(command.duration);
+    m_succeeded++;
+    report(command, "ok", elapsedMs() - start, "");
+    return;
+  }
+
+  DiscoveryOptions options;
+  options.services = command.services;
+  options.timeout  = command.duration;
+  auto result      = m_manager.discover(options);
+
+  std::ostringstream devices;
+  devices << ",\"devices\":[";
+  for (size_t i = 0; i < result.devices.size(); i++)
+  {
+    const auto& device = result.devices[i];
+    devices << (i ? "," : "") << "{\"address\":" << jsonString(device.address)
+            << ",\"name\":" << jsonString(device.name)
+            << ",\"rssi\":" << device.rssi << "}";
+  }
+  devices << "]";
+
+  bool ok = result.reason != DiscoveryStop::Error;
+  if (ok)
+  {
+    m_succeeded++;
+  }
+  else
+  {
+    m_failed++;
+  }
+  report(command, ok ? "ok" : "failed", elapsedMs() - start, devices.str());
+}
+
+bool BatchRunner::execute(const BatchCommand& command, std::string& fields)
+{
+  if (command.kind == BatchCommand::Kind::Connect)
+  {
+    return m_manager.connectDevice(command.device, command.duration);
+  }
+  if (command.kind == BatchCommand::Kind::Disconnect)
+  {
+    return m_manager.disconnectDevice(command.device);
+  }
+
+  std::string path;
+  if (!resolve(command.device, command.characteristic, path))
+  {
+    fields = ",\"error\":\"characteristic not found\"";
+    return false;
+  }
+  fields = ",\"path\":" + jsonString(path);
+
+  switch (command.kind)
+  {
+    case BatchCommand::Kind::Read:
+    {
+      // An empty value cannot be told apart from a failed read
+      auto value = m_manager.readCharacteristic(path);
+      fields += ",\"value\":\"" + toHex(value) + "\"";
+      return !value.empty();
+    }
+    case BatchCommand::Kind::Write:
+      return m_manager
+        .writeCharacteristicAsync(path, command.value, command.writeType)
+        .get();
+    case BatchCommand::Kind::Subscribe:
+    {
+      // Reported from the event loop thread as they arrive
+      auto onValue = [this, device = command.device,
+                      path](const std::vector<uint8_t>& value) {
+        m_notifications++;
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "{\"event\":\"notification\",\"device\":"
+             << jsonString(device) << ",\"path\":" << jsonString(path)
+             << ",\"value\":\"" << toHex(value)
+             << "\",\"time_ms\":" << elapsedMs() << "}";
+        emit(line.str());
+      };
+      if (!m_manager.enableNotifications(path, onValue, NotifyMode::Auto))
+      {
+        return false;
+      }
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      m_subscriptions.insert(path);
+      return true;
+    }
+    case BatchCommand::Kind::Unsubscribe:
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_subscriptions.erase(path);
+      }
+      return m_manager.disableNotifications(path);
+    }
+    default:
+      return false;
+  }
+}
+
+bool BatchRunner::resolve(const std::string& device,
+                          const std::string& characteristic,
+                          std::string&       path)
+{
+  if (characteristic[0] == '/')
+  {
+    path = characteristic;
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    auto deviceIt = m_paths.find(device);
+    if (deviceIt != m_paths.end())
+    {
+      auto it = deviceIt->second.find(characteristic);
+      if (it != deviceIt->second.end())
+      {
+        path = it->second;
+        return true;
+      }
+    }
+  }
+
+  Uuid wanted;
+  Uuid::parse(characteristic, wanted);
+  for (const auto& service : m_manager.getServices(device))
+  {
+    for (const auto& info : m_manager.getCharacteristics(service.handle))
+    {
+      Uuid uuid;
+      if (Uuid::parse(info.uuid, uuid) && uuid == wanted)
+      {
+        path = info.path;
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_paths[device][characteristic] = path;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void BatchRunner::report(const BatchCommand& command,
+                         const char*         status,
+                         double              took,
+                         const std::string&  fields)
+{
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(3)
+       << "{\"index\":" << command.index
+       << ",\"command\":" << jsonString(toString(command.kind));
+  if (!command.device.empty())
+  {
+    line << ",\"device\":" << jsonString(command.device);
+  }
+  line << ",\"status\":\"" << status << "\",\"elapsed_ms\":" << took
+       << fields << ",\"text\":" << jsonString(command.text) << "}";
+  emit(line.str());
+}
+
+void BatchRunner::emit(const std::string& line)
+{
+  std::lock_guard<std::mutex> lock(m_outputMutex);
+  // Flushed per line for whoever reads the output as it comes
+  m_out << line << std::endl;
+}
+
+double BatchRunner::elapsedMs() const
+{
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - m_start)
+    .count();
+}
+}  // namespace boot_module
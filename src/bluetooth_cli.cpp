@@ -1,20 +1,57 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
-#include <thread>
 
 #include "boot_module/bluetooth_cli.hpp"
+#include "boot_module/connection_manager.hpp"
+#include "boot_module/firmware_upload.hpp"
+#include "boot_module/fleet_flasher.hpp"
+#include "boot_module/trace.hpp"
 
 namespace boot_module
 {
-constexpr int      BLE_DISCOVERY_DURATION_SEC   = 3;
-constexpr uint64_t DBUS_NOTIFY_POLL_INTERVAL_MS = 20;
+constexpr std::chrono::seconds BLE_DISCOVERY_DURATION{3};
+constexpr std::chrono::seconds SERVICE_DISCOVERY_DURATION{5};
+
+namespace
+{
+// Print devices as discovery reports them
+void printDiscovered(const DeviceInfo& dev, DiscoveryEvent event)
+{
+  if (event != DiscoveryEvent::Found)
+  {
+    return;
+  }
+  std::cout << "  + " << dev.address;
+  if (!dev.name.empty())
+  {
+    std::cout << " (" << dev.name << ")";
+  }
+  std::cout << " RSSI: " << dev.rssi << " dBm" << std::endl;
+}
+
+void printScanSummary(const DiscoveryResult& result)
+{
+  std::cout << "Scan finished after "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                 result.elapsed)
+                 .count()
+            << " ms (" << toString(result.reason) << ")" << std::endl;
+}
+}  // namespace
 
 BluetoothCLI::BluetoothCLI() : m_running(true), m_connectedDevice("")
 {
   try
   {
     m_manager = std::make_unique<BluetoothManager>();
+    // Signals (notifications, disconnects) are dispatched on the manager's
+    // own thread from here on
+    m_manager->startEventLoop();
   }
   catch (const std::exception& e)
   {
@@ -66,6 +103,24 @@ void BluetoothCLI::run()
       case 11:
         disableNotifications();
         break;
+      case 12:
+        connectMultipleDevices();
+        break;
+      case 13:
+        showStatistics();
+        break;
+      case 14:
+        writeTrace();
+        break;
+      case 15:
+        captureNotifications();
+        break;
+      case 16:
+        uploadFirmware();
+        break;
+      case 17:
+        flashFleet();
+        break;
       case 0:
         m_running = false;
         std::cout << "Exiting..." << std::endl;
@@ -90,6 +145,12 @@ void BluetoothCLI::printMainMenu()
   std::cout << "9.  Write to characteristic" << std::endl;
   std::cout << "10. Enable notifications" << std::endl;
   std::cout << "11. Disable notifications" << std::endl;
+  std::cout << "12. Connect to multiple devices" << std::endl;
+  std::cout << "13. Show statistics" << std::endl;
+  std::cout << "14. Write trace file" << std::endl;
+  std::cout << "15. Capture notifications to file" << std::endl;
+  std::cout << "16. Upload firmware image" << std::endl;
+  std::cout << "17. Flash devices from manifest" << std::endl;
   std::cout << "0.  Exit" << std::endl;
   std::cout << "Choice: ";
 }
@@ -99,14 +160,19 @@ int BluetoothCLI::getChoice()
   std::string input;
   std::getline(std::cin, input);
 
-  try
-  {
-    return std::stoi(input);
-  }
-  catch (...)
+  // Anything but a plain non-negative number is an invalid choice
+  if (input.empty() || input.size() > 9 ||
+      input.find_first_not_of("0123456789") != std::string::npos)
   {
     return -1;
   }
+  return std::stoi(input);
+}
+
+int BluetoothCLI::getNumber(const std::string& prompt)
+{
+  std::cout << prompt;
+  return getChoice();
 }
 
 std::string BluetoothCLI::getInput(const std::string& prompt)
@@ -120,12 +186,12 @@ std::string BluetoothCLI::getInput(const std::string& prompt)
 void BluetoothCLI::scanDevices()
 {
   std::cout << "\nStarting device scan..." << std::endl;
-  m_manager->startDiscovery();
 
-  std::cout << "Scanning for BLE devices ..." << std::endl;
-  std::this_thread::sleep_for(std::chrono::seconds(BLE_DISCOVERY_DURATION_SEC));
+  DiscoveryOptions options;
+  options.timeout = BLE_DISCOVERY_DURATION;
 
-  m_manager->stopDiscovery();
+  std::cout << "Scanning for BLE devices ..." << std::endl;
+  printScanSummary(m_manager->discover(options, printDiscovered));
 
   m_cachedDevices = m_manager->getDevices();
 
@@ -167,21 +233,52 @@ void BluetoothCLI::scanDevices()
 
 void BluetoothCLI::scanDevicesWithService()
 {
-  std::string serviceUUID = getInput(
-    "Enter service UUID (e.g., 0000180f-0000-1000-8000-00805f9b34fb): ");
+  std::string line = getInput(
+    "Enter service UUIDs separated by spaces (e.g., "
+    "0000180f-0000-1000-8000-00805f9b34fb or 180f): ");
 
-  std::cout << "\nStarting device scan with service filter..." << std::endl;
-  m_manager->startDiscovery(serviceUUID);
+  DiscoveryOptions options;
+  options.timeout = SERVICE_DISCOVERY_DURATION;
+
+  std::istringstream input(line);
+  std::string        text;
+  while (input >> text)
+  {
+    Uuid uuid;
+    if (!Uuid::parse(text, uuid))
+    {
+      std::cout << "Invalid service UUID: " << text << std::endl;
+      return;
+    }
+    options.services.push_back(uuid);
+  }
+  if (options.services.empty())
+  {
+    std::cout << "No service UUID given." << std::endl;
+    return;
+  }
 
-  std::cout << "Scanning for 5 seconds..." << std::endl;
-  std::this_thread::sleep_for(std::chrono::seconds(5));
+  std::string limit =
+    getInput("Stop after how many matches (Enter to scan for 5 seconds): ");
+  if (!limit.empty())
+  {
+    try
+    {
+      options.maxDevices = std::stoul(limit);
+    }
+    catch (...)
+    {
+      std::cout << "Invalid number, scanning for 5 seconds." << std::endl;
+    }
+  }
 
-  m_manager->stopDiscovery();
+  std::cout << "\nStarting device scan with service filter..." << std::endl;
+  printScanSummary(m_manager->discover(options, printDiscovered));
 
-  m_cachedDevices = m_manager->getDevices(serviceUUID);
+  m_cachedDevices = m_manager->getDevices(options.services);
 
   std::cout << "\nFound " << m_cachedDevices.size()
-            << " device(s) with service " << serviceUUID << ":" << std::endl;
+            << " device(s) advertising " << line << ":" << std::endl;
   for (size_t i = 0; i < m_cachedDevices.size(); i++)
   {
     const auto& dev = m_cachedDevices[i];
@@ -216,7 +313,7 @@ void BluetoothCLI::connectToDevice()
     std::cout << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect device number: "));
+  int choice = getNumber("\nSelect device number: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedDevices.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -224,12 +321,12 @@ void BluetoothCLI::connectToDevice()
   }
 
   const auto& device = m_cachedDevices[choice - 1];
+  TraceSpan   span("connectToDevice", "cli", device.address);
   if (m_manager->connectDevice(device.address))
   {
     m_connectedDevice = device.address;
 
-    // Give time for services to be read from BLE device
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    // connectDevice returns once ServicesResolved is set
     m_cachedServices = m_manager->getServices(m_connectedDevice);
 
     // Register disconnect handler
@@ -244,10 +341,12 @@ void BluetoothCLI::connectToDevice()
         std::cout << "Cleaned up after disconnect.\n";
       });
 
-    // TODO - this doesn't seem to be working
-    // Request MTU of 250 bytes
-    std::cout << "Requesting MTU of 250 bytes..." << std::endl;
-    m_manager->requestMTU(device.address, 250);
+    // BlueZ has exchanged the MTU by now; it sizes every chunked write
+    uint16_t mtu = m_manager->getMtu(device.address);
+    if (mtu > 0)
+    {
+      std::cout << "MTU: " << mtu << " bytes" << std::endl;
+    }
 
     std::cout << "Successfully connected to " << device.address << std::endl;
   }
@@ -257,6 +356,97 @@ void BluetoothCLI::connectToDevice()
   }
 }
 
+void BluetoothCLI::connectMultipleDevices()
+{
+  std::string line = getInput(
+    "\nEnter device addresses separated by spaces (blank for all scanned): ");
+
+  std::vector<std::string> addresses;
+  std::istringstream       input(line);
+  std::string              address;
+  while (input >> address)
+  {
+    MacAddress mac;
+    if (!parseMac(address, mac))
+    {
+      std::cout << "Skipping invalid address: " << address << std::endl;
+      continue;
+    }
+    if (!m_manager->devices().contains(mac))
+    {
+      std::cout << "Note: " << address << " has not been seen by a scan"
+                << std::endl;
+    }
+    addresses.push_back(address);
+  }
+
+  if (addresses.empty())
+  {
+    for (const auto& dev : m_cachedDevices)
+    {
+      addresses.push_back(dev.address);
+    }
+  }
+  if (addresses.empty())
+  {
+    std::cout << "No devices given and none cached. Please scan first."
+              << std::endl;
+    return;
+  }
+
+  size_t      parallelism = ConnectionManager::DEFAULT_PARALLELISM;
+  std::string limit =
+    getInput("Parallel connects [" + std::to_string(parallelism) + "]: ");
+  if (!limit.empty())
+  {
+    try
+    {
+      parallelism = std::max(1, std::stoi(limit));
+    }
+    catch (...)
+    {
+      std::cout << "Invalid number, using " << parallelism << std::endl;
+    }
+  }
+
+  std::cout << "Connecting " << addresses.size() << " devices, "
+            << parallelism << " at a time..." << std::endl;
+
+  ConnectionManager connections(*m_manager, parallelism);
+  auto              devices = connections.connectAll(
+    addresses, [](const DeviceConnection& device) {
+      std::cout << "  " << device.address << ": " << toString(device.state)
+                << std::endl;
+    });
+
+  std::cout << "\nAddress            State       Time to ready" << std::endl;
+  for (const auto& device : devices)
+  {
+    std::cout << std::left << std::setw(19) << device.address << std::setw(12)
+              << toString(device.state);
+    if (device.state == DeviceState::Ready)
+    {
+      std::cout << device.timeToReady().count() / 1000 << " ms";
+    }
+    std::cout << std::right << std::endl;
+  }
+
+  // Single-device commands act on the first device that came up
+  if (m_connectedDevice.empty())
+  {
+    for (const auto& device : devices)
+    {
+      if (device.state == DeviceState::Ready)
+      {
+        m_connectedDevice = device.address;
+        m_cachedServices  = m_manager->getServices(m_connectedDevice);
+        std::cout << "Active device: " << m_connectedDevice << std::endl;
+        break;
+      }
+    }
+  }
+}
+
 void BluetoothCLI::disconnectFromDevice()
 {
   if (m_connectedDevice.empty())
@@ -298,7 +488,7 @@ void BluetoothCLI::forgetDevice()
     std::cout << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect device number to forget: "));
+  int choice = getNumber("\nSelect device number to forget: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedDevices.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -358,13 +548,13 @@ void BluetoothCLI::listCharacteristics()
     std::cout << i + 1 << ". " << m_cachedServices[i].uuid << std::endl;
   }
 
-  bool     all_services = false;
-  uint32_t choice       = std::stoul(getInput("\nSelect service number: "));
+  bool all_services = false;
+  int  choice       = getNumber("\nSelect service number: ");
   if (choice == 0)
   {
     all_services = true;
   }
-  else if (choice > static_cast<uint32_t>(m_cachedServices.size()))
+  else if (choice < 0 || choice > static_cast<int>(m_cachedServices.size()))
   {
     std::cout << "Invalid selection." << std::endl;
     return;
@@ -428,7 +618,7 @@ void BluetoothCLI::readCharacteristic()
     std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect characteristic number: "));
+  int choice = getNumber("\nSelect characteristic number: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedCharacteristics.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -462,7 +652,7 @@ void BluetoothCLI::writeCharacteristic()
     std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect characteristic number: "));
+  int choice = getNumber("\nSelect characteristic number: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedCharacteristics.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -479,15 +669,15 @@ void BluetoothCLI::writeCharacteristic()
   std::string        byteStr;
   while (iss >> byteStr)
   {
-    try
-    {
-      data.push_back(static_cast<uint8_t>(std::stoi(byteStr, nullptr, 16)));
-    }
-    catch (...)
+    // One or two hex digits per byte; stoi alone would accept "1ff" or "7z"
+    if (byteStr.size() > 2 ||
+        byteStr.find_first_not_of("0123456789abcdefABCDEF") !=
+          std::string::npos)
     {
       std::cout << "Invalid hex value: " << byteStr << std::endl;
       return;
     }
+    data.push_back(static_cast<uint8_t>(std::stoi(byteStr, nullptr, 16)));
   }
 
   if (m_manager->writeCharacteristic(characteristic.path, data))
@@ -515,7 +705,7 @@ void BluetoothCLI::enableNotifications()
     std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect characteristic number: "));
+  int choice = getNumber("\nSelect characteristic number: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedCharacteristics.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -524,41 +714,46 @@ void BluetoothCLI::enableNotifications()
 
   const auto& characteristic = m_cachedCharacteristics[choice - 1];
 
-  auto callback = [](const std::vector<uint8_t>& data) {
-    std::cout << "\n>>> Notification received (" << data.size() << " bytes): ";
-    for (uint8_t byte : data)
+  // Runs on the ring's consumer thread, so a slow terminal only costs
+  // dropped notifications here instead of stalling all other signals
+  auto consumer = [this](const NotificationView& data) {
+    // Only echo while the listening view is open
+    if (!m_notifyActive)
+    {
+      return;
+    }
+
+    std::cout << "\n>>> Notification received (" << data.size << " bytes): ";
+    for (size_t i = 0; i < data.size; i++)
     {
       std::cout << std::hex << std::setw(2) << std::setfill('0')
-                << static_cast<int>(byte) << " ";
+                << static_cast<int>(data.data[i]) << " ";
     }
     std::cout << std::dec << std::endl;
     std::cout << ">>> ";
     std::cout.flush();
   };
 
-  if (m_manager->enableNotifications(characteristic.path, callback))
+  if (m_manager->enableRingNotifications(
+        characteristic.path, consumer, RingOptions{}, NotifyMode::Auto))
   {
     m_notifyActive = true;
     std::cout << "Notifications enabled. Listening for notifications from: "
               << characteristic.uuid << std::endl;
     std::cout << "Press Enter to return to menu..." << std::endl;
 
-    // Start a thread to process events
-    std::thread eventThread([this]() {
-      while (m_notifyActive)
-      {
-        m_manager->processEvents(100);
-        std::this_thread::sleep_for(
-          std::chrono::milliseconds(DBUS_NOTIFY_POLL_INTERVAL_MS));
-      }
-    });
-
-    // Wait for user input
+    // Notifications arrive on a background thread; wait for user input
     std::string dummy;
     std::getline(std::cin, dummy);
 
     m_notifyActive = false;
-    eventThread.join();
+
+    auto stats = m_manager->ringStats(characteristic.path);
+    if (stats.dropped > 0)
+    {
+      std::cout << stats.dropped << " of " << stats.pushed
+                << " notifications dropped (terminal too slow)" << std::endl;
+    }
   }
   else
   {
@@ -581,7 +776,7 @@ void BluetoothCLI::disableNotifications()
     std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
   }
 
-  int choice = std::stoi(getInput("\nSelect characteristic number: "));
+  int choice = getNumber("\nSelect characteristic number: ");
   if (choice < 1 || choice > static_cast<int>(m_cachedCharacteristics.size()))
   {
     std::cout << "Invalid selection." << std::endl;
@@ -599,4 +794,269 @@ void BluetoothCLI::disableNotifications()
     std::cout << "Failed to disable notifications." << std::endl;
   }
 }
+
+void BluetoothCLI::showStatistics()
+{
+  auto snapshot = m_manager->metricsSnapshot();
+  auto toUs     = [](double ns) { return ns / 1000.0; };
+
+  std::cout << "\nD-Bus calls (latency in us):" << std::endl;
+  std::cout << std::left << std::setw(18) << "Operation" << std::right
+            << std::setw(8) << "Count" << std::setw(8) << "Errors"
+            << std::setw(10) << "Mean" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "Max" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  for (size_t op = 0; op < OPERATION_COUNT; op++)
+  {
+    const auto& stats = snapshot.operations[op];
+    if (stats.count == 0)
+    {
+      continue;
+    }
+    std::cout << std::left << std::setw(18)
+              << toString(static_cast<Operation>(op)) << std::right
+              << std::setw(8) << stats.count << std::setw(8) << stats.errors
+              << std::setw(10) << toUs(stats.meanNs()) << std::setw(10)
+              << toUs(stats.percentileNs(50)) << std::setw(10)
+              << toUs(stats.percentileNs(99)) << std::setw(10)
+              << toUs(stats.maxNs) << std::endl;
+  }
+  std::cout << std::defaultfloat << std::setprecision(6);
+
+  if (snapshot.characteristics.empty())
+  {
+    return;
+  }
+  std::cout << "\nNotifications:" << std::endl;
+  for (const auto& characteristic : snapshot.characteristics)
+  {
+    std::cout << "  " << characteristic.path << ": "
+              << characteristic.notifications << " ("
+              << characteristic.bytes << " bytes)" << std::endl;
+  }
+}
+
+void BluetoothCLI::captureNotifications()
+{
+  if (m_cachedCharacteristics.empty())
+  {
+    std::cout << "No characteristics cached. Please list characteristics first."
+              << std::endl;
+    return;
+  }
+
+  std::cout << "\nAvailable characteristics:" << std::endl;
+  for (size_t i = 0; i < m_cachedCharacteristics.size(); i++)
+  {
+    std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
+  }
+
+  int choice = getNumber("\nSelect characteristic number: ");
+  if (choice < 1 || choice > static_cast<int>(m_cachedCharacteristics.size()))
+  {
+    std::cout << "Invalid selection." << std::endl;
+    return;
+  }
+
+  const auto& characteristic = m_cachedCharacteristics[choice - 1];
+
+  std::string prefix = getInput("Capture file prefix: ");
+  if (prefix.empty())
+  {
+    std::cout << "Invalid prefix." << std::endl;
+    return;
+  }
+
+  std::shared_ptr<CaptureLog> log = CaptureLog::create(prefix);
+  if (!log)
+  {
+    return;
+  }
+
+  if (!m_manager->captureNotifications(characteristic.path, log))
+  {
+    std::cout << "Failed to enable notifications." << std::endl;
+    return;
+  }
+  std::cout << "Capturing notifications to " << log->segmentPath(0)
+            << std::endl;
+  std::cout << "Press Enter to stop..." << std::endl;
+
+  std::string dummy;
+  std::getline(std::cin, dummy);
+
+  m_manager->disableNotifications(characteristic.path);
+  log->close();
+
+  auto stats = log->stats();
+  std::cout << stats.records << " notifications (" << stats.bytes
+            << " bytes) in " << stats.segments << " segment(s)";
+  if (stats.dropped > 0)
+  {
+    std::cout << ", " << stats.dropped << " dropped";
+  }
+  std::cout << std::endl;
+}
+
+void BluetoothCLI::uploadFirmware()
+{
+  if (m_cachedCharacteristics.empty())
+  {
+    std::cout << "No characteristics cached. Please list characteristics first."
+              << std::endl;
+    return;
+  }
+
+  std::string path  = getInput("Image file: ");
+  auto        image = FirmwareImage::open(path);
+  if (!image)
+  {
+    return;
+  }
+
+  std::cout << "\nAvailable characteristics:" << std::endl;
+  for (size_t i = 0; i < m_cachedCharacteristics.size(); i++)
+  {
+    std::cout << i + 1 << ". " << m_cachedCharacteristics[i].uuid << std::endl;
+  }
+  int data   = getNumber("\nData characteristic number: ");
+  int status = getNumber("Status characteristic number: ");
+  int count  = static_cast<int>(m_cachedCharacteristics.size());
+  if (data < 1 || data > count || status < 1 || status > count)
+  {
+    std::cout << "Invalid selection." << std::endl;
+    return;
+  }
+
+  UploadOptions options;
+  options.dataPath   = m_cachedCharacteristics[data - 1].path;
+  options.statusPath = m_cachedCharacteristics[status - 1].path;
+
+  // Offer to pick up where an interrupted upload of the same image stopped
+  if (m_resumeImage == path && m_resumeOffset < image->size())
+  {
+    std::string answer = getInput("Resume from byte " +
+                                  std::to_string(m_resumeOffset) +
+                                  "? (y/n): ");
+    if (answer == "y" || answer == "Y")
+    {
+      options.startOffset = m_resumeOffset;
+    }
+  }
+
+  options.progress = [](const UploadProgress& progress) {
+    std::cout << "\r" << progress.acknowledged << " / " << progress.total
+              << " bytes (" << progress.acknowledged * 100 / progress.total
+              << "%), " << static_cast<size_t>(progress.bytesPerSecond / 1024)
+              << " KiB/s   " << std::flush;
+  };
+
+  std::cout << "Uploading " << image->size() << " bytes..." << std::endl;
+  FirmwareUploader uploader(*m_manager);
+  auto             result = uploader.upload(*image, options);
+  std::cout << std::endl;
+
+  std::cout << "Upload " << toString(result.status) << " after "
+            << result.elapsed.count() << " ms: " << result.packets
+            << " packets of up to " << result.chunkSize << " bytes";
+  if (result.retransmitted > 0)
+  {
+    std::cout << ", " << result.retransmitted << " bytes resent";
+  }
+  std::cout << std::endl;
+
+  if (result.ok())
+  {
+    m_resumeImage.clear();
+  }
+  else if (result.status == UploadStatus::Disconnected ||
+           result.status == UploadStatus::TimedOut)
+  {
+    m_resumeImage  = path;
+    m_resumeOffset = result.acknowledged;
+    std::cout << "Reconnect and upload the same image to resume." << std::endl;
+  }
+}
+
+void BluetoothCLI::flashFleet()
+{
+  std::ifstream file(getInput("Manifest file (ADDRESS IMAGE per line): "));
+  if (!file)
+  {
+    std::cout << "Cannot open manifest." << std::endl;
+    return;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+
+  std::vector<FleetJob> jobs;
+  std::string           error;
+  if (!parseFleetManifest(text.str(), jobs, error))
+  {
+    std::cout << "Invalid manifest: " << error << std::endl;
+    return;
+  }
+
+  FleetOptions options;
+  if (!Uuid::parse(getInput("Data characteristic UUID: "),
+                   options.dataCharacteristic) ||
+      !Uuid::parse(getInput("Status characteristic UUID: "),
+                   options.statusCharacteristic))
+  {
+    std::cout << "Invalid UUID." << std::endl;
+    return;
+  }
+
+  std::string limit = getInput("Devices at once [" +
+                               std::to_string(options.parallelism) + "]: ");
+  if (!limit.empty())
+  {
+    try
+    {
+      options.parallelism = std::max(1, std::stoi(limit));
+    }
+    catch (...)
+    {
+      std::cout << "Invalid number, using " << options.parallelism
+                << std::endl;
+    }
+  }
+
+  std::cout << "Flashing " << jobs.size() << " device(s), "
+            << options.parallelism << " at a time..." << std::endl;
+  std::mutex   outputMutex;
+  FleetFlasher flasher(*m_manager, options);
+  auto         report =
+    flasher.run(jobs, [&outputMutex](const FleetDeviceResult& result) {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cout << result.address << ": " << toString(result.status)
+                << " after " << result.attempts << " attempt(s)"
+                << std::endl;
+    });
+  std::cout << std::endl;
+  report.writeText(std::cout);
+}
+
+void BluetoothCLI::writeTrace()
+{
+  auto& tracer = Tracer::instance();
+  if (!tracer.enabled())
+  {
+    std::cout << "Tracing is off; start with --trace FILE to record one."
+              << std::endl;
+    return;
+  }
+
+  size_t recorded = tracer.recorded();
+  size_t dropped  = tracer.dropped();
+  if (tracer.flush())
+  {
+    std::cout << recorded << " spans written";
+    if (dropped > 0)
+    {
+      std::cout << ", " << dropped << " dropped (buffer full)";
+    }
+    std::cout << std::endl;
+  }
+}
 };  // namespace boot_module
@@ -2,83 +2,260 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <poll.h>
+
 #include <iostream>
+#include <optional>
 #include <thread>
 
+#include "boot_module/bluez_constants.hpp"
+#include "boot_module/characteristic_writer.hpp"
+#include "boot_module/trace.hpp"
+
 namespace boot_module
 {
-// BlueZ D-Bus constants
-const std::string BLUEZ_SERVICE          = "org.bluez";
-const std::string ADAPTER_INTERFACE      = "org.bluez.Adapter1";
-const std::string DEVICE_INTERFACE       = "org.bluez.Device1";
-const std::string GATT_SERVICE_INTERFACE = "org.bluez.GattService1";
-const std::string GATT_CHAR_INTERFACE    = "org.bluez.GattCharacteristic1";
-const std::string PROPERTIES_INTERFACE   = "org.freedesktop.DBus.Properties";
-const std::string OBJECT_MANAGER_INTERFACE =
-  "org.freedesktop.DBus.ObjectManager";
-
 const bool        USE_DEFAULT_ADAPTER  = true;
 const std::string DEFAULT_ADAPTER_PATH = "/org/bluez/hci1";
+// Longest a batch write waits for the next WriteValue reply
+const std::chrono::seconds WRITE_REPLY_TIMEOUT{10};
 
-BluetoothManager::BluetoothManager()
+namespace
 {
-  m_connection  = sdbus::createSystemBusConnection();
-  m_adapterPath = findAdapter();
+// Adapt a callback-style async operation to a future
+template <typename T, typename Start>
+std::future<T> toFuture(Start&& start)
+{
+  auto promise = std::make_shared<std::promise<T>>();
+  auto future  = promise->get_future();
+  start([promise](T value) { promise->set_value(std::move(value)); });
+  return future;
+}
 
-  if (m_adapterPath.empty())
+// Read Value out of a GattCharacteristic1 PropertiesChanged signal straight
+// into value, whose capacity is reused, and MTU into mtu if BlueZ reports a
+// new one. Other changed properties are skipped and invalidated ones are
+// never read. Returns false if Value is absent.
+bool decodeValueChange(sdbus::Signal&        signal,
+                       std::vector<uint8_t>& value,
+                       uint16_t&             mtu)
+{
+  char* interface = nullptr;
+  signal >> interface;
+  if (interface == nullptr || GATT_CHAR_INTERFACE != interface)
   {
-    throw std::runtime_error("No Bluetooth adapter found");
+    return false;
   }
 
-  std::cout << "Using Bluetooth adapter: " << m_adapterPath << std::endl;
+  bool found = false;
+  signal.enterDictionary("sv");
+  while (signal.enterDictEntry("sv"))
+  {
+    char* name = nullptr;
+    signal >> name;
+    if (std::strcmp(name, "Value") == 0)
+    {
+      signal.enterVariant("ay");
+      signal >> value;
+      signal.exitVariant();
+      found = true;
+    }
+    else if (std::strcmp(name, "MTU") == 0)
+    {
+      signal.enterVariant("q");
+      signal >> mtu;
+      signal.exitVariant();
+    }
+    else
+    {
+      // Notifying and friends; rare, so the allocation does not matter
+      sdbus::Variant skipped;
+      signal >> skipped;
+    }
+    signal.exitDictEntry();
+  }
+  // Reaching the end of the dictionary leaves the message in a failed state
+  signal.clearFlags();
+  signal.exitDictionary();
+  return found;
 }
 
-BluetoothManager::~BluetoothManager()
+// MTU out of a GattCharacteristic1 PropertiesChanged signal, or 0. Stops at
+// Value without reading it: that signal is a notification, whose subscriber
+// decodes MTU from it anyway, and the payload is not worth copying here.
+uint16_t decodeMtuChange(sdbus::Message& signal)
 {
-  stopDiscovery();
+  char* interface = nullptr;
+  signal >> interface;
+
+  uint16_t mtu = 0;
+  signal.enterDictionary("sv");
+  while (signal.enterDictEntry("sv"))
+  {
+    char* name = nullptr;
+    signal >> name;
+    if (std::strcmp(name, "Value") == 0)
+    {
+      // The message is dropped after this, so it can be left mid-dictionary
+      return 0;
+    }
+    if (std::strcmp(name, "MTU") == 0)
+    {
+      signal.enterVariant("q");
+      signal >> mtu;
+      signal.exitVariant();
+    }
+    else
+    {
+      sdbus::Variant skipped;
+      signal >> skipped;
+    }
+    signal.exitDictEntry();
+  }
+  signal.clearFlags();
+  signal.exitDictionary();
+  return mtu;
 }
+}  // namespace
 
-std::string BluetoothManager::findAdapter()
+const char* toString(DiscoveryStop reason)
 {
-  try
+  switch (reason)
   {
-    // auto proxy = sdbus::createProxy(*m_connection, BLUEZ_SERVICE,
-    // std::string("/"));
-    auto proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), sdbus::ObjectPath{"/"});
+    case DiscoveryStop::Timeout:
+      return "timeout";
+    case DiscoveryStop::DeviceCount:
+      return "device count";
+    case DiscoveryStop::TargetFound:
+      return "target found";
+    case DiscoveryStop::Predicate:
+      return "predicate";
+    case DiscoveryStop::Error:
+      return "error";
+  }
+  return "unknown";
+}
 
-    std::map<sdbus::ObjectPath,
-             std::map<std::string, std::map<std::string, sdbus::Variant>>>
-      objects;
-    proxy->callMethod("GetManagedObjects")
-      .onInterface(OBJECT_MANAGER_INTERFACE)
-      .storeResultsTo(objects);
+BluetoothManager::BluetoothManager()
+  : BluetoothManager(sdbus::createSystemBusConnection())
+{
+}
 
-    // if default path available, then try to use it
-    for (const auto& [path, interfaces] : objects)
-    {
-      if (USE_DEFAULT_ADAPTER &&
-          (path == sdbus::ObjectPath{DEFAULT_ADAPTER_PATH}))
+BluetoothManager::BluetoothManager(
+  std::unique_ptr<sdbus::IConnection> connection)
+  : m_connection(std::move(connection))
+{
+  m_metrics     = std::make_shared<Metrics>();
+  m_objectTree  = std::make_unique<ObjectTree>(*m_connection, m_metrics.get());
+  m_proxyPool   = std::make_unique<ProxyPool>(*m_connection);
+  m_devices     = std::make_unique<DeviceRegistry>();
+  m_gatt        = std::make_unique<GattIndex>();
+  m_adapterPath = findAdapter();
+
+  // Pooled proxies for objects that went away, or for anything below a
+  // device that disconnected, would only pin dead paths
+  m_treeListener = m_objectTree->addListener(
+    [this](ObjectTree::Change change,
+           const std::string& path,
+           const std::string& interface,
+           const PropertyMap& props) {
+      if (interface == DEVICE_INTERFACE)
       {
-        return path;
+        updateDeviceRegistry(change, path, props);
+      }
+      else
+      {
+        m_gatt->apply(change, path, interface, props);
       }
-    }
 
-    // otherwise return the first adapter found
-    for (const auto& [path, interfaces] : objects)
-    {
-      if (interfaces.find(ADAPTER_INTERFACE) != interfaces.end())
+      notifyWaiters();
+      checkReadyWaiters();
+
+      if (change == ObjectTree::Change::InterfacesRemoved)
       {
-        return path;
+        m_proxyPool->evict(path);
       }
-    }
+      else if (change == ObjectTree::Change::PropertiesChanged &&
+               interface == DEVICE_INTERFACE && props.count("Connected") &&
+               !props.at("Connected").get<bool>())
+      {
+        m_proxyPool->evictSubtree(path + "/");
+        // The next connection exchanges its own MTU
+        GattHandle                  device = m_gatt->find(path);
+        std::lock_guard<std::mutex> lock(m_mtuMutex);
+        m_mtus.erase(device);
+      }
+    });
+
+  // The object tree leaves GattCharacteristic1 out, and a Value subscriber
+  // only sees its own characteristic, so follow MTU changes on any of them
+  m_mtuSlot = m_connection->addMatch(
+    "type='signal',sender='" + BLUEZ_SERVICE + "',interface='" +
+      PROPERTIES_INTERFACE + "',member='PropertiesChanged',path_namespace='" +
+      BLUEZ_ROOT_PATH + "',arg0='" + GATT_CHAR_INTERFACE + "'",
+    [this](sdbus::Message message) { onCharacteristicChanged(message); },
+    sdbus::return_slot);
+
+  // Seeded after the listener is in place so no change is missed; seeding
+  // an object twice is harmless
+  m_objectTree->forEach(
+    DEVICE_INTERFACE, "/", [this](const std::string& path, auto& props) {
+      m_devices->upsert(path, props);
+    });
+  for (const auto& interface : {GATT_SERVICE_INTERFACE, GATT_CHAR_INTERFACE})
+  {
+    m_objectTree->forEach(
+      interface, "/", [this, &interface](const std::string& path, auto& props) {
+        m_gatt->apply(
+          ObjectTree::Change::InterfacesAdded, path, interface, props);
+      });
   }
-  catch (const sdbus::Error& e)
+
+  if (m_adapterPath.empty())
+  {
+    throw std::runtime_error("No Bluetooth adapter found");
+  }
+
+  std::cout << "Using Bluetooth adapter: " << m_adapterPath << std::endl;
+
+  m_readyTimer = std::thread([this] { runReadyTimer(); });
+}
+
+BluetoothManager::~BluetoothManager()
+{
+  stopDiscovery();
+  stopEventLoop();
+  {
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+    m_readyTimerStop = true;
+  }
+  m_readyCondition.notify_all();
+  m_readyTimer.join();
+  checkReadyWaiters(true);
+  m_notifyReader.reset();
+  m_mtuSlot.reset();
+  m_objectTree->removeListener(m_treeListener);
+}
+
+std::string BluetoothManager::findAdapter()
+{
+  // if default path available, then try to use it
+  if (USE_DEFAULT_ADAPTER &&
+      m_objectTree->hasInterface(DEFAULT_ADAPTER_PATH, ADAPTER_INTERFACE))
   {
-    std::cerr << "Error finding adapter: " << e.what() << std::endl;
+    return DEFAULT_ADAPTER_PATH;
   }
 
-  return "";
+  // otherwise return the first adapter found
+  std::string adapterPath;
+  m_objectTree->forEach(
+    ADAPTER_INTERFACE, "/", [&adapterPath](const std::string& path, auto&) {
+      if (adapterPath.empty())
+      {
+        adapterPath = path;
+      }
+    });
+  return adapterPath;
 }
 
 std::string BluetoothManager::getAdapterPath()
@@ -86,20 +263,49 @@ std::string BluetoothManager::getAdapterPath()
   return m_adapterPath;
 }
 
-void BluetoothManager::startDiscovery(const std::string& serviceUUID)
+MetricsSnapshot BluetoothManager::metricsSnapshot() const
+{
+  return m_metrics->snapshot();
+}
+
+ProxyPoolStats BluetoothManager::proxyPoolStats() const
+{
+  return m_proxyPool->stats();
+}
+
+bool BluetoothManager::startDiscovery(const std::string& serviceUUID)
+{
+  std::vector<Uuid> services;
+  if (!serviceUUID.empty())
+  {
+    Uuid uuid;
+    if (!Uuid::parse(serviceUUID, uuid))
+    {
+      std::cerr << "Invalid service UUID: " << serviceUUID << std::endl;
+      return false;
+    }
+    services.push_back(uuid);
+  }
+  return startDiscovery(services);
+}
+
+bool BluetoothManager::startDiscovery(const std::vector<Uuid>& services)
 {
+  TraceSpan span("startDiscovery", "manager");
   try
   {
-    auto adapter = sdbus::createProxy(*m_connection,
-                                      sdbus::ServiceName(BLUEZ_SERVICE),
-                                      sdbus::ObjectPath(m_adapterPath));
+    auto adapter = m_proxyPool->get(m_adapterPath);
 
-    // Set discovery filter if service UUID is provided
-    if (!serviceUUID.empty())
+    // Set discovery filter if service UUIDs are provided
+    if (!services.empty())
     {
+      std::vector<std::string> uuids;
+      for (const auto& uuid : services)
+      {
+        uuids.push_back(uuid.toString());
+      }
       std::map<std::string, sdbus::Variant> filter;
-      std::vector<std::string>              uuids = {serviceUUID};
-      filter["UUIDs"]                             = sdbus::Variant(uuids);
+      filter["UUIDs"] = sdbus::Variant(uuids);
 
       adapter->callMethod("SetDiscoveryFilter")
         .onInterface(ADAPTER_INTERFACE)
@@ -108,23 +314,21 @@ void BluetoothManager::startDiscovery(const std::string& serviceUUID)
 
     adapter->callMethod("StartDiscovery").onInterface(ADAPTER_INTERFACE);
     std::cout << "Discovery started" << std::endl;
-
-    // Give some time for devices to be discovered
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
   }
   catch (const sdbus::Error& e)
   {
     std::cerr << "Error starting discovery: " << e.what() << std::endl;
+    return false;
   }
 }
 
 void BluetoothManager::stopDiscovery()
 {
+  TraceSpan span("stopDiscovery", "manager");
   try
   {
-    auto adapter = sdbus::createProxy(*m_connection,
-                                      sdbus::ServiceName(BLUEZ_SERVICE),
-                                      sdbus::ObjectPath(m_adapterPath));
+    auto adapter = m_proxyPool->get(m_adapterPath);
     adapter->callMethod("StopDiscovery").onInterface(ADAPTER_INTERFACE);
     std::cout << "Discovery stopped" << std::endl;
   }
@@ -134,28 +338,185 @@ void BluetoothManager::stopDiscovery()
   }
 }
 
+DiscoveryResult BluetoothManager::discover(const DiscoveryOptions& options,
+                                           DiscoveryCallback       onDevice)
+{
+  TraceSpan span("discover", "manager");
+
+  // Compared as a MacAddress so the case and separator of the option do not
+  // matter
+  std::optional<MacAddress> target;
+  if (!options.targetAddress.empty())
+  {
+    MacAddress mac;
+    if (!parseMac(options.targetAddress, mac))
+    {
+      std::cerr << "Invalid target address: " << options.targetAddress
+                << std::endl;
+      DiscoveryResult result;
+      result.reason = DiscoveryStop::Error;
+      return result;
+    }
+    target = mac;
+  }
+
+  // Shared with the tree listener, which can still be running on the event
+  // loop thread after it has been removed
+  struct Session
+  {
+    std::mutex                    mutex;
+    std::vector<DeviceInfo>       devices;
+    std::map<MacAddress, size_t>  index;
+    DiscoveryStop                 reason = DiscoveryStop::Timeout;
+    // Read by the waiter without the mutex, which is held across callbacks
+    std::atomic<bool>             stopped{false};
+    bool                          finished = false;
+  };
+
+  const auto start   = std::chrono::steady_clock::now();
+  auto       session = std::make_shared<Session>();
+
+  auto listener = m_objectTree->addListener(
+    [this, session, options, target, onDevice](
+      ObjectTree::Change change,
+      const std::string& path,
+      const std::string& interface,
+      const PropertyMap& props) {
+      if (interface != DEVICE_INTERFACE)
+      {
+        return;
+      }
+
+      bool added      = change == ObjectTree::Change::InterfacesAdded;
+      bool advertised =
+        change == ObjectTree::Change::PropertiesChanged &&
+        (props.count("RSSI") || props.count("ManufacturerData") ||
+         props.count("UUIDs"));
+      if (!added && !advertised)
+      {
+        // Connection state and the like say nothing about advertising
+        return;
+      }
+
+      MacAddress mac;
+      DeviceInfo info;
+      if (!macFromPath(path, mac) || !m_devices->find(mac, info))
+      {
+        return;
+      }
+
+      if (!m_devices->advertises(mac, options.services))
+      {
+        return;
+      }
+
+      std::optional<DiscoveryStop> stop;
+      {
+        // Held across the callbacks so discover() cannot return mid-call
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (session->finished || session->stopped)
+        {
+          return;
+        }
+
+        auto [it, first] =
+          session->index.emplace(mac, session->devices.size());
+        if (first)
+        {
+          session->devices.push_back(info);
+        }
+        else
+        {
+          session->devices[it->second] = info;
+        }
+
+        if (onDevice)
+        {
+          onDevice(info,
+                   first ? DiscoveryEvent::Found : DiscoveryEvent::Updated);
+        }
+
+        if (target && mac == *target)
+        {
+          stop = DiscoveryStop::TargetFound;
+        }
+        else if (options.maxDevices > 0 &&
+                 session->devices.size() >= options.maxDevices)
+        {
+          stop = DiscoveryStop::DeviceCount;
+        }
+        else if (options.stopWhen && options.stopWhen(info))
+        {
+          stop = DiscoveryStop::Predicate;
+        }
+
+        if (stop)
+        {
+          session->reason  = *stop;
+          session->stopped = true;
+        }
+      }
+
+      if (stop)
+      {
+        notifyWaiters();
+      }
+    });
+
+  DiscoveryResult result;
+  if (startDiscovery(options.services))
+  {
+    waitUntil([&session]() { return session->stopped.load(); },
+              start + options.timeout);
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->reason = DiscoveryStop::Error;
+  }
+
+  m_objectTree->removeListener(listener);
+  stopDiscovery();
+
+  std::lock_guard<std::mutex> lock(session->mutex);
+  session->finished = true;
+  result.devices    = std::move(session->devices);
+  result.reason     = session->reason;
+  result.elapsed    = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start);
+  return result;
+}
+
 std::map<std::string, sdbus::Variant> BluetoothManager::getProperties(
   const std::string& objectPath,
   const std::string& interface)
 {
   std::map<std::string, sdbus::Variant> properties;
-  sdbus::ObjectPath                     path(objectPath);
+  getProperties(objectPath, interface, properties);
+  return properties;
+}
 
+bool BluetoothManager::getProperties(
+  const std::string&                     objectPath,
+  const std::string&                     interface,
+  std::map<std::string, sdbus::Variant>& properties)
+{
   try
   {
-    auto proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    auto           proxy = m_proxyPool->get(objectPath);
+    OperationTimer timer(*m_metrics, Operation::GetAll);
     proxy->callMethod("GetAll")
       .onInterface(PROPERTIES_INTERFACE)
       .withArguments(interface)
       .storeResultsTo(properties);
+    timer.succeeded();
+    return true;
   }
   catch (const sdbus::Error& e)
   {
     std::cerr << "Error getting properties: " << e.what() << std::endl;
+    return false;
   }
-
-  return properties;
 }
 
 void BluetoothManager::setProperty(const std::string&    objectPath,
@@ -163,14 +524,14 @@ void BluetoothManager::setProperty(const std::string&    objectPath,
                                    const std::string&    property,
                                    const sdbus::Variant& value)
 {
-  sdbus::ObjectPath path(objectPath);
   try
   {
-    auto proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    auto           proxy = m_proxyPool->get(objectPath);
+    OperationTimer timer(*m_metrics, Operation::Set);
     proxy->callMethod("Set")
       .onInterface(PROPERTIES_INTERFACE)
       .withArguments(interface, property, value);
+    timer.succeeded();
   }
   catch (const sdbus::Error& e)
   {
@@ -182,117 +543,104 @@ void BluetoothManager::setProperty(const std::string&    objectPath,
 std::vector<DeviceInfo> BluetoothManager::getDevices(
   const std::string& filterServiceUUID)
 {
-  std::vector<DeviceInfo> devices;
-  sdbus::ObjectPath       path("/");
-  try
+  if (filterServiceUUID.empty())
   {
-    auto proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    return getDevices(std::vector<Uuid>{});
+  }
+
+  Uuid uuid;
+  if (!Uuid::parse(filterServiceUUID, uuid))
+  {
+    std::cerr << "Invalid service UUID: " << filterServiceUUID << std::endl;
+    return {};
+  }
+  return getDevices(std::vector<Uuid>{uuid});
+}
 
-    std::map<sdbus::ObjectPath,
-             std::map<std::string, std::map<std::string, sdbus::Variant>>>
-      objects;
-    proxy->callMethod("GetManagedObjects")
-      .onInterface(OBJECT_MANAGER_INTERFACE)
-      .storeResultsTo(objects);
+std::vector<DeviceInfo> BluetoothManager::getDevices(
+  const std::vector<Uuid>& services)
+{
+  TraceSpan span("getDevices", "manager");
+  dispatchPendingEvents();
+  return m_devices->snapshot(services);
+}
 
-    for (const auto& [path, interfaces] : objects)
+void BluetoothManager::updateDeviceRegistry(ObjectTree::Change change,
+                                            const std::string& path,
+                                            const PropertyMap& props)
+{
+  switch (change)
+  {
+    case ObjectTree::Change::InterfacesAdded:
+      m_devices->upsert(path, props);
+      break;
+    case ObjectTree::Change::PropertiesChanged:
+      m_devices->apply(path, props);
+      break;
+    case ObjectTree::Change::InterfacesRemoved:
     {
-      auto deviceIt = interfaces.find(DEVICE_INTERFACE);
-      if (deviceIt != interfaces.end())
+      MacAddress mac;
+      if (macFromPath(path, mac))
       {
-        DeviceInfo  info;
-        const auto& props = deviceIt->second;
-
-        // Extract device properties
-        if (props.count("Address"))
-        {
-          info.address = props.at("Address").get<std::string>();
-        }
-        if (props.count("Name"))
-        {
-          info.name = props.at("Name").get<std::string>();
-        }
-        if (props.count("Alias"))
-        {
-          info.alias = props.at("Alias").get<std::string>();
-        }
-        if (props.count("Paired"))
-        {
-          info.paired = props.at("Paired").get<bool>();
-        }
-        if (props.count("Connected"))
-        {
-          info.connected = props.at("Connected").get<bool>();
-        }
-        if (props.count("Trusted"))
-        {
-          info.trusted = props.at("Trusted").get<bool>();
-        }
-        if (props.count("UUIDs"))
-        {
-          info.uuids = props.at("UUIDs").get<std::vector<std::string>>();
-        }
-        if (props.count("RSSI"))
-        {
-          info.rssi = props.at("RSSI").get<int16_t>();
-        }
-
-        // Filter by service UUID if provided
-        if (!filterServiceUUID.empty())
-        {
-          bool hasService = std::find(info.uuids.begin(),
-                                      info.uuids.end(),
-                                      filterServiceUUID) != info.uuids.end();
-          if (!hasService)
-          {
-            continue;
-          }
-        }
-
-        devices.push_back(info);
+        m_devices->erase(mac);
       }
+      break;
     }
   }
-  catch (const sdbus::Error& e)
-  {
-    std::cerr << "Error getting devices: " << e.what() << std::endl;
-  }
-
-  return devices;
 }
 
 std::string BluetoothManager::getDevicePath(const std::string& address)
 {
+  MacAddress mac;
+  if (!parseMac(address, mac))
+  {
+    // Let BlueZ reject it with a proper error
+    return m_adapterPath + "/dev_" + address;
+  }
+
+  // Known devices keep their interned path
+  std::string path = m_devices->path(mac);
+  if (!path.empty())
+  {
+    return path;
+  }
+
   // Convert address format (XX:XX:XX:XX:XX:XX) to BlueZ format
   // (dev_XX_XX_XX_XX_XX_XX)
-  std::string devAddress = address;
-  std::replace(devAddress.begin(), devAddress.end(), ':', '_');
-  return m_adapterPath + "/dev_" + devAddress;
+  return m_adapterPath + "/dev_" + formatMac(mac, '_');
 }
 
-bool BluetoothManager::connectDevice(const std::string& address)
+bool BluetoothManager::connectDevice(const std::string&        address,
+                                     std::chrono::milliseconds timeout)
 {
+  TraceSpan span("connectDevice", "manager", address);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+
   try
   {
-    std::string       devicePath = getDevicePath(address);
-    sdbus::ObjectPath path(devicePath);
-    auto              device = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    std::string devicePath = getDevicePath(address);
+    auto        device     = m_proxyPool->get(devicePath);
 
-    std::cout << "Connecting to device: " << address << std::endl;
-    device->callMethod("Connect").onInterface(DEVICE_INTERFACE);
+    dispatchPendingEvents();
+    if (isDeviceReady(devicePath))
+    {
+      return true;
+    }
 
-    // Wait for connection to establish
-    for (int i = 0; i < 50; i++)
+    std::cout << "Connecting to device: " << address << std::endl;
+    OperationTimer timer(*m_metrics, Operation::Connect);
+    device->callMethod("Connect")
+      .onInterface(DEVICE_INTERFACE)
+      .withTimeout(timeout);
+    timer.succeeded();
+
+    // Connected flips first; GATT is only usable once BlueZ has also
+    // resolved the services, which it announces via ServicesResolved
+    if (waitUntil([this, &devicePath]() { return isDeviceReady(devicePath); },
+                  deadline))
     {
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
-      auto props = getProperties(devicePath, DEVICE_INTERFACE);
-      if (props.count("Connected") && props.at("Connected").get<bool>())
-      {
-        std::cout << "Device connected successfully" << std::endl;
-        return true;
-      }
+      std::cout << "Device connected successfully" << std::endl;
+      return true;
     }
 
     std::cerr << "Connection timeout" << std::endl;
@@ -305,59 +653,216 @@ bool BluetoothManager::connectDevice(const std::string& address)
   }
 }
 
-bool BluetoothManager::disconnectDevice(const std::string& address)
+bool BluetoothManager::isDeviceReady(const std::string& devicePath) const
 {
-  try
-  {
-    std::string       devicePath = getDevicePath(address);
-    sdbus::ObjectPath path(devicePath);
-    auto              device = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
-
-    std::cout << "Disconnecting device: " << address << std::endl;
-    device->callMethod("Disconnect").onInterface(DEVICE_INTERFACE);
-
-    std::cout << "Device disconnected successfully" << std::endl;
-    return true;
-  }
-  catch (const sdbus::Error& e)
+  PropertyMap props;
+  if (!m_objectTree->getInterface(devicePath, DEVICE_INTERFACE, props))
   {
-    std::cerr << "Error disconnecting device: " << e.what() << std::endl;
     return false;
   }
+
+  return props.count("Connected") && props.at("Connected").get<bool>() &&
+         props.count("ServicesResolved") &&
+         props.at("ServicesResolved").get<bool>();
 }
 
-bool BluetoothManager::removeDevice(const std::string& address)
+void BluetoothManager::connectDeviceAsync(const std::string&        address,
+                                          ResultCallback            done,
+                                          std::chrono::milliseconds timeout)
 {
-  try
-  {
-    std::string       devicePath = getDevicePath(address);
-    sdbus::ObjectPath path(m_adapterPath);
-    auto              adapter = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+  TraceSpan span("connectDeviceAsync", "manager", address);
+  const auto  deadline   = std::chrono::steady_clock::now() + timeout;
+  std::string devicePath = getDevicePath(address);
 
-    std::cout << "Removing (forgetting) device: " << address << std::endl;
-    adapter->callMethod("RemoveDevice")
-      .onInterface(ADAPTER_INTERFACE)
-      .withArguments(sdbus::ObjectPath(devicePath));
+  // No dispatching here: this may run inside a completion handler
+  if (isDeviceReady(devicePath))
+  {
+    done(true);
+    return;
+  }
 
-    std::cout << "Device removed successfully" << std::endl;
-    return true;
+  try
+  {
+    // The handler keeps the proxy alive; evicting it would cancel the call
+    auto device = m_proxyPool->get(devicePath);
+    auto start  = Metrics::now();
+    device->callMethodAsync("Connect")
+      .onInterface(DEVICE_INTERFACE)
+      .withTimeout(timeout)
+      .uponReplyInvoke([this, device, devicePath, deadline, start, done](
+                         std::optional<sdbus::Error> error) {
+        recordReply(*m_metrics, Operation::Connect, start, !error);
+        if (error)
+        {
+          std::cerr << "Error connecting to device: " << error->what()
+                    << std::endl;
+          done(false);
+          return;
+        }
+        whenDeviceReady(devicePath, deadline, done);
+      });
   }
   catch (const sdbus::Error& e)
   {
-    std::cerr << "Error removing device: " << e.what() << std::endl;
-    return false;
+    std::cerr << "Error connecting to device: " << e.what() << std::endl;
+    done(false);
   }
 }
 
-void BluetoothManager::registerDeviceDisconnectHandler(
-  const std::string&                      devicePath,
-  std::function<void(const std::string&)> onDisconnect)
+std::future<bool> BluetoothManager::connectDeviceAsync(
+  const std::string&        address,
+  std::chrono::milliseconds timeout)
 {
-  auto proxy = sdbus::createProxy(*m_connection,
-                                  sdbus::ServiceName(BLUEZ_SERVICE),
-                                  sdbus::ObjectPath(devicePath));
+  return toFuture<bool>(
+    [&](ResultCallback done) { connectDeviceAsync(address, done, timeout); });
+}
+
+void BluetoothManager::whenDeviceReady(
+  const std::string&                    devicePath,
+  std::chrono::steady_clock::time_point deadline,
+  ResultCallback                        done)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+    m_readyWaiters.push_back({devicePath, deadline, std::move(done)});
+  }
+  // The timer may be sleeping towards a later deadline, or not at all
+  wakeReadyTimer();
+  // The device may have become ready before the waiter was registered
+  checkReadyWaiters();
+}
+
+void BluetoothManager::checkReadyWaiters(bool failAll)
+{
+  std::vector<std::pair<ResultCallback, bool>> completed;
+  {
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+    if (m_readyWaiters.empty())
+    {
+      return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto it  = m_readyWaiters.begin();
+    while (it != m_readyWaiters.end())
+    {
+      bool ready = !failAll && isDeviceReady(it->devicePath);
+      if (ready || failAll || now >= it->deadline)
+      {
+        completed.emplace_back(std::move(it->done), ready);
+        it = m_readyWaiters.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+
+  // Outside the lock: completions may start further async operations
+  for (auto& [done, ready] : completed)
+  {
+    if (!ready)
+    {
+      std::cerr << "Connection timeout" << std::endl;
+    }
+    done(ready);
+  }
+}
+
+void BluetoothManager::wakeReadyTimer()
+{
+  // Taking the lock orders this wakeup after the timer's check of the loop
+  // state and the waiters
+  {
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+  }
+  m_readyCondition.notify_all();
+}
+
+void BluetoothManager::runReadyTimer()
+{
+  std::unique_lock<std::mutex> lock(m_readyMutex);
+  while (!m_readyTimerStop)
+  {
+    if (!m_eventLoopRunning || m_readyWaiters.empty())
+    {
+      // Without the loop the waiters are swept by processEvents()
+      m_readyCondition.wait(lock);
+      continue;
+    }
+
+    auto next = std::min_element(m_readyWaiters.begin(),
+                                 m_readyWaiters.end(),
+                                 [](const auto& a, const auto& b) {
+                                   return a.deadline < b.deadline;
+                                 })->deadline;
+    if (std::chrono::steady_clock::now() < next)
+    {
+      // Woken early by a new waiter, a stop, or the loop stopping
+      m_readyCondition.wait_until(lock, next);
+      continue;
+    }
+
+    lock.unlock();
+    checkReadyWaiters();
+    lock.lock();
+  }
+}
+
+bool BluetoothManager::disconnectDevice(const std::string& address)
+{
+  TraceSpan span("disconnectDevice", "manager", address);
+  try
+  {
+    std::string devicePath = getDevicePath(address);
+    auto        device     = m_proxyPool->get(devicePath);
+
+    std::cout << "Disconnecting device: " << address << std::endl;
+    OperationTimer timer(*m_metrics, Operation::Disconnect);
+    device->callMethod("Disconnect").onInterface(DEVICE_INTERFACE);
+    timer.succeeded();
+
+    std::cout << "Device disconnected successfully" << std::endl;
+    return true;
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "Error disconnecting device: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool BluetoothManager::removeDevice(const std::string& address)
+{
+  TraceSpan span("removeDevice", "manager", address);
+  try
+  {
+    std::string devicePath = getDevicePath(address);
+    auto        adapter    = m_proxyPool->get(m_adapterPath);
+
+    std::cout << "Removing (forgetting) device: " << address << std::endl;
+    adapter->callMethod("RemoveDevice")
+      .onInterface(ADAPTER_INTERFACE)
+      .withArguments(sdbus::ObjectPath(devicePath));
+
+    std::cout << "Device removed successfully" << std::endl;
+    return true;
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "Error removing device: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+void BluetoothManager::registerDeviceDisconnectHandler(
+  const std::string&                      devicePath,
+  std::function<void(const std::string&)> onDisconnect)
+{
+  auto proxy = sdbus::createProxy(*m_connection,
+                                  sdbus::ServiceName(BLUEZ_SERVICE),
+                                  sdbus::ObjectPath(devicePath));
   proxy->uponSignal("PropertiesChanged")
     .onInterface("org.freedesktop.DBus.Properties")
     .call([this, devicePath, onDisconnect](
@@ -373,245 +878,387 @@ void BluetoothManager::registerDeviceDisconnectHandler(
                     << std::endl;
           onDisconnect(devicePath);
           // Remove this proxy
+          std::lock_guard<std::mutex> lock(m_subscriptionMutex);
           m_deviceDisconnectProxies.erase(devicePath);
         }
       }
     });
+
+  std::lock_guard<std::mutex> lock(m_subscriptionMutex);
   m_deviceDisconnectProxies[devicePath] = std::move(proxy);
 }
 
 void BluetoothManager::cleanupDevice(const std::string& devicePath)
 {
+  TraceSpan span("cleanupDevice", "manager", devicePath);
+
   // Remove notification proxies and callbacks for all characteristics belonging
-  // to device
-  std::vector<std::string> to_cleanup;
-  for (const auto& [charPath, _] : m_deviceProxies)
+  // to device. The index still lists characteristics BlueZ already removed.
+  auto characteristics = m_gatt->subtree(m_gatt->find(devicePath));
+
+  std::vector<int>                             fds;
+  std::vector<std::shared_ptr<RingDispatcher>> rings;
   {
-    if (charPath.find(devicePath) == 0)
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    for (GattHandle characteristic : characteristics)
     {
-      to_cleanup.push_back(charPath);
+      auto fd = m_notifyFds.find(characteristic);
+      if (fd != m_notifyFds.end())
+      {
+        fds.push_back(fd->second);
+        m_notifyFds.erase(fd);
+      }
+      m_notifyProxies.erase(characteristic);
+      m_notifyCallbacks.erase(characteristic);
+      m_notifyPools.erase(characteristic);
+
+      auto ring = m_ringDispatchers.find(characteristic);
+      if (ring != m_ringDispatchers.end())
+      {
+        rings.push_back(std::move(ring->second));
+        m_ringDispatchers.erase(ring);
+      }
     }
   }
-  for (const auto& charPath : to_cleanup)
+
+  // Outside the lock: remove() waits for the reader thread, whose close
+  // handler takes the same lock
+  for (int fd : fds)
   {
-    m_deviceProxies.erase(charPath);
-    m_notifyCallbacks.erase(charPath);
+    m_notifyReader->remove(fd);
   }
+  m_proxyPool->evictSubtree(devicePath);
 }
 
-bool BluetoothManager::requestMTU(const std::string& deviceAddress,
-                                  uint16_t           mtu)
+uint16_t BluetoothManager::getMtu(const std::string& deviceAddress)
 {
-  try
-  {
-    std::string       devicePath = getDevicePath(deviceAddress);
-    sdbus::ObjectPath path("/");
-
-    // Get all GATT characteristics for the device
-    auto proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
-
-    std::map<sdbus::ObjectPath,
-             std::map<std::string, std::map<std::string, sdbus::Variant>>>
-      objects;
-    proxy->callMethod("GetManagedObjects")
-      .onInterface(OBJECT_MANAGER_INTERFACE)
-      .storeResultsTo(objects);
+  TraceSpan span("getMtu", "manager", deviceAddress);
+  dispatchPendingEvents();
+  return deviceMtu(m_gatt->find(getDevicePath(deviceAddress)));
+}
 
-    // Find any characteristic belonging to this device and use it to request
-    // MTU
-    for (const auto& [path, interfaces] : objects)
-    {
-      std::string pathStr = path;
-      if (pathStr.find(devicePath) == 0 &&
-          interfaces.find(GATT_CHAR_INTERFACE) != interfaces.end())
-      {
-        sdbus::ObjectPath charPath(path);
+size_t BluetoothManager::maxWritePayload(const std::string& characteristicPath)
+{
+  return maxWritePayload(characteristicHandle(characteristicPath));
+}
 
-        // Try to acquire MTU through the characteristic
-        try
-        {
-          auto charProxy = sdbus::createProxy(
-            *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), charPath);
-
-          // Use AcquireWrite or AcquireNotify with MTU option
-          std::map<std::string, sdbus::Variant> options;
-          options["MTU"] = sdbus::Variant(mtu);
-
-          // Try AcquireNotify first as it's more commonly available
-          sdbus::UnixFd fd;
-          uint16_t      resultMtu;
-          charProxy->callMethod("AcquireNotify")
-            .onInterface(GATT_CHAR_INTERFACE)
-            .withArguments(options)
-            .storeResultsTo(fd, resultMtu);
-
-          std::cout << "MTU requested: " << mtu << ", negotiated: " << resultMtu
-                    << std::endl;
-          return true;
-        }
-        catch (const sdbus::Error& e)
-        {
-          // AcquireNotify might not be supported, try through device property
-          std::cerr << "Note: Direct MTU negotiation not supported, using "
-                       "default mechanism"
-                    << std::endl;
-        }
-        break;
-      }
-    }
+size_t BluetoothManager::maxWritePayload(GattHandle characteristic)
+{
+  uint16_t mtu = deviceMtu(m_gatt->device(characteristic));
+  return mtu > DEFAULT_ATT_MTU ? mtu - CharacteristicWriter::ATT_WRITE_HEADER
+                               : DEFAULT_WRITE_PAYLOAD;
+}
 
-    std::cout << "MTU request noted (will be negotiated during GATT operations)"
-              << std::endl;
-    return true;
+void BluetoothManager::onCharacteristicChanged(sdbus::Message& message)
+{
+  uint16_t mtu = 0;
+  try
+  {
+    mtu = decodeMtuChange(message);
   }
   catch (const sdbus::Error& e)
   {
-    std::cerr << "Error requesting MTU: " << e.what() << std::endl;
-    return false;
+    std::cerr << "Error decoding PropertiesChanged: " << e.what() << std::endl;
+    return;
+  }
+  // Almost every signal here is a notification; keep those to the decode
+  if (mtu != 0)
+  {
+    noteMtu(m_gatt->find(message.getPath()), mtu);
   }
 }
 
-std::vector<ServiceInfo> BluetoothManager::getServices(
-  const std::string& deviceAddress)
+void BluetoothManager::noteMtu(GattHandle characteristic, uint16_t mtu)
 {
-  std::vector<ServiceInfo> services;
-
-  try
+  // Checked first: every notification signal passes through here
+  if (mtu == 0)
   {
-    std::string       devicePath = getDevicePath(deviceAddress);
-    sdbus::ObjectPath path("/");
-    auto              proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
-
-    std::map<sdbus::ObjectPath,
-             std::map<std::string, std::map<std::string, sdbus::Variant>>>
-      objects;
-    proxy->callMethod("GetManagedObjects")
-      .onInterface(OBJECT_MANAGER_INTERFACE)
-      .storeResultsTo(objects);
+    return;
+  }
+  GattHandle device = m_gatt->device(characteristic);
+  if (!device.valid())
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mtuMutex);
+  m_mtus[device] = mtu;
+}
 
-    for (const auto& [path, interfaces] : objects)
+uint16_t BluetoothManager::deviceMtu(GattHandle device)
+{
+  if (!device.valid())
+  {
+    return 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mtuMutex);
+    auto                        it = m_mtus.find(device);
+    if (it != m_mtus.end())
     {
-      // if this characteristic belongs to the device
-      std::string pathStr = path;
-      if (pathStr.find(devicePath) == 0)
-      {
-        auto serviceIt = interfaces.find(GATT_SERVICE_INTERFACE);
-        if (serviceIt != interfaces.end())
-        {
-          ServiceInfo service;
-          service.path = pathStr;
+      return it->second;
+    }
+  }
 
-          const auto& props = serviceIt->second;
-          if (props.count("UUID"))
-          {
-            service.uuid = props.at("UUID").get<std::string>();
-          }
+  // A disconnected device's characteristics still show its last MTU
+  if (!isDeviceReady(m_gatt->path(device)))
+  {
+    return 0;
+  }
 
-          services.push_back(service);
-        }
-      }
+  // The MTU belongs to the link, so any characteristic reports it. Cached
+  // even when BlueZ has no such property, as 0, so that is asked once per
+  // connection; a failed call is not cached, so the next one asks again.
+  std::string characteristicPath;
+  for (const auto& service : m_gatt->services(device))
+  {
+    auto characteristics = m_gatt->characteristics(service.handle);
+    if (!characteristics.empty())
+    {
+      characteristicPath = characteristics[0].path;
+      break;
     }
   }
-  catch (const sdbus::Error& e)
+  std::map<std::string, sdbus::Variant> props;
+  if (characteristicPath.empty() ||
+      !getProperties(characteristicPath, GATT_CHAR_INTERFACE, props))
+  {
+    return 0;
+  }
+  uint16_t mtu = 0;
+  auto     it  = props.find("MTU");
+  if (it != props.end())
   {
-    std::cerr << "Error getting services: " << e.what() << std::endl;
+    mtu = it->second.get<uint16_t>();
   }
 
-  return services;
+  std::lock_guard<std::mutex> lock(m_mtuMutex);
+  // A signal or Acquire call may have filled it in meanwhile
+  return m_mtus.emplace(device, mtu).first->second;
+}
+
+std::vector<ServiceInfo> BluetoothManager::getServices(
+  const std::string& deviceAddress)
+{
+  TraceSpan span("getServices", "manager", deviceAddress);
+  dispatchPendingEvents();
+  return collectServices(getDevicePath(deviceAddress));
+}
+
+std::vector<ServiceInfo> BluetoothManager::collectServices(
+  const std::string& devicePath) const
+{
+  // Only the device's own children are visited
+  return m_gatt->services(m_gatt->find(devicePath));
+}
+
+void BluetoothManager::getServicesAsync(const std::string&        deviceAddress,
+                                        ServicesCallback          done,
+                                        std::chrono::milliseconds timeout)
+{
+  TraceSpan span("getServicesAsync", "manager", deviceAddress);
+  std::string devicePath = getDevicePath(deviceAddress);
+  whenDeviceReady(devicePath,
+                  std::chrono::steady_clock::now() + timeout,
+                  [this, devicePath, done](bool ready) {
+                    done(ready ? collectServices(devicePath)
+                               : std::vector<ServiceInfo>{});
+                  });
+}
+
+std::future<std::vector<ServiceInfo>> BluetoothManager::getServicesAsync(
+  const std::string&        deviceAddress,
+  std::chrono::milliseconds timeout)
+{
+  return toFuture<std::vector<ServiceInfo>>([&](ServicesCallback done) {
+    getServicesAsync(deviceAddress, done, timeout);
+  });
 }
 
 std::vector<CharacteristicInfo> BluetoothManager::getCharacteristics(
   const std::string& servicePath)
 {
-  std::vector<CharacteristicInfo> characteristics;
+  dispatchPendingEvents();
+  return m_gatt->characteristics(m_gatt->find(servicePath));
+}
 
-  try
+std::vector<CharacteristicInfo> BluetoothManager::getCharacteristics(
+  GattHandle service)
+{
+  TraceSpan span("getCharacteristics", "manager", m_gatt->path(service));
+  dispatchPendingEvents();
+  return m_gatt->characteristics(service);
+}
+
+GattHandle BluetoothManager::characteristicHandle(
+  const std::string& characteristicPath)
+{
+  // Looked up rather than interned: the path comes from the caller, and
+  // only what BlueZ announced may grow the index
+  GattHandle handle = m_gatt->find(characteristicPath);
+  if (!handle.valid())
   {
-    sdbus::ObjectPath path("/");
-    auto              proxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    dispatchPendingEvents();
+    handle = m_gatt->find(characteristicPath);
+  }
+  if (!handle.valid())
+  {
+    std::cerr << "Unknown characteristic: " << characteristicPath
+              << std::endl;
+  }
+  return handle;
+}
 
-    std::map<sdbus::ObjectPath,
-             std::map<std::string, std::map<std::string, sdbus::Variant>>>
-      objects;
-    proxy->callMethod("GetManagedObjects")
-      .onInterface(OBJECT_MANAGER_INTERFACE)
-      .storeResultsTo(objects);
+// In enableNotifications
+bool BluetoothManager::enableNotifications(
+  const std::string&                               characteristicPath,
+  std::function<void(const std::vector<uint8_t>&)> callback,
+  NotifyMode                                       mode)
+{
+  return enableNotifications(
+    characteristicHandle(characteristicPath), std::move(callback), mode);
+}
 
-    for (const auto& [path, interfaces] : objects)
+bool BluetoothManager::enableNotifications(
+  GattHandle                                       characteristic,
+  std::function<void(const std::vector<uint8_t>&)> callback,
+  NotifyMode                                       mode)
+{
+  TraceSpan span(
+    "enableNotifications", "manager", m_gatt->path(characteristic));
+  if (mode != NotifyMode::Signal)
+  {
+    if (enableFdNotifications(characteristic, callback))
     {
-      std::string pathStr = path;
-      if (pathStr.find(servicePath) == 0 && pathStr != servicePath)
-      {
-        auto charIt = interfaces.find(GATT_CHAR_INTERFACE);
-        if (charIt != interfaces.end())
-        {
-          CharacteristicInfo characteristic;
-          characteristic.path = pathStr;
+      return true;
+    }
+    if (mode == NotifyMode::AcquireFd)
+    {
+      return false;
+    }
+    std::cout << "AcquireNotify not available, using notification signals"
+              << std::endl;
+  }
 
-          const auto& props = charIt->second;
-          if (props.count("UUID"))
-          {
-            characteristic.uuid = props.at("UUID").get<std::string>();
-          }
-          if (props.count("Flags"))
+  // One buffer is enough: the callback borrows it only for its own duration
+  auto pool = std::make_shared<BufferPool>(1);
+  if (!subscribeValueSignal(
+        characteristic, pool, [callback](PooledBuffer buffer) {
+          if (callback)
           {
-            characteristic.flags =
-              props.at("Flags").get<std::vector<std::string>>();
+            callback(buffer.bytes());
           }
-
-          characteristics.push_back(characteristic);
-        }
-      }
-    }
+        }))
+  {
+    return false;
   }
-  catch (const sdbus::Error& e)
+
+  std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+  m_notifyCallbacks[characteristic] = callback;
+  return true;
+}
+
+bool BluetoothManager::enablePooledNotifications(
+  const std::string& characteristicPath,
+  BufferCallback     consumer,
+  size_t             poolSize)
+{
+  TraceSpan span("enablePooledNotifications", "manager", characteristicPath);
+  return subscribeValueSignal(characteristicHandle(characteristicPath),
+                              std::make_shared<BufferPool>(poolSize),
+                              std::move(consumer));
+}
+
+PoolStats BluetoothManager::notificationPoolStats(
+  const std::string& characteristicPath) const
+{
+  std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+  auto it = m_notifyPools.find(m_gatt->find(characteristicPath));
+  return it != m_notifyPools.end() ? it->second->stats() : PoolStats{};
+}
+
+bool BluetoothManager::captureNotifications(
+  const std::string&          characteristicPath,
+  std::shared_ptr<CaptureLog> log,
+  NotifyMode                  mode)
+{
+  TraceSpan  span("captureNotifications", "manager", characteristicPath);
+  GattHandle characteristic = characteristicHandle(characteristicPath);
+  if (!log || !characteristic.valid())
   {
-    std::cerr << "Error getting characteristics: " << e.what() << std::endl;
+    return false;
   }
 
-  return characteristics;
+  uint32_t id = characteristic.id;
+  log->describe(id, characteristicPath);
+  return enableNotifications(
+    characteristic,
+    [log, id](const std::vector<uint8_t>& value) {
+      log->append(id, value.data(), value.size(), CaptureLog::now());
+    },
+    mode);
 }
 
-// In enableNotifications
-bool BluetoothManager::enableNotifications(
-  const std::string&                               characteristicPath,
-  std::function<void(const std::vector<uint8_t>&)> callback)
+bool BluetoothManager::subscribeValueSignal(
+  GattHandle                  characteristic,
+  std::shared_ptr<BufferPool> pool,
+  BufferCallback              deliver)
 {
+  const std::string& characteristicPath = m_gatt->path(characteristic);
   try
   {
     sdbus::ObjectPath path(characteristicPath);
     // Create and store the proxy so it's not destroyed
     auto charProxy = sdbus::createProxy(
       *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
-
-    charProxy->uponSignal("PropertiesChanged")
-      .onInterface(PROPERTIES_INTERFACE)
-      .call([this, characteristicPath, callback](
-              const std::string&                           interface,
-              const std::map<std::string, sdbus::Variant>& changed,
-              const std::vector<std::string>& /*invalidated*/) {
-        if (interface == GATT_CHAR_INTERFACE && changed.count("Value"))
+    auto counters =
+      m_metrics->notifications(characteristic, characteristicPath);
+
+    // Raw handler: the typed one would build the whole property map and
+    // copy Value out of it for every notification
+    charProxy->registerSignalHandler(
+      sdbus::InterfaceName(PROPERTIES_INTERFACE),
+      sdbus::SignalName("PropertiesChanged"),
+      [this, characteristic, pool, deliver, counters, characteristicPath](
+        sdbus::Signal signal) {
+        TraceSpan    span("notification", "callback", characteristicPath);
+        PooledBuffer buffer = pool->acquire();
+        uint16_t     mtu    = 0;
+        try
         {
-          auto value = changed.at("Value").get<std::vector<uint8_t>>();
-          if (callback)
+          bool found = decodeValueChange(signal, buffer.storage(), mtu);
+          noteMtu(characteristic, mtu);
+          if (!found)
           {
-            callback(value);
+            return;
           }
         }
+        catch (const sdbus::Error& e)
+        {
+          std::cerr << "Error decoding notification from "
+                    << characteristicPath << ": " << e.what() << std::endl;
+          return;
+        }
+        counters->add(buffer.size());
+        if (deliver)
+        {
+          deliver(std::move(buffer));
+        }
       });
 
     // Store the proxy so it stays alive!
-    m_deviceProxies[characteristicPath] = std::move(charProxy);
+    {
+      std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+      m_notifyProxies[characteristic] = std::move(charProxy);
+      m_notifyPools[characteristic]   = pool;
+    }
 
     // Start notifications
-    m_deviceProxies[characteristicPath]
+    OperationTimer timer(*m_metrics, Operation::StartNotify);
+    m_proxyPool->get(characteristicPath)
       ->callMethod("StartNotify")
       .onInterface(GATT_CHAR_INTERFACE);
+    timer.succeeded();
 
-    m_notifyCallbacks[characteristicPath] = callback;
     std::cout << "Notifications enabled for characteristic: "
               << characteristicPath << std::endl;
     return true;
@@ -624,18 +1271,170 @@ bool BluetoothManager::enableNotifications(
   }
 }
 
+bool BluetoothManager::enableFdNotifications(GattHandle     characteristic,
+                                             NotifyCallback callback)
+{
+  const std::string& characteristicPath = m_gatt->path(characteristic);
+  sdbus::UnixFd      fd;
+  uint16_t           mtu = 0;
+
+  try
+  {
+    std::map<std::string, sdbus::Variant> options;
+    OperationTimer timer(*m_metrics, Operation::AcquireNotify);
+    m_proxyPool->get(characteristicPath)
+      ->callMethod("AcquireNotify")
+      .onInterface(GATT_CHAR_INTERFACE)
+      .withArguments(options)
+      .storeResultsTo(fd, mtu);
+    timer.succeeded();
+  }
+  catch (const sdbus::Error& e)
+  {
+    // NotSupported / NotPermitted when the characteristic cannot notify or
+    // someone already uses StartNotify on it
+    std::cerr << "AcquireNotify failed for characteristic, "
+              << characteristicPath << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  // Counted here rather than in the reader, which knows no characteristics
+  auto counters = m_metrics->notifications(characteristic, characteristicPath);
+  callback      = [counters, deliver = std::move(callback)](
+               const std::vector<uint8_t>& value) {
+    TraceSpan span("notification", "callback");
+    counters->add(value.size());
+    // Counted even without a callback, as on the signal path
+    if (deliver)
+    {
+      deliver(value);
+    }
+  };
+
+  noteMtu(characteristic, mtu);
+
+  int rawFd = fd.release();
+  {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    if (!m_notifyReader)
+    {
+      m_notifyReader = std::make_unique<NotifySocketReader>();
+    }
+    m_notifyFds[characteristic]       = rawFd;
+    m_notifyCallbacks[characteristic] = callback;
+  }
+
+  // BlueZ closes its end when the device disconnects or releases the socket
+  auto onClosed = [this, characteristic](int closedFd) {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    auto                        it = m_notifyFds.find(characteristic);
+    if (it != m_notifyFds.end() && it->second == closedFd)
+    {
+      m_notifyFds.erase(it);
+      m_notifyCallbacks.erase(characteristic);
+    }
+  };
+
+  if (!m_notifyReader->add(rawFd, mtu, callback, onClosed))
+  {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    m_notifyFds.erase(characteristic);
+    m_notifyCallbacks.erase(characteristic);
+    return false;
+  }
+
+  std::cout << "Notifications enabled (AcquireNotify, MTU " << mtu
+            << ") for characteristic: " << characteristicPath << std::endl;
+  return true;
+}
+
+bool BluetoothManager::enableRingNotifications(
+  const std::string&       characteristicPath,
+  RingDispatcher::Consumer consumer,
+  const RingOptions&       options,
+  NotifyMode               mode)
+{
+  TraceSpan span("enableRingNotifications", "manager", characteristicPath);
+
+  // Shared with the producer callback, which may still be running on the
+  // dispatch thread while the subscription is torn down
+  auto dispatcher = std::make_shared<RingDispatcher>(options, consumer);
+  auto producer   = [dispatcher](const std::vector<uint8_t>& value) {
+    dispatcher->push(value);
+  };
+
+  GattHandle characteristic = characteristicHandle(characteristicPath);
+  if (!enableNotifications(characteristic, producer, mode))
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+  m_ringDispatchers[characteristic] = dispatcher;
+  return true;
+}
+
+RingStats BluetoothManager::ringStats(
+  const std::string& characteristicPath) const
+{
+  std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+  auto it = m_ringDispatchers.find(m_gatt->find(characteristicPath));
+  return it != m_ringDispatchers.end() ? it->second->stats() : RingStats{};
+}
+
 bool BluetoothManager::disableNotifications(
   const std::string& characteristicPath)
 {
+  return disableNotifications(characteristicHandle(characteristicPath));
+}
+
+bool BluetoothManager::disableNotifications(GattHandle characteristic)
+{
+  TraceSpan span(
+    "disableNotifications", "manager", m_gatt->path(characteristic));
+
+  // Released last, outside the lock: its destructor joins the consumer
+  // thread, and the consumer may call back into the manager
+  std::shared_ptr<RingDispatcher> ring;
+  int                             fd = -1;
+  {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+
+    auto ringIt = m_ringDispatchers.find(characteristic);
+    if (ringIt != m_ringDispatchers.end())
+    {
+      ring = std::move(ringIt->second);
+      m_ringDispatchers.erase(ringIt);
+    }
+
+    auto it = m_notifyFds.find(characteristic);
+    if (it != m_notifyFds.end())
+    {
+      fd = it->second;
+      m_notifyFds.erase(it);
+      m_notifyCallbacks.erase(characteristic);
+    }
+  }
+
+  if (fd >= 0)
+  {
+    // Closing the acquired socket is how BlueZ is told to stop
+    m_notifyReader->remove(fd);
+    std::cout << "Notifications disabled for characteristic" << std::endl;
+    return true;
+  }
+
   try
   {
-    sdbus::ObjectPath path(characteristicPath);
-    auto              charProxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    auto           charProxy = m_proxyPool->get(m_gatt->path(characteristic));
+    OperationTimer timer(*m_metrics, Operation::StopNotify);
     charProxy->callMethod("StopNotify").onInterface(GATT_CHAR_INTERFACE);
+    timer.succeeded();
 
-    m_notifyCallbacks.erase(characteristicPath);
-    m_deviceProxies.erase(characteristicPath);
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    m_notifyCallbacks.erase(characteristic);
+    m_notifyPools.erase(characteristic);
+    m_notifyProxies.erase(characteristic);
     std::cout << "Notifications disabled for characteristic" << std::endl;
     return true;
   }
@@ -650,18 +1449,26 @@ bool BluetoothManager::writeCharacteristic(
   const std::string&          characteristicPath,
   const std::vector<uint8_t>& data)
 {
+  return writeCharacteristic(characteristicHandle(characteristicPath), data);
+}
+
+bool BluetoothManager::writeCharacteristic(GattHandle characteristic,
+                                           const std::vector<uint8_t>& data)
+{
+  TraceSpan span(
+    "writeCharacteristic", "manager", m_gatt->path(characteristic));
   try
   {
-    sdbus::ObjectPath path(characteristicPath);
-    auto              charProxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    auto charProxy = m_proxyPool->get(m_gatt->path(characteristic));
 
     std::map<std::string, sdbus::Variant> options;
     // Default write type is "request" which waits for response
 
+    OperationTimer timer(*m_metrics, Operation::WriteValue);
     charProxy->callMethod("WriteValue")
       .onInterface(GATT_CHAR_INTERFACE)
       .withArguments(data, options);
+    timer.succeeded();
 
     std::cout << "Written " << data.size() << " bytes to characteristic"
               << std::endl;
@@ -674,22 +1481,212 @@ bool BluetoothManager::writeCharacteristic(
   }
 }
 
+BatchWriteStats BluetoothManager::writeCharacteristicBatch(
+  const std::string&                       characteristicPath,
+  const std::vector<std::vector<uint8_t>>& values,
+  WriteType                                type,
+  size_t                                   window)
+{
+  TraceSpan span("writeCharacteristicBatch", "manager", characteristicPath);
+  return writePipelined(
+    characteristicHandle(characteristicPath),
+    values.size(),
+    [&values](size_t index) { return values[index]; },
+    type,
+    window);
+}
+
+BatchWriteStats BluetoothManager::writeCharacteristicChunked(
+  const std::string&          characteristicPath,
+  const std::vector<uint8_t>& data,
+  size_t                      chunkSize,
+  WriteType                   type,
+  size_t                      window)
+{
+  TraceSpan  span("writeCharacteristicChunked", "manager", characteristicPath);
+  GattHandle characteristic = characteristicHandle(characteristicPath);
+  if (chunkSize == 0)
+  {
+    chunkSize = maxWritePayload(characteristic);
+  }
+  size_t count = (data.size() + chunkSize - 1) / chunkSize;
+
+  return writePipelined(
+    characteristic,
+    count,
+    [&data, chunkSize](size_t index) {
+      size_t begin = index * chunkSize;
+      size_t end   = std::min(data.size(), begin + chunkSize);
+      return std::vector<uint8_t>(data.begin() + begin, data.begin() + end);
+    },
+    type,
+    window);
+}
+
+WriteType BluetoothManager::resolveWriteType(GattHandle characteristic,
+                                             WriteType  type)
+{
+  if (type != WriteType::Auto)
+  {
+    return type;
+  }
+  return m_gatt->hasFlag(characteristic, "write-without-response")
+           ? WriteType::Command
+           : WriteType::Request;
+}
+
+BatchWriteStats BluetoothManager::writePipelined(
+  GattHandle                                         characteristic,
+  size_t                                             count,
+  const std::function<std::vector<uint8_t>(size_t)>& valueAt,
+  WriteType                                          type,
+  size_t                                             window)
+{
+  // Written by the reply handlers, which run on the event loop thread or
+  // inside our own dispatching below
+  struct Progress
+  {
+    std::atomic<size_t> inFlight{0};
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> bytes{0};
+  };
+
+  dispatchPendingEvents();
+
+  BatchWriteStats stats;
+  stats.type      = resolveWriteType(characteristic, type);
+  stats.requested = count;
+  stats.window    = std::max<size_t>(window, 1);
+
+  auto options = writeOptions(stats.type);
+
+  // Held for the whole batch: pending calls die with their proxy
+  auto proxy    = m_proxyPool->get(m_gatt->path(characteristic));
+  auto progress = std::make_shared<Progress>();
+  auto start    = std::chrono::steady_clock::now();
+
+  auto windowOpen = [&]() {
+    return progress->inFlight < stats.window || progress->failed > 0;
+  };
+  auto drained = [&]() { return progress->inFlight == 0; };
+
+  for (size_t i = 0; i < count && progress->failed == 0; i++)
+  {
+    auto deadline = std::chrono::steady_clock::now() + WRITE_REPLY_TIMEOUT;
+    if (!waitUntil(windowOpen, deadline))
+    {
+      std::cerr << "Timed out waiting for WriteValue replies" << std::endl;
+      break;
+    }
+    if (progress->failed > 0)
+    {
+      break;
+    }
+
+    std::vector<uint8_t> value = valueAt(i);
+    size_t               size  = value.size();
+    progress->inFlight++;
+
+    try
+    {
+      auto sent = Metrics::now();
+      proxy->callMethodAsync("WriteValue")
+        .onInterface(GATT_CHAR_INTERFACE)
+        .withArguments(value, options)
+        .uponReplyInvoke(
+          [this, progress, size, sent](std::optional<sdbus::Error> error) {
+            recordReply(*m_metrics, Operation::WriteValue, sent, !error);
+            if (error)
+            {
+              if (progress->failed++ == 0)
+              {
+                std::cerr << "Error writing characteristic: "
+                          << error->what() << std::endl;
+              }
+            }
+            else
+            {
+              progress->written++;
+              progress->bytes += size;
+            }
+            progress->inFlight--;
+            notifyWaiters();
+          });
+    }
+    catch (const sdbus::Error& e)
+    {
+      progress->inFlight--;
+      progress->failed++;
+      std::cerr << "Error writing characteristic: " << e.what() << std::endl;
+    }
+  }
+
+  // Let every write still in flight report before returning
+  waitUntil(drained, std::chrono::steady_clock::now() + WRITE_REPLY_TIMEOUT);
+
+  stats.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start);
+  stats.written = progress->written;
+  stats.failed  = progress->failed + progress->inFlight;
+  stats.bytes   = progress->bytes;
+  return stats;
+}
+
+std::unique_ptr<CharacteristicWriter> BluetoothManager::acquireWriter(
+  const std::string& characteristicPath)
+{
+  TraceSpan span("acquireWriter", "manager", characteristicPath);
+  try
+  {
+    std::map<std::string, sdbus::Variant> options;
+    sdbus::UnixFd                         fd;
+    uint16_t                              mtu = 0;
+
+    OperationTimer timer(*m_metrics, Operation::AcquireWrite);
+    m_proxyPool->get(characteristicPath)
+      ->callMethod("AcquireWrite")
+      .onInterface(GATT_CHAR_INTERFACE)
+      .withArguments(options)
+      .storeResultsTo(fd, mtu);
+    timer.succeeded();
+    noteMtu(characteristicHandle(characteristicPath), mtu);
+
+    std::cout << "Write channel acquired (MTU " << mtu
+              << ") for characteristic: " << characteristicPath << std::endl;
+    return std::make_unique<CharacteristicWriter>(fd.release(), mtu);
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "AcquireWrite failed for characteristic, "
+              << characteristicPath << ": " << e.what() << std::endl;
+    return nullptr;
+  }
+}
+
 std::vector<uint8_t> BluetoothManager::readCharacteristic(
   const std::string& characteristicPath)
 {
+  return readCharacteristic(characteristicHandle(characteristicPath));
+}
+
+std::vector<uint8_t> BluetoothManager::readCharacteristic(
+  GattHandle characteristic)
+{
+  TraceSpan span("readCharacteristic", "manager", m_gatt->path(characteristic));
   try
   {
-    sdbus::ObjectPath path(characteristicPath);
-    auto              charProxy = sdbus::createProxy(
-      *m_connection, sdbus::ServiceName(BLUEZ_SERVICE), path);
+    auto charProxy = m_proxyPool->get(m_gatt->path(characteristic));
 
     std::map<std::string, sdbus::Variant> options;
     std::vector<uint8_t>                  value;
 
+    OperationTimer timer(*m_metrics, Operation::ReadValue);
     charProxy->callMethod("ReadValue")
       .onInterface(GATT_CHAR_INTERFACE)
       .withArguments(options)
       .storeResultsTo(value);
+    timer.succeeded();
 
     std::cout << "Read " << value.size() << " bytes from characteristic"
               << std::endl;
@@ -702,9 +1699,231 @@ std::vector<uint8_t> BluetoothManager::readCharacteristic(
   }
 }
 
+void BluetoothManager::readCharacteristicAsync(
+  const std::string& characteristicPath,
+  ValueCallback      done)
+{
+  readCharacteristicAsync(characteristicHandle(characteristicPath),
+                          std::move(done));
+}
+
+void BluetoothManager::readCharacteristicAsync(GattHandle    characteristic,
+                                               ValueCallback done)
+{
+  TraceSpan span(
+    "readCharacteristicAsync", "manager", m_gatt->path(characteristic));
+  try
+  {
+    auto charProxy = m_proxyPool->get(m_gatt->path(characteristic));
+
+    std::map<std::string, sdbus::Variant> options;
+
+    charProxy->callMethodAsync("ReadValue")
+      .onInterface(GATT_CHAR_INTERFACE)
+      .withArguments(options)
+      .uponReplyInvoke([charProxy, metrics = m_metrics, sent = Metrics::now(),
+                        done](std::optional<sdbus::Error> error,
+                              std::vector<uint8_t>        value) {
+        recordReply(*metrics, Operation::ReadValue, sent, !error);
+        if (error)
+        {
+          std::cerr << "Error reading characteristic: " << error->what()
+                    << std::endl;
+          done({});
+          return;
+        }
+        done(std::move(value));
+      });
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "Error reading characteristic: " << e.what() << std::endl;
+    done({});
+  }
+}
+
+std::future<std::vector<uint8_t>> BluetoothManager::readCharacteristicAsync(
+  const std::string& characteristicPath)
+{
+  return toFuture<std::vector<uint8_t>>([&](ValueCallback done) {
+    readCharacteristicAsync(characteristicPath, done);
+  });
+}
+
+void BluetoothManager::writeCharacteristicAsync(
+  const std::string&          characteristicPath,
+  const std::vector<uint8_t>& data,
+  ResultCallback              done,
+  WriteType                   type)
+{
+  writeCharacteristicAsync(
+    characteristicHandle(characteristicPath), data, std::move(done), type);
+}
+
+void BluetoothManager::writeCharacteristicAsync(
+  GattHandle                  characteristic,
+  const std::vector<uint8_t>& data,
+  ResultCallback              done,
+  WriteType                   type)
+{
+  TraceSpan span(
+    "writeCharacteristicAsync", "manager", m_gatt->path(characteristic));
+  try
+  {
+    auto charProxy = m_proxyPool->get(m_gatt->path(characteristic));
+    type           = resolveWriteType(characteristic, type);
+
+    charProxy->callMethodAsync("WriteValue")
+      .onInterface(GATT_CHAR_INTERFACE)
+      .withArguments(data, writeOptions(type))
+      .uponReplyInvoke([charProxy, metrics = m_metrics, sent = Metrics::now(),
+                        done](std::optional<sdbus::Error> error) {
+        recordReply(*metrics, Operation::WriteValue, sent, !error);
+        if (error)
+        {
+          std::cerr << "Error writing characteristic: " << error->what()
+                    << std::endl;
+        }
+        done(!error);
+      });
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "Error writing characteristic: " << e.what() << std::endl;
+    done(false);
+  }
+}
+
+std::future<bool> BluetoothManager::writeCharacteristicAsync(
+  const std::string&          characteristicPath,
+  const std::vector<uint8_t>& data,
+  WriteType                   type)
+{
+  return toFuture<bool>([&](ResultCallback done) {
+    writeCharacteristicAsync(characteristicPath, data, done, type);
+  });
+}
+
+std::map<std::string, sdbus::Variant> BluetoothManager::writeOptions(
+  WriteType type)
+{
+  std::map<std::string, sdbus::Variant> options;
+  options["type"] = sdbus::Variant(
+    std::string(type == WriteType::Command ? "command" : "request"));
+  return options;
+}
+
+void BluetoothManager::startEventLoop()
+{
+  if (m_eventLoopRunning.exchange(true))
+  {
+    return;
+  }
+
+  // sdbus-c++ runs the loop on its own thread: it blocks in poll() on the
+  // bus fd and drains every queued message on each wakeup
+  m_connection->enterEventLoopAsync();
+  wakeReadyTimer();
+}
+
+void BluetoothManager::stopEventLoop()
+{
+  if (!m_eventLoopRunning.exchange(false))
+  {
+    return;
+  }
+
+  m_connection->leaveEventLoop();
+  wakeReadyTimer();
+}
+
+bool BluetoothManager::isEventLoopRunning() const
+{
+  return m_eventLoopRunning;
+}
+
 void BluetoothManager::processEvents(int timeoutMs)
 {
-  (void)timeoutMs;  // Unused parameter
-  m_connection->processPendingEvent();
+  if (m_eventLoopRunning)
+  {
+    // The loop thread owns dispatching
+    return;
+  }
+
+  if (!m_connection->processPendingEvent())
+  {
+    waitForBusActivity(timeoutMs);
+  }
+  dispatchPendingEvents();
+  // Deadlines pass whether or not a signal arrived
+  checkReadyWaiters();
+}
+
+void BluetoothManager::dispatchPendingEvents()
+{
+  if (m_eventLoopRunning)
+  {
+    // The loop thread applies signals as soon as they arrive
+    return;
+  }
+
+  // Apply queued object tree signals before answering a query from the mirror
+  while (m_connection->processPendingEvent())
+  {
+  }
+}
+
+void BluetoothManager::waitForBusActivity(int timeoutMs)
+{
+  auto   pollData   = m_connection->getEventLoopPollData();
+  int    busTimeout = pollData.getPollTimeout();
+  pollfd fds[2]     = {{pollData.fd, pollData.events, 0},
+                       {pollData.eventFd, POLLIN, 0}};
+  if (busTimeout >= 0 && busTimeout < timeoutMs)
+  {
+    timeoutMs = busTimeout;
+  }
+  poll(fds, pollData.eventFd >= 0 ? 2 : 1, timeoutMs);
+}
+
+void BluetoothManager::notifyWaiters()
+{
+  // Taking the lock orders this wakeup after any in-progress predicate check
+  {
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+  }
+  m_waitCondition.notify_all();
+}
+
+bool BluetoothManager::waitUntil(
+  const std::function<bool()>&          predicate,
+  std::chrono::steady_clock::time_point deadline)
+{
+  TraceSpan span("waitUntil", "wait");
+  if (m_eventLoopRunning)
+  {
+    // Woken by notifyWaiters() whenever the loop thread changes state
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    return m_waitCondition.wait_until(lock, deadline, predicate);
+  }
+
+  while (true)
+  {
+    dispatchPendingEvents();
+    if (predicate())
+    {
+      return true;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0)
+    {
+      return false;
+    }
+
+    // Sleep until the bus has something for us rather than on a fixed tick
+    waitForBusActivity(static_cast<int>(remaining.count()));
+  }
 }
 } // namespace boot_module
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include "boot_module/capture_log.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace boot_module
+{
+namespace
+{
+size_t recordSize(size_t payload)
+{
+  size_t size = sizeof(CaptureRecordHeader) + payload;
+  return (size + CAPTURE_RECORD_ALIGN - 1) & ~(CAPTURE_RECORD_ALIGN - 1);
+}
+
+uint64_t realtimeNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+// Segment number of a file name of the form <base>.NNNN<suffix>, -1 if it
+// is not one
+long segmentNumber(const std::string& name, const std::string& base)
+{
+  const std::string suffix = CAPTURE_FILE_SUFFIX;
+  if (name.size() <= base.size() + 1 + suffix.size() ||
+      name.compare(0, base.size(), base) != 0 || name[base.size()] != '.' ||
+      name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+  {
+    return -1;
+  }
+  std::string digits = name.substr(
+    base.size() + 1, name.size() - base.size() - 1 - suffix.size());
+  if (digits.size() > 9 ||
+      digits.find_first_not_of("0123456789") != std::string::npos)
+  {
+    return -1;
+  }
+  return std::stol(digits);
+}
+
+// Every segment file of prefix, ordered by number; false if its directory
+// cannot be listed
+bool listSegments(const std::string& prefix, std::vector<std::string>& paths)
+{
+  size_t      slash     = prefix.rfind('/');
+  std::string directory = slash == std::string::npos ? "."
+                          : slash == 0               ? "/"
+                                                     : prefix.substr(0, slash);
+  std::string base =
+    slash == std::string::npos ? prefix : prefix.substr(slash + 1);
+
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+  {
+    std::cerr << "Cannot open " << directory << ": " << std::strerror(errno)
+              << std::endl;
+    return false;
+  }
+  std::vector<std::pair<long, std::string>> found;
+  while (dirent* entry = readdir(dir))
+  {
+    long number = segmentNumber(entry->d_name, base);
+    if (number >= 0)
+    {
+      found.emplace_back(number, directory + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+
+  std::sort(found.begin(), found.end());
+  paths.clear();
+  for (auto& segment : found)
+  {
+    paths.push_back(std::move(segment.second));
+  }
+  return true;
+}
+}  // namespace
+
+std::unique_ptr<CaptureLog> CaptureLog::create(const std::string&    prefix,
+                                               const CaptureOptions& options)
+{
+  // Segments left by an earlier, longer capture under the same prefix
+  // would be read back after this one's
+  std::vector<std::string> stale;
+  if (listSegments(prefix, stale))
+  {
+    for (const auto& path : stale)
+    {
+      unlink(path.c_str());
+    }
+  }
+
+  std::unique_ptr<CaptureLog> log(new CaptureLog(prefix, options));
+  std::lock_guard<std::mutex> lock(log->m_mutex);
+  if (!log->openSegment(0))
+  {
+    return nullptr;
+  }
+  return log;
+}
+
+CaptureLog::CaptureLog(const std::string& prefix, const CaptureOptions& options)
+  : m_prefix(prefix), m_options(options)
+{
+}
+
+CaptureLog::~CaptureLog()
+{
+  close();
+}
+
+void CaptureLog::describe(uint32_t characteristic, const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (characteristic >= m_names.size())
+  {
+    m_names.resize(characteristic + 1);
+    m_described.resize(characteristic + 1, false);
+  }
+  m_names[characteristic]     = path.substr(0, MAX_PAYLOAD);
+  m_described[characteristic] = false;
+}
+
+bool CaptureLog::append(uint32_t       characteristic,
+                        const uint8_t* data,
+                        size_t         size,
+                        uint64_t       timestampNs)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_base || size > MAX_PAYLOAD)
+  {
+    m_stats.dropped++;
+    return false;
+  }
+
+  bool   named     = characteristic < m_names.size() &&
+                     !m_names[characteristic].empty();
+  size_t nameBytes = named ? recordSize(m_names[characteristic].size()) : 0;
+  size_t needed    = recordSize(size);
+  if (m_offset + needed + nameBytes > m_options.segmentBytes)
+  {
+    // Too large even for an empty segment: rotating would not help
+    if (sizeof(CaptureFileHeader) + needed + nameBytes >
+          m_options.segmentBytes ||
+        !rotate())
+    {
+      m_stats.dropped++;
+      return false;
+    }
+  }
+
+  if (named && !m_described[characteristic])
+  {
+    const auto& name = m_names[characteristic];
+    writeRecord(CaptureRecordKind::Characteristic, characteristic, timestampNs,
+                reinterpret_cast<const uint8_t*>(name.data()), name.size());
+    m_described[characteristic] = true;
+  }
+  writeRecord(
+    CaptureRecordKind::Notification, characteristic, timestampNs, data, size);
+  m_stats.records++;
+  m_stats.bytes += size;
+  return true;
+}
+
+bool CaptureLog::append(uint32_t                    characteristic,
+                        const std::vector<uint8_t>& value)
+{
+  return append(characteristic, value.data(), value.size(), now());
+}
+
+CaptureStats CaptureLog::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+std::string CaptureLog::segmentPath(uint64_t segment) const
+{
+  char number[24];
+  std::snprintf(number, sizeof(number), ".%04llu",
+                static_cast<unsigned long long>(segment));
+  return m_prefix + number + CAPTURE_FILE_SUFFIX;
+}
+
+void CaptureLog::close()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  closeSegment();
+}
+
+bool CaptureLog::openSegment(uint64_t segment)
+{
+  std::string path = segmentPath(segment);
+  int         fd   = ::open(
+    path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Cannot create capture segment " << path << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  // Reserve the blocks up front so a full disk fails here and not as a
+  // SIGBUS on some later store into the mapping
+  size_t size  = m_options.segmentBytes;
+  int    error = posix_fallocate(fd, 0, static_cast<off_t>(size));
+  if (error == EOPNOTSUPP || error == EINVAL)
+  {
+    error = ftruncate(fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+  }
+  void* base = error == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, fd, 0)
+                          : MAP_FAILED;
+  if (base == MAP_FAILED)
+  {
+    std::cerr << "Cannot map capture segment " << path << ": "
+              << std::strerror(error ? error : errno) << std::endl;
+    ::close(fd);
+    unlink(path.c_str());
+    return false;
+  }
+  madvise(base, size, MADV_SEQUENTIAL);
+
+  m_fd      = fd;
+  m_base    = static_cast<uint8_t*>(base);
+  m_segment = segment;
+  m_stats.segments++;
+  std::fill(m_described.begin(), m_described.end(), false);
+
+  CaptureFileHeader header{};
+  std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+  header.version           = CAPTURE_VERSION;
+  header.headerSize        = sizeof(CaptureFileHeader);
+  header.segment           = segment;
+  header.createdRealtimeNs = realtimeNs();
+  header.createdSteadyNs   = now();
+  std::memcpy(m_base, &header, sizeof(header));
+  m_offset = sizeof(header);
+  return true;
+}
+
+void CaptureLog::closeSegment()
+{
+  if (!m_base)
+  {
+    return;
+  }
+
+  munmap(m_base, m_options.segmentBytes);
+  if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0)
+  {
+    // Still readable: the zero tail reads as the end of the segment
+    std::cerr << "Cannot trim capture segment " << segmentPath(m_segment)
+              << ": " << std::strerror(errno) << std::endl;
+  }
+  ::close(m_fd);
+  m_base = nullptr;
+  m_fd   = -1;
+}
+
+bool CaptureLog::rotate()
+{
+  closeSegment();
+
+  uint64_t next = m_segment + 1;
+  if (m_options.maxSegments > 0 && next >= m_options.maxSegments)
+  {
+    unlink(segmentPath(next - m_options.maxSegments).c_str());
+  }
+  return openSegment(next);
+}
+
+void CaptureLog::writeRecord(CaptureRecordKind kind,
+                             uint32_t          characteristic,
+                             uint64_t          timestampNs,
+                             const uint8_t*    data,
+                             size_t            size)
+{
+  CaptureRecordHeader header{timestampNs, characteristic,
+                             static_cast<uint16_t>(kind),
+                             static_cast<uint16_t>(size)};
+  uint8_t*            record = m_base + m_offset;
+  std::memcpy(record + sizeof(header), data, size);
+  std::memcpy(record, &header, sizeof(header));
+  // Padding stays zero: the segment was created empty
+  m_offset += recordSize(size);
+}
+
+std::unique_ptr<CaptureReader> CaptureReader::open(const std::string& prefix)
+{
+  // Oldest segments may have been deleted by rotation, so list the
+  // directory instead of counting up from 0
+  std::vector<std::string> segments;
+  if (!listSegments(prefix, segments))
+  {
+    return nullptr;
+  }
+  if (segments.empty())
+  {
+    std::cerr << "No capture segments found for " << prefix << std::endl;
+    return nullptr;
+  }
+  return std::unique_ptr<CaptureReader>(
+    new CaptureReader(std::move(segments)));
+}
+
+CaptureReader::CaptureReader(std::vector<std::string> segments)
+  : m_segments(std::move(segments))
+{
+  rewind();
+}
+
+CaptureReader::~CaptureReader()
+{
+  closeSegment();
+}
+
+bool CaptureReader::next(CaptureRecord& record)
+{
+  while (m_current < m_segments.size())
+  {
+    while (m_base && m_offset + sizeof(CaptureRecordHeader) <= m_size)
+    {
+      CaptureRecordHeader header;
+      std::memcpy(&header, m_base + m_offset, sizeof(header));
+      auto   kind = static_cast<CaptureRecordKind>(header.kind);
+      size_t end  = m_offset + sizeof(header) + header.size;
+      if (kind == CaptureRecordKind::End || end > m_size)
+      {
+        break;
+      }
+
+      const uint8_t* payload = m_base + m_offset + sizeof(header);
+      m_offset += recordSize(header.size);
+      if (kind == CaptureRecordKind::Characteristic)
+      {
+        if (header.characteristic >= m_names.size())
+        {
+          m_names.resize(header.characteristic + 1);
+        }
+        m_names[header.characteristic].assign(
+          reinterpret_cast<const char*>(payload), header.size);
+      }
+      else if (kind == CaptureRecordKind::Notification)
+      {
+        record.timestampNs    = header.timestampNs;
+        record.characteristic = header.characteristic;
+        record.data           = payload;
+        record.size           = header.size;
+        return true;
+      }
+      // Kinds from a later version are skipped
+    }
+
+    closeSegment();
+    // Failed segments are skipped; openSegment reported why
+    while (++m_current < m_segments.size() && !openSegment(m_current))
+    {
+    }
+  }
+  return false;
+}
+
+void CaptureReader::rewind()
+{
+  closeSegment();
+  m_current = 0;
+  while (m_current < m_segments.size() && !openSegment(m_current))
+  {
+    m_current++;
+  }
+}
+
+const std::string& CaptureReader::characteristicPath(uint32_t id) const
+{
+  static const std::string EMPTY;
+  return id < m_names.size() ? m_names[id] : EMPTY;
+}
+
+bool CaptureReader::openSegment(size_t index)
+{
+  const std::string& path = m_segments[index];
+  int                fd   = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat        info;
+  if (fd < 0 || fstat(fd, &info) != 0)
+  {
+    std::cerr << "Cannot open capture segment " << path << ": "
+              << std::strerror(errno) << std::endl;
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  void*  base = size >= sizeof(CaptureFileHeader)
+                  ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                  : MAP_FAILED;
+  // The mapping outlives the descriptor
+  ::close(fd);
+  if (base == MAP_FAILED)
+  {
+    std::cerr << "Cannot map capture segment " << path << std::endl;
+    return false;
+  }
+
+  CaptureFileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != CAPTURE_VERSION || header.headerSize < sizeof(header) ||
+      header.headerSize > size)
+  {
+    std::cerr << path << " is not a capture segment" << std::endl;
+    munmap(base, size);
+    return false;
+  }
+  madvise(base, size, MADV_SEQUENTIAL);
+
+  m_base   = static_cast<const uint8_t*>(base);
+  m_size   = size;
+  m_offset = header.headerSize;
+  return true;
+}
+
+void CaptureReader::closeSegment()
+{
+  if (m_base)
+  {
+    munmap(const_cast<uint8_t*>(m_base), m_size);
+    m_base = nullptr;
+  }
+}
+}  // namespace boot_module
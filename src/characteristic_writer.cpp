@@ -0,0 +1,264 @@
+#include "boot_module/characteristic_writer.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace boot_module
+{
+CharacteristicWriter::CharacteristicWriter(int fd, uint16_t mtu)
+  : m_fd(fd), m_mtu(mtu)
+{
+  // A bogus MTU still has to leave room for at least one byte per write
+  m_maxPayload = mtu > ATT_WRITE_HEADER ? mtu - ATT_WRITE_HEADER : 1;
+
+  int flags = fcntl(m_fd, F_GETFL);
+  if (flags >= 0)
+  {
+    fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+CharacteristicWriter::~CharacteristicWriter()
+{
+  close();
+}
+
+void CharacteristicWriter::close()
+{
+  if (m_fd >= 0)
+  {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+
+WriteStatus CharacteristicWriter::write(const uint8_t* data, size_t size)
+{
+  iovec part{const_cast<uint8_t*>(data), size};
+  return writev(&part, 1);
+}
+
+WriteStatus CharacteristicWriter::write(const std::vector<uint8_t>& value)
+{
+  return write(value.data(), value.size());
+}
+
+WriteStatus CharacteristicWriter::writev(const iovec* parts, int count)
+{
+  if (m_fd < 0)
+  {
+    return m_lastStatus = WriteStatus::Closed;
+  }
+
+  size_t size = 0;
+  for (int i = 0; i < count; i++)
+  {
+    size += parts[i].iov_len;
+  }
+  if (size > m_maxPayload)
+  {
+    return m_lastStatus = WriteStatus::TooLarge;
+  }
+
+  msghdr message{};
+  message.msg_iov    = const_cast<iovec*>(parts);
+  message.msg_iovlen = static_cast<size_t>(count);
+
+  ssize_t bytes;
+  do
+  {
+    bytes = sendmsg(m_fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+  } while (bytes < 0 && errno == EINTR);
+
+  if (bytes < 0)
+  {
+    return m_lastStatus = statusFromErrno();
+  }
+
+  m_stats.packets++;
+  m_stats.bytes += static_cast<uint64_t>(bytes);
+  return m_lastStatus = WriteStatus::Ok;
+}
+
+size_t CharacteristicWriter::writeBatch(
+  const std::vector<std::vector<uint8_t>>& packets)
+{
+  iovec  iov[BATCH_SIZE];
+  size_t total = 0;
+
+  while (total < packets.size())
+  {
+    size_t count = std::min(BATCH_SIZE, packets.size() - total);
+    for (size_t i = 0; i < count; i++)
+    {
+      const auto& packet = packets[total + i];
+      if (packet.size() > m_maxPayload)
+      {
+        // Send what precedes the oversized packet, then stop at it
+        count = i;
+        if (count == 0)
+        {
+          m_lastStatus = WriteStatus::TooLarge;
+          return total;
+        }
+        break;
+      }
+      iov[i] = {const_cast<uint8_t*>(packet.data()), packet.size()};
+    }
+
+    size_t      sent   = 0;
+    WriteStatus status = sendMessages(iov, count, sent);
+    total += sent;
+    if (status != WriteStatus::Ok)
+    {
+      return total;
+    }
+  }
+  return total;
+}
+
+size_t CharacteristicWriter::stream(const uint8_t* data, size_t size)
+{
+  iovec  iov[BATCH_SIZE];
+  size_t offset = 0;
+
+  while (offset < size)
+  {
+    size_t count = 0;
+    size_t end   = offset;
+    while (count < BATCH_SIZE && end < size)
+    {
+      size_t chunk = std::min(m_maxPayload, size - end);
+      iov[count++] = {const_cast<uint8_t*>(data + end), chunk};
+      end += chunk;
+    }
+
+    size_t      sent   = 0;
+    WriteStatus status = sendMessages(iov, count, sent);
+    for (size_t i = 0; i < sent; i++)
+    {
+      offset += iov[i].iov_len;
+    }
+    if (status != WriteStatus::Ok)
+    {
+      break;
+    }
+  }
+  return offset;
+}
+
+bool CharacteristicWriter::streamAll(const uint8_t* data,
+                                     size_t         size,
+                                     int            timeoutMs)
+{
+  size_t offset = 0;
+  while (offset < size)
+  {
+    offset += stream(data + offset, size - offset);
+    if (offset == size)
+    {
+      break;
+    }
+    if (m_lastStatus != WriteStatus::WouldBlock || !waitWritable(timeoutMs))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CharacteristicWriter::waitWritable(int timeoutMs)
+{
+  if (m_fd < 0)
+  {
+    return false;
+  }
+
+  pollfd descriptor{m_fd, POLLOUT, 0};
+  int    ready;
+  do
+  {
+    ready = poll(&descriptor, 1, timeoutMs);
+  } while (ready < 0 && errno == EINTR);
+
+  if (ready <= 0)
+  {
+    return false;
+  }
+  if (descriptor.revents & (POLLHUP | POLLERR | POLLNVAL))
+  {
+    m_lastStatus = WriteStatus::Closed;
+    return false;
+  }
+  return true;
+}
+
+WriteStatus CharacteristicWriter::sendMessages(const iovec* iov,
+                                               size_t       count,
+                                               size_t&      sent)
+{
+  sent = 0;
+  if (m_fd < 0)
+  {
+    return m_lastStatus = WriteStatus::Closed;
+  }
+
+  mmsghdr messages[BATCH_SIZE] = {};
+  for (size_t i = 0; i < count; i++)
+  {
+    messages[i].msg_hdr.msg_iov    = const_cast<iovec*>(&iov[i]);
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  while (sent < count)
+  {
+    int result = sendmmsg(m_fd,
+                          messages + sent,
+                          static_cast<unsigned>(count - sent),
+                          MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (result < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return m_lastStatus = statusFromErrno();
+    }
+
+    for (int i = 0; i < result; i++)
+    {
+      m_stats.bytes += iov[sent + i].iov_len;
+    }
+    m_stats.packets += static_cast<uint64_t>(result);
+    sent += static_cast<size_t>(result);
+  }
+  return m_lastStatus = WriteStatus::Ok;
+}
+
+WriteStatus CharacteristicWriter::statusFromErrno()
+{
+  switch (errno)
+  {
+    case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+    case EWOULDBLOCK:
+#endif
+    case ENOBUFS:
+      m_stats.wouldBlock++;
+      return WriteStatus::WouldBlock;
+    case EPIPE:
+    case ECONNRESET:
+    case ENOTCONN:
+      close();
+      return WriteStatus::Closed;
+    default:
+      return WriteStatus::Error;
+  }
+}
+}  // namespace boot_module
@@ -0,0 +1,219 @@
+#include "boot_module/connection_manager.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace boot_module
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// How often connectAll wakes up to enforce per-device timeouts
+constexpr std::chrono::milliseconds TIMEOUT_CHECK_INTERVAL{100};
+
+std::chrono::microseconds since(Clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start);
+}
+}  // namespace
+
+const char* toString(DeviceState state)
+{
+  switch (state)
+  {
+    case DeviceState::Queued:
+      return "queued";
+    case DeviceState::Connecting:
+      return "connecting";
+    case DeviceState::Ready:
+      return "ready";
+    case DeviceState::Failed:
+      return "failed";
+  }
+  return "unknown";
+}
+
+// State of one connectAll call. Completion handlers hold it by shared_ptr,
+// so a connect that finishes after its device was timed out lands here
+// rather than in a destroyed frame.
+struct ConnectionManager::Run : std::enable_shared_from_this<Run>
+{
+  BluetoothManager&              manager;
+  size_t                         parallelism;
+  std::chrono::milliseconds      timeout;
+  ProgressCallback               onProgress;
+  Clock::time_point              start = Clock::now();
+  std::mutex                     mutex;
+  std::condition_variable        condition;
+  std::vector<DeviceConnection>  devices;
+  std::vector<Clock::time_point> connectStarted;
+  size_t                         next     = 0;
+  size_t                         inFlight = 0;
+  size_t                         finished = 0;
+
+  Run(BluetoothManager&         manager,
+      size_t                    parallelism,
+      std::chrono::milliseconds timeout,
+      ProgressCallback          onProgress)
+    : manager(manager),
+      parallelism(parallelism),
+      timeout(timeout),
+      onProgress(std::move(onProgress))
+  {
+  }
+
+  // Start queued devices until the parallelism limit is reached
+  void launch()
+  {
+    while (true)
+    {
+      size_t           index;
+      DeviceConnection snapshot;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inFlight >= parallelism || next >= devices.size())
+        {
+          return;
+        }
+
+        index                 = next++;
+        auto& device          = devices[index];
+        device.state          = DeviceState::Connecting;
+        device.queued         = since(start);
+        connectStarted[index] = Clock::now();
+        inFlight++;
+        snapshot = device;
+      }
+      report(snapshot);
+
+      // May complete synchronously, e.g. when already connected
+      auto self = shared_from_this();
+      manager.connectDeviceAsync(
+        snapshot.address,
+        [self, index](bool ready) { self->complete(index, ready); },
+        timeout);
+    }
+  }
+
+  void complete(size_t index, bool ready)
+  {
+    DeviceConnection snapshot;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto&                       device = devices[index];
+      if (device.state != DeviceState::Connecting)
+      {
+        // Already failed by the timeout sweep
+        return;
+      }
+
+      device.state      = ready ? DeviceState::Ready : DeviceState::Failed;
+      device.connecting = since(connectStarted[index]);
+      inFlight--;
+      finished++;
+      snapshot = device;
+    }
+    condition.notify_all();
+    report(snapshot);
+    launch();
+  }
+
+  // Fail devices stuck in Connecting past the timeout so their slot frees up
+  void expire()
+  {
+    std::vector<DeviceConnection> expired;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (size_t i = 0; i < devices.size(); i++)
+      {
+        auto& device = devices[i];
+        if (device.state == DeviceState::Connecting &&
+            Clock::now() - connectStarted[i] > timeout)
+        {
+          device.state      = DeviceState::Failed;
+          device.connecting = since(connectStarted[i]);
+          inFlight--;
+          finished++;
+          expired.push_back(device);
+        }
+      }
+    }
+
+    for (const auto& device : expired)
+    {
+      std::cerr << "Connection timeout: " << device.address << std::endl;
+      report(device);
+    }
+    if (!expired.empty())
+    {
+      launch();
+    }
+  }
+
+  void report(const DeviceConnection& device)
+  {
+    if (onProgress)
+    {
+      onProgress(device);
+    }
+  }
+
+  bool done()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return finished == devices.size();
+  }
+};
+
+ConnectionManager::ConnectionManager(BluetoothManager&         manager,
+                                     size_t                    parallelism,
+                                     std::chrono::milliseconds timeout)
+  : m_manager(manager),
+    m_parallelism(std::max<size_t>(parallelism, 1)),
+    m_timeout(timeout)
+{
+}
+
+std::vector<DeviceConnection> ConnectionManager::connectAll(
+  const std::vector<std::string>& addresses,
+  ProgressCallback                onProgress)
+{
+  auto run = std::make_shared<Run>(
+    m_manager, m_parallelism, m_timeout, std::move(onProgress));
+  for (const auto& address : addresses)
+  {
+    DeviceConnection device;
+    device.address = address;
+    run->devices.push_back(std::move(device));
+  }
+  run->connectStarted.resize(addresses.size());
+
+  run->launch();
+
+  while (!run->done())
+  {
+    if (m_manager.isEventLoopRunning())
+    {
+      std::unique_lock<std::mutex> lock(run->mutex);
+      run->condition.wait_for(lock, TIMEOUT_CHECK_INTERVAL, [&run]() {
+        return run->finished == run->devices.size();
+      });
+    }
+    else
+    {
+      // Completions only run while someone dispatches
+      m_manager.processEvents(
+        static_cast<int>(TIMEOUT_CHECK_INTERVAL.count()));
+    }
+    run->expire();
+  }
+
+  std::lock_guard<std::mutex> lock(run->mutex);
+  return run->devices;
+}
+}  // namespace boot_module
@@ -0,0 +1,431 @@
+#include "boot_module/device_registry.hpp"
+
+#include <chrono>
+
+namespace boot_module
+{
+namespace
+{
+constexpr size_t MAC_TEXT_LENGTH = 17;
+constexpr size_t MIN_CAPACITY    = 16;
+
+uint64_t nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+int hexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Advertising activity, as opposed to connection state and the like
+bool isAdvertisement(const PropertyMap& props)
+{
+  return props.count("RSSI") || props.count("ManufacturerData");
+}
+}  // namespace
+
+bool parseMac(std::string_view text, MacAddress& mac, char separator)
+{
+  if (text.size() != MAC_TEXT_LENGTH)
+  {
+    return false;
+  }
+
+  MacAddress value = 0;
+  for (size_t i = 0; i < MAC_TEXT_LENGTH; i += 3)
+  {
+    int high = hexValue(text[i]);
+    int low  = hexValue(text[i + 1]);
+    if (high < 0 || low < 0 ||
+        (i + 2 < MAC_TEXT_LENGTH && text[i + 2] != separator))
+    {
+      return false;
+    }
+    value = (value << 8) | static_cast<MacAddress>(high << 4 | low);
+  }
+  mac = value;
+  return true;
+}
+
+std::string formatMac(MacAddress mac, char separator)
+{
+  static const char DIGITS[] = "0123456789ABCDEF";
+
+  std::string text(MAC_TEXT_LENGTH, separator);
+  for (size_t i = 0; i < 6; i++)
+  {
+    auto byte       = static_cast<uint8_t>(mac >> (40 - 8 * i));
+    text[i * 3]     = DIGITS[byte >> 4];
+    text[i * 3 + 1] = DIGITS[byte & 0x0f];
+  }
+  return text;
+}
+
+bool macFromPath(std::string_view path, MacAddress& mac)
+{
+  constexpr std::string_view PREFIX = "dev_";
+  if (path.size() < PREFIX.size() + MAC_TEXT_LENGTH)
+  {
+    return false;
+  }
+
+  auto name = path.substr(path.size() - PREFIX.size() - MAC_TEXT_LENGTH);
+  return name.substr(0, PREFIX.size()) == PREFIX &&
+         parseMac(name.substr(PREFIX.size()), mac, '_');
+}
+
+DeviceRegistry::DeviceRegistry(size_t expectedDevices)
+{
+  size_t capacity = MIN_CAPACITY;
+  while (capacity < expectedDevices * 2)
+  {
+    capacity *= 2;
+  }
+  rehash(capacity);
+}
+
+void DeviceRegistry::upsert(const std::string& path, const PropertyMap& props)
+{
+  MacAddress mac;
+  if (!macFromPath(path, mac))
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  if (rowOf(mac, row))
+  {
+    // A fresh property set replaces everything we had
+    PathTable::Id pathId = m_paths.intern(path);
+    if (pathId != m_pathIds[row])
+    {
+      m_paths.release(m_pathIds[row]);
+    }
+    m_rssi[row]    = 0;
+    m_flags[row]   = 0;
+    m_pathIds[row] = pathId;
+    m_cold[row]    = ColdFields{};
+  }
+  else
+  {
+    if ((m_macs.size() + 1) * 2 > m_keys.size())
+    {
+      rehash(m_keys.size() * 2);
+    }
+
+    row          = m_macs.size();
+    size_t slot  = slotOf(mac);
+    m_keys[slot] = mac;
+    m_rows[slot] = static_cast<uint32_t>(row);
+
+    m_macs.push_back(mac);
+    m_rssi.push_back(0);
+    m_flags.push_back(0);
+    m_lastSeenNs.push_back(0);
+    m_pathIds.push_back(m_paths.intern(path));
+    m_cold.emplace_back();
+  }
+
+  applyLocked(row, props);
+  m_lastSeenNs[row] = nowNs();
+}
+
+bool DeviceRegistry::apply(const std::string& path, const PropertyMap& changed)
+{
+  MacAddress mac;
+  if (!macFromPath(path, mac))
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  if (!rowOf(mac, row))
+  {
+    return false;
+  }
+
+  applyLocked(row, changed);
+  if (isAdvertisement(changed))
+  {
+    m_lastSeenNs[row] = nowNs();
+  }
+  return true;
+}
+
+bool DeviceRegistry::erase(MacAddress mac)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  size_t slot = slotOf(mac);
+  if (m_keys[slot] == EMPTY_KEY)
+  {
+    return false;
+  }
+  size_t row = m_rows[slot];
+
+  // Backward-shift deletion: pull later entries of the probe run into the
+  // hole so lookups never need tombstones
+  const size_t mask = m_keys.size() - 1;
+  size_t       hole = slot;
+  size_t       next = slot;
+  while (true)
+  {
+    next = (next + 1) & mask;
+    if (m_keys[next] == EMPTY_KEY)
+    {
+      break;
+    }
+    size_t home = homeOf(m_keys[next]);
+    // Move it unless its home lies cyclically within (hole, next]
+    bool stays = hole <= next ? (hole < home && home <= next)
+                              : (hole < home || home <= next);
+    if (!stays)
+    {
+      m_keys[hole] = m_keys[next];
+      m_rows[hole] = m_rows[next];
+      hole         = next;
+    }
+  }
+  m_keys[hole] = EMPTY_KEY;
+  // Rotating random addresses would otherwise grow the table forever
+  m_paths.release(m_pathIds[row]);
+
+  // Swap-remove the row, then point the moved device's slot at its new row
+  size_t last = m_macs.size() - 1;
+  if (row != last)
+  {
+    m_macs[row]       = m_macs[last];
+    m_rssi[row]       = m_rssi[last];
+    m_flags[row]      = m_flags[last];
+    m_lastSeenNs[row] = m_lastSeenNs[last];
+    m_pathIds[row]    = m_pathIds[last];
+    m_cold[row]       = std::move(m_cold[last]);
+
+    m_rows[slotOf(m_macs[row])] = static_cast<uint32_t>(row);
+  }
+  m_macs.pop_back();
+  m_rssi.pop_back();
+  m_flags.pop_back();
+  m_lastSeenNs.pop_back();
+  m_pathIds.pop_back();
+  m_cold.pop_back();
+  return true;
+}
+
+bool DeviceRegistry::contains(MacAddress mac) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  return rowOf(mac, row);
+}
+
+bool DeviceRegistry::find(MacAddress mac, DeviceInfo& info) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  if (!rowOf(mac, row))
+  {
+    return false;
+  }
+  info = infoAt(row);
+  return true;
+}
+
+bool DeviceRegistry::status(MacAddress mac, DeviceStatus& status) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  if (!rowOf(mac, row))
+  {
+    return false;
+  }
+  status.rssi       = m_rssi[row];
+  status.connected  = m_flags[row] & CONNECTED;
+  status.paired     = m_flags[row] & PAIRED;
+  status.lastSeenNs = m_lastSeenNs[row];
+  return true;
+}
+
+bool DeviceRegistry::advertises(MacAddress               mac,
+                                const std::vector<Uuid>& services) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  return rowOf(mac, row) && matchesAny(m_cold[row].serviceIds, services);
+}
+
+std::string DeviceRegistry::path(MacAddress mac) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      row;
+  return rowOf(mac, row) ? m_paths.path(m_pathIds[row]) : std::string();
+}
+
+size_t DeviceRegistry::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_macs.size();
+}
+
+std::vector<DeviceInfo> DeviceRegistry::snapshot(
+  const std::vector<Uuid>& services) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<DeviceInfo>     devices;
+  devices.reserve(services.empty() ? m_macs.size() : 0);
+  for (size_t row = 0; row < m_macs.size(); row++)
+  {
+    if (matchesAny(m_cold[row].serviceIds, services))
+    {
+      devices.push_back(infoAt(row));
+    }
+  }
+  return devices;
+}
+
+std::vector<MacAddress> DeviceRegistry::seenSince(uint64_t sinceNs) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<MacAddress>     macs;
+  for (size_t row = 0; row < m_lastSeenNs.size(); row++)
+  {
+    if (m_lastSeenNs[row] >= sinceNs)
+    {
+      macs.push_back(m_macs[row]);
+    }
+  }
+  return macs;
+}
+
+size_t DeviceRegistry::homeOf(MacAddress mac) const
+{
+  // Fibonacci hashing spreads the vendor-prefixed, often sequential
+  // addresses over the whole table
+  return static_cast<size_t>((mac * 0x9E3779B97F4A7C15ULL) >> m_shift);
+}
+
+size_t DeviceRegistry::slotOf(MacAddress mac) const
+{
+  const size_t mask = m_keys.size() - 1;
+  size_t       slot = homeOf(mac);
+  while (m_keys[slot] != mac && m_keys[slot] != EMPTY_KEY)
+  {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+bool DeviceRegistry::rowOf(MacAddress mac, size_t& row) const
+{
+  size_t slot = slotOf(mac);
+  if (m_keys[slot] == EMPTY_KEY)
+  {
+    return false;
+  }
+  row = m_rows[slot];
+  return true;
+}
+
+void DeviceRegistry::rehash(size_t capacity)
+{
+  m_keys.assign(capacity, EMPTY_KEY);
+  m_rows.assign(capacity, 0);
+
+  m_shift = 64;
+  for (size_t size = capacity; size > 1; size >>= 1)
+  {
+    m_shift--;
+  }
+
+  for (size_t row = 0; row < m_macs.size(); row++)
+  {
+    size_t slot  = slotOf(m_macs[row]);
+    m_keys[slot] = m_macs[row];
+    m_rows[slot] = static_cast<uint32_t>(row);
+  }
+}
+
+void DeviceRegistry::applyLocked(size_t row, const PropertyMap& props)
+{
+  auto setFlag = [this, row, &props](const char* name, uint8_t flag) {
+    auto it = props.find(name);
+    if (it != props.end())
+    {
+      if (it->second.get<bool>())
+      {
+        m_flags[row] |= flag;
+      }
+      else
+      {
+        m_flags[row] &= static_cast<uint8_t>(~flag);
+      }
+    }
+  };
+  setFlag("Connected", CONNECTED);
+  setFlag("Paired", PAIRED);
+  setFlag("Trusted", TRUSTED);
+
+  if (props.count("RSSI"))
+  {
+    m_rssi[row] = props.at("RSSI").get<int16_t>();
+  }
+
+  auto& cold = m_cold[row];
+  if (props.count("Name"))
+  {
+    cold.name = props.at("Name").get<std::string>();
+  }
+  if (props.count("Alias"))
+  {
+    cold.alias = props.at("Alias").get<std::string>();
+  }
+  if (props.count("UUIDs"))
+  {
+    cold.uuids      = props.at("UUIDs").get<std::vector<std::string>>();
+    cold.serviceIds = parseUuids(cold.uuids);
+  }
+  if (props.count("ManufacturerData"))
+  {
+    cold.manufacturerData.clear();
+    auto data = props.at("ManufacturerData")
+                  .get<std::map<uint16_t, sdbus::Variant>>();
+    for (const auto& [company, value] : data)
+    {
+      cold.manufacturerData[company] = value.get<std::vector<uint8_t>>();
+    }
+  }
+}
+
+DeviceInfo DeviceRegistry::infoAt(size_t row) const
+{
+  DeviceInfo info;
+  info.address          = formatMac(m_macs[row]);
+  info.name             = m_cold[row].name;
+  info.alias            = m_cold[row].alias;
+  info.paired           = m_flags[row] & PAIRED;
+  info.connected        = m_flags[row] & CONNECTED;
+  info.trusted          = m_flags[row] & TRUSTED;
+  info.uuids            = m_cold[row].uuids;
+  info.rssi             = m_rssi[row];
+  info.manufacturerData = m_cold[row].manufacturerData;
+  return info;
+}
+}  // namespace boot_module
@@ -0,0 +1,456 @@
+#include "boot_module/firmware_upload.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+
+#include "boot_module/characteristic_writer.hpp"
+#include "boot_module/trace.hpp"
+
+namespace boot_module
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t NO_RESEND = SIZE_MAX;
+
+uint32_t readLe32(const uint8_t* data)
+{
+  return static_cast<uint32_t>(data[0]) |
+         static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 |
+         static_cast<uint32_t>(data[3]) << 24;
+}
+
+void writeLe32(uint8_t* data, uint32_t value)
+{
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+  data[2] = static_cast<uint8_t>(value >> 16);
+  data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+double perSecond(size_t bytes, Clock::duration elapsed)
+{
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  return seconds > 0 ? bytes / seconds : 0;
+}
+}  // namespace
+
+std::vector<uint8_t> encodeUploadMessage(UploadMessage type, uint32_t value)
+{
+  std::vector<uint8_t> message{static_cast<uint8_t>(type)};
+  switch (type)
+  {
+    case UploadMessage::Credit:
+      message.push_back(static_cast<uint8_t>(value));
+      message.push_back(static_cast<uint8_t>(value >> 8));
+      break;
+    case UploadMessage::Abort:
+      message.push_back(static_cast<uint8_t>(value));
+      break;
+    default:
+      message.resize(1 + sizeof(uint32_t));
+      writeLe32(message.data() + 1, value);
+  }
+  return message;
+}
+
+const char* toString(UploadStatus status)
+{
+  switch (status)
+  {
+    case UploadStatus::Completed:
+      return "completed";
+    case UploadStatus::Disconnected:
+      return "disconnected";
+    case UploadStatus::TimedOut:
+      return "timed out";
+    case UploadStatus::Rejected:
+      return "rejected";
+    case UploadStatus::Cancelled:
+      return "cancelled";
+    case UploadStatus::Failed:
+      return "failed";
+  }
+  return "unknown";
+}
+
+std::unique_ptr<FirmwareImage> FirmwareImage::open(const std::string& path)
+{
+  int         fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0)
+  {
+    std::cerr << "Cannot open " << path << ": " << std::strerror(errno)
+              << std::endl;
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  if (size == 0 || size > UPLOAD_MAX_IMAGE)
+  {
+    std::cerr << path << ": image must be 1 byte to 2 GiB" << std::endl;
+    ::close(fd);
+    return nullptr;
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    std::cerr << "Cannot map " << path << ": " << std::strerror(errno)
+              << std::endl;
+    return nullptr;
+  }
+  // Sent front to back, mostly once
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  return std::unique_ptr<FirmwareImage>(
+    new FirmwareImage(path, static_cast<const uint8_t*>(data), size));
+}
+
+FirmwareImage::FirmwareImage(std::string    path,
+                             const uint8_t* data,
+                             size_t         size)
+  : m_path(std::move(path)), m_data(data), m_size(size)
+{
+}
+
+FirmwareImage::~FirmwareImage()
+{
+  munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+// State shared with the status notification and WriteValue reply
+// callbacks, which may still run after upload() has returned
+struct FirmwareUploader::Session
+{
+  std::mutex              mutex;
+  std::condition_variable changed;
+  size_t                  acknowledged = 0;
+  size_t                  credits      = 0;
+  size_t                  resendFrom   = NO_RESEND;
+  bool                    aborted      = false;
+  unsigned                abortCode    = 0;
+  // WriteValue calls in flight, when there is no AcquireWrite channel
+  size_t                  pendingWrites = 0;
+  bool                    writeFailed   = false;
+
+  void onStatus(const std::vector<uint8_t>& value)
+  {
+    if (value.empty())
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto type = static_cast<UploadMessage>(value[0]);
+      if (type == UploadMessage::Ack && value.size() >= 5)
+      {
+        acknowledged = std::max<size_t>(acknowledged, readLe32(&value[1]));
+      }
+      else if (type == UploadMessage::Credit && value.size() >= 3)
+      {
+        credits += value[1] | value[2] << 8;
+      }
+      else if (type == UploadMessage::Resend && value.size() >= 5)
+      {
+        resendFrom = std::min<size_t>(resendFrom, readLe32(&value[1]));
+      }
+      else if (type == UploadMessage::Abort && value.size() >= 2)
+      {
+        aborted   = true;
+        abortCode = value[1];
+      }
+      else
+      {
+        return;
+      }
+    }
+    changed.notify_all();
+  }
+
+  void onWritten(bool ok)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pendingWrites--;
+      writeFailed = writeFailed || !ok;
+    }
+    changed.notify_all();
+  }
+};
+
+FirmwareUploader::FirmwareUploader(BluetoothManager& manager)
+  : m_manager(manager)
+{
+}
+
+UploadResult FirmwareUploader::upload(const FirmwareImage&  image,
+                                      const UploadOptions& options)
+{
+  TraceSpan    span("upload", "upload", options.dataPath);
+  UploadResult result;
+  result.total        = image.size();
+  result.acknowledged = options.startOffset;
+
+  const auto start = Clock::now();
+  const auto total = image.size();
+  if (options.startOffset > total || options.dataPath.empty() ||
+      options.statusPath.empty())
+  {
+    std::cerr << "Invalid upload options" << std::endl;
+    return result;
+  }
+
+  auto session          = std::make_shared<Session>();
+  session->acknowledged = options.startOffset;
+  if (options.flow == FlowControl::Credits)
+  {
+    session->credits = options.window;
+  }
+  m_cancelled = false;
+
+  if (!m_manager.enableNotifications(
+        options.statusPath,
+        [session](const std::vector<uint8_t>& value) {
+          session->onStatus(value);
+        },
+        NotifyMode::Auto))
+  {
+    std::cerr << "Cannot subscribe to " << options.statusPath << std::endl;
+    return result;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    m_session = session;
+  }
+
+  // Write commands through the socket when BlueZ hands one out; the MTU
+  // it reports sizes the packets, else the one cached for the device
+  std::unique_ptr<CharacteristicWriter> writer =
+    m_manager.acquireWriter(options.dataPath);
+  GattHandle data      = m_manager.characteristicHandle(options.dataPath);
+  size_t     maxPacket = writer ? writer->maxPayload()
+                                : m_manager.maxWritePayload(data);
+  if (maxPacket <= UPLOAD_HEADER_SIZE)
+  {
+    std::cerr << "Packets of " << maxPacket
+              << " bytes leave no room for image data" << std::endl;
+    {
+      std::lock_guard<std::mutex> sessionLock(m_sessionMutex);
+      m_session.reset();
+    }
+    writer.reset();
+    m_manager.disableNotifications(options.statusPath);
+    result.status = UploadStatus::Failed;
+    return result;
+  }
+  size_t chunk = maxPacket - UPLOAD_HEADER_SIZE;
+  if (options.chunkSize > 0)
+  {
+    chunk = std::min(chunk, options.chunkSize);
+  }
+  size_t window    = std::max<size_t>(options.window, 1);
+  result.chunkSize = chunk;
+  // A zero interval would report on every pass and never get to writing
+  const auto interval =
+    std::max(options.progressInterval, std::chrono::milliseconds(1));
+
+  size_t next       = options.startOffset;
+  size_t highest    = options.startOffset;
+  size_t lastAcked  = options.startOffset;
+  size_t retries    = 0;
+  auto   lastAck    = start;
+  auto   nextReport = start + interval;
+  int    waitMs     = static_cast<int>(options.ackTimeout.count());
+
+  auto report = [&](size_t acknowledged) {
+    if (options.progress)
+    {
+      auto elapsed = Clock::now() - start;
+      options.progress(
+        {acknowledged, total,
+         perSecond(acknowledged - options.startOffset, elapsed),
+         std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)});
+    }
+  };
+
+  std::unique_lock<std::mutex> lock(session->mutex);
+  while (true)
+  {
+    if (m_cancelled)
+    {
+      result.status = UploadStatus::Cancelled;
+      break;
+    }
+    if (session->aborted)
+    {
+      std::cerr << "Module aborted the upload (code " << session->abortCode
+                << ")" << std::endl;
+      result.status = UploadStatus::Rejected;
+      break;
+    }
+    if (session->acknowledged >= total)
+    {
+      result.status = UploadStatus::Completed;
+      break;
+    }
+    if (session->writeFailed)
+    {
+      result.status = UploadStatus::Disconnected;
+      break;
+    }
+
+    auto now = Clock::now();
+    if (session->acknowledged > lastAcked)
+    {
+      lastAcked = session->acknowledged;
+      lastAck   = now;
+      retries   = 0;
+      next      = std::max(next, lastAcked);
+    }
+    if (session->resendFrom != NO_RESEND)
+    {
+      next                = std::max(session->resendFrom, lastAcked);
+      session->resendFrom = NO_RESEND;
+    }
+    if (now >= nextReport)
+    {
+      nextReport = now + interval;
+      lock.unlock();
+      report(lastAcked);
+      lock.lock();
+      continue;
+    }
+
+    bool open = next < total &&
+                (options.flow == FlowControl::Window
+                   ? next - lastAcked < window * chunk
+                   : session->credits > 0) &&
+                (writer || session->pendingWrites < window);
+    if (!open)
+    {
+      auto deadline = lastAck + options.ackTimeout;
+      if (now < deadline)
+      {
+        session->changed.wait_until(lock, std::min(deadline, nextReport));
+        continue;
+      }
+      // Go back N: whatever followed the last ack is presumed lost
+      if (retries++ >= options.retries)
+      {
+        result.status = UploadStatus::TimedOut;
+        break;
+      }
+      next    = lastAcked;
+      lastAck = now;
+      continue;
+    }
+
+    size_t   size   = std::min(chunk, total - next);
+    uint32_t offset = static_cast<uint32_t>(next);
+    if (next + size == total)
+    {
+      offset |= UPLOAD_LAST_PACKET;
+    }
+    if (options.flow == FlowControl::Credits)
+    {
+      session->credits--;
+    }
+    if (!writer)
+    {
+      session->pendingWrites++;
+    }
+    lock.unlock();
+
+    uint8_t header[UPLOAD_HEADER_SIZE];
+    writeLe32(header, offset);
+    bool sent = true;
+    if (writer)
+    {
+      iovec parts[2] = {{header, sizeof(header)},
+                        {const_cast<uint8_t*>(image.data() + next), size}};
+      WriteStatus status = writer->writev(parts, 2);
+      while (status == WriteStatus::WouldBlock && !m_cancelled &&
+             writer->waitWritable(waitMs))
+      {
+        status = writer->writev(parts, 2);
+      }
+      sent = status == WriteStatus::Ok;
+    }
+    else
+    {
+      std::vector<uint8_t> packet(header, header + sizeof(header));
+      packet.insert(
+        packet.end(), image.data() + next, image.data() + next + size);
+      m_manager.writeCharacteristicAsync(
+        data,
+        packet,
+        [session](bool ok) { session->onWritten(ok); },
+        WriteType::Command);
+    }
+
+    lock.lock();
+    if (!sent)
+    {
+      // Checked at the top, after a cancel
+      session->writeFailed = !m_cancelled;
+      continue;
+    }
+    result.packets++;
+    result.sent += size;
+    if (next < highest)
+    {
+      result.retransmitted += std::min(size, highest - next);
+    }
+    next    = next + size;
+    highest = std::max(highest, next);
+  }
+  size_t acknowledged = std::min(session->acknowledged, total);
+  lock.unlock();
+
+  {
+    std::lock_guard<std::mutex> sessionLock(m_sessionMutex);
+    m_session.reset();
+  }
+  writer.reset();
+  m_manager.disableNotifications(options.statusPath);
+
+  auto elapsed        = Clock::now() - start;
+  result.acknowledged = acknowledged;
+  result.elapsed =
+    std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+  result.bytesPerSecond =
+    perSecond(acknowledged - options.startOffset, elapsed);
+  report(acknowledged);
+  return result;
+}
+
+void FirmwareUploader::cancel()
+{
+  m_cancelled = true;
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  if (m_session)
+  {
+    // Taking the session lock orders the flag before the waiter's check
+    std::lock_guard<std::mutex> sessionLock(m_session->mutex);
+    m_session->changed.notify_all();
+  }
+}
+}  // namespace boot_module
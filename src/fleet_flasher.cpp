@@ -0,0 +1,526 @@
+#include "boot_module/fleet_flasher.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "boot_module/device_registry.hpp"
+#include "boot_module/json.hpp"
+#include "boot_module/trace.hpp"
+
+namespace boot_module
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Adapter part of a device path, "/org/bluez/hci0" for
+// "/org/bluez/hci0/dev_00_11_22_33_44_55"
+std::string adapterOf(const std::string& devicePath)
+{
+  return devicePath.substr(0, devicePath.rfind("/dev_"));
+}
+
+double seconds(std::chrono::milliseconds duration)
+{
+  return duration.count() / 1000.0;
+}
+
+template <typename Duration>
+std::chrono::milliseconds toMs(Duration duration)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+}
+}  // namespace
+
+bool parseFleetManifest(const std::string&     manifest,
+                        std::vector<FleetJob>& jobs,
+                        std::string&           error)
+{
+  std::vector<FleetJob> parsed;
+  std::set<MacAddress>  seen;
+  std::istringstream    lines(manifest);
+  size_t                number = 0;
+  for (std::string line; std::getline(lines, line);)
+  {
+    number++;
+    line = line.substr(0, line.find('#'));
+
+    std::istringstream       stream(line);
+    std::vector<std::string> words;
+    for (std::string word; stream >> word;)
+    {
+      words.push_back(word);
+    }
+    if (words.empty())
+    {
+      continue;
+    }
+
+    MacAddress mac = 0;
+    if (words.size() != 2)
+    {
+      error = "expected ADDRESS IMAGE";
+    }
+    else if (!parseMac(words[0], mac))
+    {
+      error = "bad address " + words[0];
+    }
+    else if (!seen.insert(mac).second)
+    {
+      error = "device " + words[0] + " listed twice";
+    }
+    else
+    {
+      parsed.push_back({formatMac(mac), words[1]});
+      continue;
+    }
+    error = "line " + std::to_string(number) + ": " + error;
+    return false;
+  }
+
+  jobs = std::move(parsed);
+  return true;
+}
+
+std::string toJson(const FleetDeviceResult& result)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"device\":" << jsonString(result.address)
+       << ",\"image\":" << jsonString(result.image)
+       << ",\"adapter\":" << jsonString(result.adapter) << ",\"status\":\""
+       << toString(result.status) << "\",\"attempts\":" << result.attempts
+       << ",\"bytes\":" << result.acknowledged << ",\"total\":" << result.total
+       << ",\"elapsed_ms\":" << result.duration.count()
+       << ",\"upload_ms\":" << result.uploading.count()
+       << ",\"bytes_per_sec\":" << result.bytesPerSecond;
+  if (!result.error.empty())
+  {
+    json << ",\"error\":" << jsonString(result.error);
+  }
+  json << "}";
+  return json.str();
+}
+
+std::string toJson(const FleetReport& report)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"summary\":{\"devices\":" << report.devices.size()
+       << ",\"succeeded\":" << report.succeeded
+       << ",\"failed\":" << report.failed
+       << ",\"elapsed_ms\":" << report.elapsed.count()
+       << ",\"bytes_per_sec\":" << report.bytesPerSecond << "}}";
+  return json.str();
+}
+
+void FleetReport::writeText(std::ostream& out) const
+{
+  out << std::left << std::setw(19) << "Device" << std::setw(17) << "Adapter"
+      << std::setw(14) << "Status" << std::right << std::setw(4) << "Try"
+      << std::setw(11) << "Bytes" << std::setw(9) << "Seconds"
+      << std::setw(10) << "KiB/s" << "\n";
+  out << std::fixed << std::setprecision(1);
+  for (const auto& device : devices)
+  {
+    out << std::left << std::setw(19) << device.address << std::setw(17)
+        << device.adapter << std::setw(14) << toString(device.status)
+        << std::right << std::setw(4) << device.attempts << std::setw(11)
+        << device.acknowledged << std::setw(9) << seconds(device.duration)
+        << std::setw(10) << device.bytesPerSecond / 1024.0;
+    if (!device.error.empty())
+    {
+      out << "  " << device.error;
+    }
+    out << "\n";
+  }
+  out << succeeded << " of " << devices.size() << " devices flashed in "
+      << seconds(elapsed) << " s, " << bytesPerSecond / 1024.0
+      << " KiB/s overall" << std::endl;
+}
+
+struct FleetFlasher::Run
+{
+  struct Queued
+  {
+    size_t            index;
+    Clock::time_point notBefore;
+  };
+
+  DoneCallback                      onDone;
+  std::vector<FleetDeviceResult>    results;
+  std::vector<const FirmwareImage*> images;
+  std::vector<Clock::time_point>    started;
+
+  std::mutex              mutex;
+  std::condition_variable condition;
+  // Waiting devices in manifest order, retries behind their backoff
+  std::vector<Queued>     queue;
+  size_t                  remaining = 0;
+
+  Run(size_t devices, DoneCallback onDone)
+    : onDone(std::move(onDone)),
+      results(devices),
+      images(devices, nullptr),
+      started(devices)
+  {
+  }
+};
+
+FleetFlasher::FleetFlasher(BluetoothManager& manager,
+                           const FleetOptions& options)
+  : m_manager(manager), m_options(options)
+{
+  m_options.parallelism = std::max<size_t>(m_options.parallelism, 1);
+  m_options.attempts    = std::max<size_t>(m_options.attempts, 1);
+}
+
+FleetReport FleetFlasher::run(const std::vector<FleetJob>& jobs,
+                              DoneCallback                 onDone)
+{
+  TraceSpan  span("flashFleet", "fleet");
+  const auto start = Clock::now();
+  auto       run   = std::make_shared<Run>(jobs.size(), std::move(onDone));
+  m_cancelled      = false;
+  {
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    m_run = run;
+  }
+
+  // Each image is mapped once, however many devices it goes to
+  std::map<std::string, std::unique_ptr<FirmwareImage>> images;
+  for (size_t i = 0; i < jobs.size(); i++)
+  {
+    auto& result   = run->results[i];
+    result.address = jobs[i].address;
+    result.image   = jobs[i].image;
+    result.adapter = adapterOf(m_manager.getDevicePath(jobs[i].address));
+
+    auto it = images.find(jobs[i].image);
+    if (it == images.end())
+    {
+      it = images.emplace(jobs[i].image, FirmwareImage::open(jobs[i].image))
+             .first;
+    }
+    if (!it->second)
+    {
+      result.error = "cannot open image";
+      if (run->onDone)
+      {
+        run->onDone(result);
+      }
+      continue;
+    }
+    run->images[i] = it->second.get();
+    result.total   = it->second->size();
+    run->queue.push_back({i, start});
+  }
+  if (m_options.discoveryTimeout.count() > 0)
+  {
+    locate(*run);
+  }
+  run->remaining = run->queue.size();
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min(m_options.parallelism, run->remaining);
+       i++)
+  {
+    workers.emplace_back([this, run]() { worker(*run); });
+  }
+  worker(*run);
+  for (auto& thread : workers)
+  {
+    thread.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    m_run.reset();
+  }
+
+  // Devices never reached or waiting out a backoff when cancelled
+  for (const auto& queued : run->queue)
+  {
+    auto& result  = run->results[queued.index];
+    result.status = UploadStatus::Cancelled;
+    if (run->onDone)
+    {
+      run->onDone(result);
+    }
+  }
+
+  FleetReport report;
+  report.devices = std::move(run->results);
+  report.elapsed = toMs(Clock::now() - start);
+  size_t bytes   = 0;
+  for (const auto& device : report.devices)
+  {
+    (device.ok() ? report.succeeded : report.failed)++;
+    bytes += device.acknowledged;
+  }
+  if (report.elapsed.count() > 0)
+  {
+    report.bytesPerSecond = bytes / seconds(report.elapsed);
+  }
+  return report;
+}
+
+void FleetFlasher::cancel()
+{
+  std::shared_ptr<Run> run;
+  {
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    m_cancelled = true;
+    for (FirmwareUploader* uploader : m_active)
+    {
+      uploader->cancel();
+    }
+    run = m_run;
+  }
+  if (run)
+  {
+    // Take the run's lock so a worker between its check and its wait
+    // cannot miss the wakeup
+    std::lock_guard<std::mutex> lock(run->mutex);
+    run->condition.notify_all();
+  }
+}
+
+void FleetFlasher::locate(Run& run)
+{
+  // BlueZ only connects to devices it has seen advertise; without this the
+  // rest would spend every attempt failing to connect
+  std::set<MacAddress> missing;
+  for (const auto& queued : run.queue)
+  {
+    MacAddress mac;
+    if (parseMac(run.results[queued.index].address, mac) &&
+        !m_manager.devices().contains(mac))
+    {
+      missing.insert(mac);
+    }
+  }
+  if (missing.empty())
+  {
+    return;
+  }
+
+  TraceSpan        span("locateDevices", "fleet");
+  DiscoveryOptions options;
+  options.timeout = m_options.discoveryTimeout;
+  // Called one device at a time, and never after discover() returns
+  options.stopWhen = [&missing](const DeviceInfo& device) {
+    MacAddress mac;
+    if (parseMac(device.address, mac))
+    {
+      missing.erase(mac);
+    }
+    return missing.empty();
+  };
+  if (m_manager.discover(options).reason == DiscoveryStop::Error)
+  {
+    // Scanning is unavailable; let the attempts find out
+    return;
+  }
+
+  auto it = run.queue.begin();
+  while (it != run.queue.end())
+  {
+    auto&      result = run.results[it->index];
+    MacAddress mac;
+    if (!parseMac(result.address, mac) || !missing.count(mac))
+    {
+      ++it;
+      continue;
+    }
+    result.error = "not found";
+    if (run.onDone)
+    {
+      run.onDone(result);
+    }
+    it = run.queue.erase(it);
+  }
+}
+
+void FleetFlasher::worker(Run& run)
+{
+  std::unique_lock<std::mutex> lock(run.mutex);
+  while (!m_cancelled && run.remaining > 0)
+  {
+    // First device that is due; failing that, sleep until the earliest
+    // backoff ends or a retry is queued
+    const auto now  = Clock::now();
+    auto       next = Clock::time_point::max();
+    auto       pick = run.queue.end();
+    for (auto it = run.queue.begin(); it != run.queue.end(); ++it)
+    {
+      if (it->notBefore <= now)
+      {
+        pick = it;
+        break;
+      }
+      next = std::min(next, it->notBefore);
+    }
+
+    if (pick == run.queue.end())
+    {
+      if (next == Clock::time_point::max())
+      {
+        run.condition.wait(lock);
+      }
+      else
+      {
+        run.condition.wait_until(lock, next);
+      }
+      continue;
+    }
+
+    size_t index = pick->index;
+    run.queue.erase(pick);
+    lock.unlock();
+
+    attempt(run, index);
+
+    lock.lock();
+    run.condition.notify_all();
+  }
+}
+
+void FleetFlasher::attempt(Run& run, size_t index)
+{
+  auto&       result  = run.results[index];
+  const auto& address = result.address;
+  TraceSpan   span("flashDevice", "fleet", address);
+
+  if (result.attempts++ == 0)
+  {
+    run.started[index] = Clock::now();
+  }
+
+  std::string dataPath;
+  std::string statusPath;
+  if (!m_manager.connectDevice(address, m_options.connectTimeout))
+  {
+    result.status = UploadStatus::Disconnected;
+    result.error  = "connect failed";
+  }
+  else if (!resolve(address, dataPath, statusPath))
+  {
+    result.status = UploadStatus::Failed;
+    result.error  = "boot characteristics not found";
+  }
+  else
+  {
+    UploadOptions options = m_options.upload;
+    options.dataPath      = dataPath;
+    options.statusPath    = statusPath;
+    // The module keeps what it acknowledged across a reconnect
+    options.startOffset   = result.acknowledged;
+
+    FirmwareUploader uploader(m_manager);
+    // upload() clears a cancel that lands before it starts, so a cancelled
+    // flasher repeats it at the first progress report
+    options.progress = [this, &uploader](const UploadProgress&) {
+      if (m_cancelled)
+      {
+        uploader.cancel();
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(m_activeMutex);
+      m_active.insert(&uploader);
+    }
+    UploadResult upload;
+    upload.status = UploadStatus::Cancelled;
+    if (!m_cancelled)
+    {
+      upload = uploader.upload(*run.images[index], options);
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_activeMutex);
+      m_active.erase(&uploader);
+    }
+
+    result.status = upload.status;
+    result.error  = upload.ok() ? "" : toString(upload.status);
+    result.uploading += upload.elapsed;
+    result.acknowledged = std::max(result.acknowledged, upload.acknowledged);
+  }
+
+  if (m_options.disconnectAfter)
+  {
+    m_manager.disconnectDevice(address);
+  }
+
+  const bool done = result.ok() ||
+                    result.status == UploadStatus::Rejected ||
+                    result.status == UploadStatus::Cancelled ||
+                    result.attempts >= m_options.attempts || m_cancelled;
+  if (!done)
+  {
+    auto backoff = m_options.backoff;
+    for (size_t i = 1; i < result.attempts && backoff < m_options.maxBackoff;
+         i++)
+    {
+      backoff *= 2;
+    }
+    backoff = std::min(backoff, m_options.maxBackoff);
+
+    std::lock_guard<std::mutex> lock(run.mutex);
+    // Behind every device not tried yet
+    run.queue.push_back({index, Clock::now() + backoff});
+    return;
+  }
+
+  result.duration = toMs(Clock::now() - run.started[index]);
+  if (result.uploading.count() > 0)
+  {
+    result.bytesPerSecond = result.acknowledged / seconds(result.uploading);
+  }
+  if (run.onDone)
+  {
+    run.onDone(result);
+  }
+
+  std::lock_guard<std::mutex> lock(run.mutex);
+  run.remaining--;
+}
+
+bool FleetFlasher::resolve(const std::string& address,
+                           std::string&       dataPath,
+                           std::string&       statusPath)
+{
+  // Both from the same service, the first that has them
+  for (const auto& service : m_manager.getServices(address))
+  {
+    dataPath.clear();
+    statusPath.clear();
+    for (const auto& info : m_manager.getCharacteristics(service.handle))
+    {
+      Uuid uuid;
+      if (!Uuid::parse(info.uuid, uuid))
+      {
+        continue;
+      }
+      if (uuid == m_options.dataCharacteristic)
+      {
+        dataPath = info.path;
+      }
+      else if (uuid == m_options.statusCharacteristic)
+      {
+        statusPath = info.path;
+      }
+    }
+    if (!dataPath.empty() && !statusPath.empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace boot_module
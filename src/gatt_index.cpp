@@ -0,0 +1,193 @@
+#include "boot_module/gatt_index.hpp"
+
+#include <algorithm>
+
+#include "boot_module/bluez_constants.hpp"
+
+namespace boot_module
+{
+namespace
+{
+// Levels of parents linked above each kind of object: BlueZ nests
+// characteristics under their service and services under their device
+constexpr int SERVICE_LEVELS        = 1;
+constexpr int CHARACTERISTIC_LEVELS = 2;
+}  // namespace
+
+void GattIndex::apply(ObjectTree::Change change,
+                      const std::string& path,
+                      const std::string& interface,
+                      const PropertyMap& props)
+{
+  bool isCharacteristic = interface == GATT_CHAR_INTERFACE;
+  if (!isCharacteristic && interface != GATT_SERVICE_INTERFACE)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  switch (change)
+  {
+    case ObjectTree::Change::InterfacesAdded:
+    {
+      GattHandle handle = internLocked(
+        path, isCharacteristic ? CHARACTERISTIC_LEVELS : SERVICE_LEVELS);
+      auto& node   = m_nodes[handle.id];
+      node.present = true;
+      if (props.count("UUID"))
+      {
+        node.uuid = props.at("UUID").get<std::string>();
+      }
+      if (props.count("Flags"))
+      {
+        node.flags = props.at("Flags").get<std::vector<std::string>>();
+      }
+      break;
+    }
+    case ObjectTree::Change::InterfacesRemoved:
+    {
+      GattHandle handle{m_paths.find(path)};
+      if (handle.valid())
+      {
+        m_nodes[handle.id].present = false;
+      }
+      break;
+    }
+    case ObjectTree::Change::PropertiesChanged:
+      // UUID and Flags never change
+      break;
+  }
+}
+
+GattHandle GattIndex::find(std::string_view path) const
+{
+  return GattHandle{m_paths.find(path)};
+}
+
+const std::string& GattIndex::path(GattHandle handle) const
+{
+  static const std::string NONE;
+  return handle.valid() && handle.id < m_paths.size() ? m_paths.path(handle.id)
+                                                      : NONE;
+}
+
+bool GattIndex::hasFlag(GattHandle handle, std::string_view flag) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!presentLocked(handle))
+  {
+    return false;
+  }
+  const auto& flags = m_nodes[handle.id].flags;
+  return std::find(flags.begin(), flags.end(), flag) != flags.end();
+}
+
+GattHandle GattIndex::device(GattHandle handle) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!handle.valid() || handle.id >= m_nodes.size())
+  {
+    return GattHandle{};
+  }
+  // Devices are the only nodes without a parent
+  while (m_nodes[handle.id].parent.valid())
+  {
+    handle = m_nodes[handle.id].parent;
+  }
+  return handle;
+}
+
+std::vector<ServiceInfo> GattIndex::services(GattHandle device) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<ServiceInfo>    services;
+  if (!device.valid() || device.id >= m_nodes.size())
+  {
+    return services;
+  }
+
+  for (GattHandle child : m_nodes[device.id].children)
+  {
+    if (m_nodes[child.id].present)
+    {
+      ServiceInfo service;
+      service.path   = m_paths.path(child.id);
+      service.uuid   = m_nodes[child.id].uuid;
+      service.handle = child;
+      services.push_back(std::move(service));
+    }
+  }
+  return services;
+}
+
+std::vector<CharacteristicInfo> GattIndex::characteristics(
+  GattHandle service) const
+{
+  std::lock_guard<std::mutex>     lock(m_mutex);
+  std::vector<CharacteristicInfo> characteristics;
+  if (!service.valid() || service.id >= m_nodes.size())
+  {
+    return characteristics;
+  }
+
+  for (GattHandle child : m_nodes[service.id].children)
+  {
+    const auto& node = m_nodes[child.id];
+    if (node.present)
+    {
+      characteristics.push_back(
+        CharacteristicInfo{m_paths.path(child.id), node.uuid, node.flags,
+                           child});
+    }
+  }
+  return characteristics;
+}
+
+std::vector<GattHandle> GattIndex::subtree(GattHandle device) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<GattHandle>     handles;
+  if (!device.valid() || device.id >= m_nodes.size())
+  {
+    return handles;
+  }
+
+  for (GattHandle service : m_nodes[device.id].children)
+  {
+    const auto& children = m_nodes[service.id].children;
+    handles.insert(handles.end(), children.begin(), children.end());
+  }
+  return handles;
+}
+
+size_t GattIndex::size() const
+{
+  return m_paths.size();
+}
+
+GattHandle GattIndex::internLocked(const std::string& path, int levels)
+{
+  GattHandle handle{m_paths.intern(path)};
+  if (handle.id >= m_nodes.size())
+  {
+    m_nodes.resize(handle.id + 1);
+  }
+
+  // Linked once, on first sight; a node never moves to another parent
+  size_t slash = path.rfind('/');
+  if (levels > 0 && !m_nodes[handle.id].parent.valid() && slash != 0 &&
+      slash != std::string::npos)
+  {
+    GattHandle parent = internLocked(path.substr(0, slash), levels - 1);
+    m_nodes[handle.id].parent = parent;
+    m_nodes[parent.id].children.push_back(handle);
+  }
+  return handle;
+}
+
+bool GattIndex::presentLocked(GattHandle handle) const
+{
+  return handle.valid() && handle.id < m_nodes.size() &&
+         m_nodes[handle.id].present;
+}
+}  // namespace boot_module
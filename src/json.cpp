@@ -0,0 +1,35 @@
+#include "boot_module/json.hpp"
+
+#include <cstdio>
+
+namespace boot_module
+{
+std::string jsonString(const std::string& text)
+{
+  std::string json = "\"";
+  for (char c : text)
+  {
+    switch (c)
+    {
+      case '"':
+        json += "\\\"";
+        break;
+      case '\\':
+        json += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          json += escaped;
+        }
+        else
+        {
+          json += c;
+        }
+    }
+  }
+  return json + "\"";
+}
+}  // namespace boot_module
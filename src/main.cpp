@@ -1,11 +1,283 @@
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 
+#include "boot_module/batch_runner.hpp"
 #include "boot_module/bluetooth_cli.hpp"
+#include "boot_module/fleet_flasher.hpp"
+#include "boot_module/trace.hpp"
 
+namespace
+{
+void printUsage(const char* program)
+{
+  std::cerr
+    << "Usage: " << program << " [options]\n"
+    << "  --batch FILE        run the commands in FILE ('-' for stdin)\n"
+    << "                      instead of the menu\n"
+    << "  --exec SCRIPT       run SCRIPT, commands separated by ';'\n"
+    << "  --flash FILE        flash the devices listed in FILE, one\n"
+    << "                      'ADDRESS IMAGE' per line, instead of the menu\n"
+    << "  --data-char UUID    boot module characteristics to flash\n"
+    << "  --status-char UUID  through (required with --flash)\n"
+    << "  --attempts N        tries per device when flashing\n"
+    << "  --jobs N            devices worked on at once in batch or flash\n"
+    << "                      mode\n"
+    << "  --output FILE       batch or flash results (JSON lines) to FILE\n"
+    << "                      instead of stdout\n"
+    << "  --trace FILE        record a Chrome trace (chrome://tracing,\n"
+    << "                      ui.perfetto.dev), written on exit or from\n"
+    << "                      the menu\n"
+    << "  --trace-events N    spans to preallocate room for\n"
+    << "Batch commands:\n"
+    << "  scan [SECONDS [UUID...]]\n"
+    << "  connect ADDRESS [SECONDS]\n"
+    << "  disconnect ADDRESS\n"
+    << "  read ADDRESS CHAR\n"
+    << "  write ADDRESS CHAR HEX [request|command]\n"
+    << "  subscribe ADDRESS CHAR\n"
+    << "  unsubscribe ADDRESS CHAR\n"
+    << "  wait SECONDS\n"
+    << "CHAR is a characteristic UUID or object path." << std::endl;
+}
 
-int main(int /*argc*/, char* /*argv*/[])
+int runBatch(const std::string& script, size_t jobs, const std::string& output)
 {
+  using namespace boot_module;
+
+  std::vector<BatchCommand> commands;
+  std::string               error;
+  if (!parseBatchScript(script, commands, error))
+  {
+    std::cerr << "Invalid script: " << error << std::endl;
+    return 2;
+  }
+
+  std::ofstream file;
+  if (!output.empty())
+  {
+    file.open(output);
+    if (!file)
+    {
+      std::cerr << "Cannot open " << output << std::endl;
+      return 2;
+    }
+  }
+
+  // Results keep stdout to themselves; the manager's progress messages go
+  // to stderr
+  std::ostream    results(output.empty() ? std::cout.rdbuf() : file.rdbuf());
+  std::streambuf* previous = std::cout.rdbuf(std::cerr.rdbuf());
+
+  bool ok = false;
+  try
+  {
+    BluetoothManager manager;
+    manager.startEventLoop();
+    ok = BatchRunner(manager, results, jobs).run(commands);
+    manager.stopEventLoop();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Fatal error: " << e.what() << std::endl;
+  }
+
+  std::cout.rdbuf(previous);
+  return ok ? 0 : 1;
+}
+
+int runFlash(const std::string&               manifest,
+             const boot_module::FleetOptions& options,
+             const std::string&               output)
+{
+  using namespace boot_module;
+
+  std::vector<FleetJob> jobs;
+  std::string           error;
+  if (!parseFleetManifest(manifest, jobs, error))
+  {
+    std::cerr << "Invalid manifest: " << error << std::endl;
+    return 2;
+  }
+
+  std::ofstream file;
+  if (!output.empty())
+  {
+    file.open(output);
+    if (!file)
+    {
+      std::cerr << "Cannot open " << output << std::endl;
+      return 2;
+    }
+  }
+
+  // As in batch mode, stdout carries only results
+  std::ostream    results(output.empty() ? std::cout.rdbuf() : file.rdbuf());
+  std::streambuf* previous = std::cout.rdbuf(std::cerr.rdbuf());
+
+  bool ok = false;
+  try
+  {
+    BluetoothManager manager;
+    manager.startEventLoop();
+    // Devices are reported as they finish, in whatever order that is
+    std::mutex   outputMutex;
+    FleetFlasher flasher(manager, options);
+    FleetReport  report =
+      flasher.run(jobs, [&results, &outputMutex](const FleetDeviceResult& r) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        results << toJson(r) << std::endl;
+      });
+    manager.stopEventLoop();
+
+    results << toJson(report) << std::endl;
+    report.writeText(std::cerr);
+    ok = report.failed == 0;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Fatal error: " << e.what() << std::endl;
+  }
+
+  std::cout.rdbuf(previous);
+  return ok ? 0 : 1;
+}
+
+bool readInput(const std::string& path, std::string& text)
+{
+  std::ifstream file;
+  if (path != "-")
+  {
+    file.open(path);
+    if (!file)
+    {
+      std::cerr << "Cannot open " << path << std::endl;
+      return false;
+    }
+  }
+  std::istream& in = path == "-" ? std::cin : file;
+  text.assign(std::istreambuf_iterator<char>(in),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::string script;
+  bool        batch = false;
+  std::string manifest;
+  bool        flash = false;
+  // 0 until given, for each mode's own default
+  size_t      jobs = 0;
+  boot_module::FleetOptions fleet;
+  std::string output;
+  std::string tracePath;
+  size_t      traceEvents = boot_module::Tracer::DEFAULT_CAPACITY;
+
+  try
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg == "--help" || i + 1 >= argc)
+      {
+        printUsage(argv[0]);
+        return arg == "--help" ? 0 : 2;
+      }
+
+      std::string value = argv[++i];
+      if (arg == "--batch")
+      {
+        if (!readInput(value, script))
+        {
+          return 2;
+        }
+        batch = true;
+      }
+      else if (arg == "--exec")
+      {
+        script = value;
+        batch  = true;
+      }
+      else if (arg == "--flash")
+      {
+        if (!readInput(value, manifest))
+        {
+          return 2;
+        }
+        flash = true;
+      }
+      else if (arg == "--data-char" || arg == "--status-char")
+      {
+        auto& uuid = arg == "--data-char" ? fleet.dataCharacteristic
+                                          : fleet.statusCharacteristic;
+        if (!boot_module::Uuid::parse(value, uuid))
+        {
+          throw std::invalid_argument(arg + " " + value);
+        }
+      }
+      else if (arg == "--attempts")
+      {
+        fleet.attempts = std::stoull(value);
+      }
+      else if (arg == "--jobs")
+      {
+        jobs = std::stoull(value);
+      }
+      else if (arg == "--output")
+      {
+        output = value;
+      }
+      else if (arg == "--trace")
+      {
+        tracePath = value;
+      }
+      else if (arg == "--trace-events")
+      {
+        traceEvents = std::stoull(value);
+      }
+      else
+      {
+        printUsage(argv[0]);
+        return 2;
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (!tracePath.empty())
+  {
+    boot_module::Tracer::instance().start(tracePath, traceEvents);
+  }
+
+  if (flash)
+  {
+    if (fleet.dataCharacteristic == boot_module::Uuid() ||
+        fleet.statusCharacteristic == boot_module::Uuid())
+    {
+      std::cerr << "--flash needs --data-char and --status-char" << std::endl;
+      return 2;
+    }
+    fleet.parallelism =
+      jobs ? jobs : boot_module::FleetOptions::DEFAULT_PARALLELISM;
+    return runFlash(manifest, fleet, output);
+  }
+
+  if (batch)
+  {
+    return runBatch(
+      script, jobs ? jobs : boot_module::BatchRunner::DEFAULT_JOBS, output);
+  }
+
   try
   {
     boot_module::BluetoothCLI cli;
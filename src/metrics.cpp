@@ -0,0 +1,290 @@
+#include "boot_module/metrics.hpp"
+
+#include <algorithm>
+
+namespace boot_module
+{
+namespace
+{
+std::atomic<uint64_t> g_nextMetricsId{1};
+
+// The calling thread's cells in the Metrics instance it last recorded into
+struct ThreadCache
+{
+  uint64_t owner = 0;
+  void*    cells = nullptr;
+};
+thread_local ThreadCache t_cache;
+
+// Single writer per cell: a plain load and store is enough and avoids the
+// locked read-modify-write of fetch_add
+void bump(std::atomic<uint64_t>& cell, uint64_t amount)
+{
+  cell.store(cell.load(std::memory_order_relaxed) + amount,
+             std::memory_order_relaxed);
+}
+}  // namespace
+
+const char* toString(Operation operation)
+{
+  switch (operation)
+  {
+    case Operation::GetManagedObjects:
+      return "GetManagedObjects";
+    case Operation::GetAll:
+      return "GetAll";
+    case Operation::Set:
+      return "Set";
+    case Operation::Connect:
+      return "Connect";
+    case Operation::Disconnect:
+      return "Disconnect";
+    case Operation::ReadValue:
+      return "ReadValue";
+    case Operation::WriteValue:
+      return "WriteValue";
+    case Operation::StartNotify:
+      return "StartNotify";
+    case Operation::StopNotify:
+      return "StopNotify";
+    case Operation::AcquireNotify:
+      return "AcquireNotify";
+    case Operation::AcquireWrite:
+      return "AcquireWrite";
+    case Operation::Count:
+      break;
+  }
+  return "unknown";
+}
+
+size_t LatencyBuckets::indexOf(uint64_t ns)
+{
+  if (ns < SUB_BUCKETS)
+  {
+    return static_cast<size_t>(ns);
+  }
+  int    msb   = 63 - __builtin_clzll(ns);
+  int    shift = msb - SUB_BUCKET_BITS;
+  size_t sub   = static_cast<size_t>(ns >> shift) & (SUB_BUCKETS - 1);
+  return std::min((static_cast<size_t>(shift) + 1) * SUB_BUCKETS + sub,
+                  COUNT - 1);
+}
+
+uint64_t LatencyBuckets::lowerBound(size_t index)
+{
+  if (index < SUB_BUCKETS)
+  {
+    return index;
+  }
+  size_t shift = index / SUB_BUCKETS - 1;
+  return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+void recordReply(Metrics&  metrics,
+                 Operation operation,
+                 uint64_t  startNs,
+                 bool      ok)
+{
+  uint64_t end = Metrics::now();
+  metrics.record(operation, end - startNs, ok);
+  if (Tracer::instance().enabled())
+  {
+    Tracer::instance().async(
+      toString(operation), "dbus", startNs, end, ok ? "" : "failed");
+  }
+}
+
+uint64_t OperationStats::percentileNs(double percentile) const
+{
+  if (count == 0 || buckets.empty())
+  {
+    return 0;
+  }
+
+  auto     rank = static_cast<uint64_t>(percentile / 100.0 * count);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); i++)
+  {
+    seen += buckets[i];
+    if (seen > rank)
+    {
+      return LatencyBuckets::lowerBound(i);
+    }
+  }
+  return maxNs;
+}
+
+struct Metrics::ThreadLeases
+{
+  struct Lease
+  {
+    uint64_t                owner;
+    std::weak_ptr<CellPool> pool;
+    ThreadCells*            cells;
+  };
+
+  std::vector<Lease> leases;
+
+  ~ThreadLeases()
+  {
+    for (const auto& lease : leases)
+    {
+      if (auto pool = lease.pool.lock())
+      {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->free.push_back(lease.cells);
+      }
+    }
+  }
+};
+
+thread_local Metrics::ThreadLeases Metrics::t_leases;
+
+Metrics::Metrics()
+  : m_id(g_nextMetricsId++), m_cells(std::make_shared<CellPool>())
+{
+}
+
+Metrics::~Metrics() = default;
+
+void Metrics::record(Operation operation, uint64_t elapsedNs, bool ok)
+{
+  auto& cells = threadCells().operations[static_cast<size_t>(operation)];
+
+  bump(cells.count, 1);
+  if (!ok)
+  {
+    bump(cells.errors, 1);
+  }
+  bump(cells.sumNs, elapsedNs);
+  bump(cells.buckets[LatencyBuckets::indexOf(elapsedNs)], 1);
+  if (elapsedNs < cells.minNs.load(std::memory_order_relaxed))
+  {
+    cells.minNs.store(elapsedNs, std::memory_order_relaxed);
+  }
+  if (elapsedNs > cells.maxNs.load(std::memory_order_relaxed))
+  {
+    cells.maxNs.store(elapsedNs, std::memory_order_relaxed);
+  }
+}
+
+std::shared_ptr<NotificationCounters> Metrics::notifications(
+  GattHandle         characteristic,
+  const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& subscription = m_subscriptions[characteristic];
+  if (!subscription.counters)
+  {
+    subscription.path     = path;
+    subscription.counters = std::make_shared<NotificationCounters>();
+  }
+  return subscription.counters;
+}
+
+MetricsSnapshot Metrics::snapshot() const
+{
+  MetricsSnapshot snapshot;
+  for (auto& stats : snapshot.operations)
+  {
+    stats.buckets.assign(LatencyBuckets::COUNT, 0);
+    stats.minNs = UINT64_MAX;
+  }
+
+  std::unique_lock<std::mutex> cellsLock(m_cells->mutex);
+  for (const auto& thread : m_cells->cells)
+  {
+    for (size_t op = 0; op < OPERATION_COUNT; op++)
+    {
+      const auto& cells = thread->operations[op];
+      auto&       stats = snapshot.operations[op];
+      stats.count += cells.count.load(std::memory_order_relaxed);
+      stats.errors += cells.errors.load(std::memory_order_relaxed);
+      stats.sumNs += cells.sumNs.load(std::memory_order_relaxed);
+      stats.minNs =
+        std::min(stats.minNs, cells.minNs.load(std::memory_order_relaxed));
+      stats.maxNs =
+        std::max(stats.maxNs, cells.maxNs.load(std::memory_order_relaxed));
+      for (size_t i = 0; i < LatencyBuckets::COUNT; i++)
+      {
+        stats.buckets[i] += cells.buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  cellsLock.unlock();
+  for (auto& stats : snapshot.operations)
+  {
+    if (stats.count == 0)
+    {
+      stats.minNs = 0;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const auto& [handle, subscription] : m_subscriptions)
+  {
+    snapshot.characteristics.push_back(
+      {subscription.path,
+       subscription.counters->notifications.load(std::memory_order_relaxed),
+       subscription.counters->bytes.load(std::memory_order_relaxed)});
+  }
+  std::sort(snapshot.characteristics.begin(),
+            snapshot.characteristics.end(),
+            [](const auto& a, const auto& b) { return a.path < b.path; });
+  return snapshot;
+}
+
+Metrics::ThreadCells& Metrics::threadCells()
+{
+  if (t_cache.owner == m_id)
+  {
+    return *static_cast<ThreadCells*>(t_cache.cells);
+  }
+  return registerThread();
+}
+
+Metrics::ThreadCells& Metrics::registerThread()
+{
+  // A thread alternating between instances lands here on every switch, so
+  // look for its existing cells before taking more
+  auto&        leases = t_leases.leases;
+  ThreadCells* cells  = nullptr;
+  for (const auto& lease : leases)
+  {
+    if (lease.owner == m_id)
+    {
+      cells = lease.cells;
+      break;
+    }
+  }
+  if (!cells)
+  {
+    // Leases in instances since destroyed have nothing left to return
+    leases.erase(std::remove_if(leases.begin(),
+                                leases.end(),
+                                [](const auto& lease) {
+                                  return lease.pool.expired();
+                                }),
+                 leases.end());
+
+    std::lock_guard<std::mutex> lock(m_cells->mutex);
+    if (!m_cells->free.empty())
+    {
+      // Keeps the exited thread's counts; the pool's lock orders its last
+      // stores before our first
+      cells = m_cells->free.back();
+      m_cells->free.pop_back();
+    }
+    else
+    {
+      m_cells->cells.push_back(std::make_unique<ThreadCells>());
+      cells = m_cells->cells.back().get();
+    }
+    leases.push_back({m_id, m_cells, cells});
+  }
+
+  t_cache.owner = m_id;
+  t_cache.cells = cells;
+  return *cells;
+}
+}  // namespace boot_module
@@ -0,0 +1,116 @@
+#include "boot_module/notification_pool.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace boot_module
+{
+struct PooledBuffer::Shared
+{
+  size_t                                             capacity;
+  size_t                                             limit;
+  mutable std::mutex                                 mutex;
+  // Reserved to limit entries up front so returning a buffer never grows it
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> free;
+  size_t                                             buffers  = 0;
+  uint64_t                                           acquired = 0;
+  uint64_t                                           misses   = 0;
+
+  void put(std::vector<uint8_t>* buffer)
+  {
+    std::unique_ptr<std::vector<uint8_t>> owned(buffer);
+    std::lock_guard<std::mutex>           lock(mutex);
+    if (free.size() < limit)
+    {
+      free.push_back(std::move(owned));
+      return;
+    }
+    // An extra from a miss; let it go
+    buffers--;
+  }
+};
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+  : m_shared(std::move(other.m_shared)), m_buffer(other.m_buffer)
+{
+  other.m_buffer = nullptr;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    m_shared       = std::move(other.m_shared);
+    m_buffer       = other.m_buffer;
+    other.m_buffer = nullptr;
+  }
+  return *this;
+}
+
+void PooledBuffer::release()
+{
+  if (m_buffer)
+  {
+    m_shared->put(m_buffer);
+    m_buffer = nullptr;
+    m_shared.reset();
+  }
+}
+
+BufferPool::BufferPool(size_t buffers, size_t capacity)
+  : m_shared(std::make_shared<PooledBuffer::Shared>())
+{
+  m_shared->capacity = capacity;
+  m_shared->limit    = std::max<size_t>(buffers, 1);
+  m_shared->free.reserve(m_shared->limit);
+  for (size_t i = 0; i < m_shared->limit; i++)
+  {
+    auto buffer = std::make_unique<std::vector<uint8_t>>();
+    buffer->reserve(capacity);
+    m_shared->free.push_back(std::move(buffer));
+  }
+  m_shared->buffers = m_shared->limit;
+}
+
+PooledBuffer BufferPool::acquire()
+{
+  std::unique_ptr<std::vector<uint8_t>> buffer;
+  {
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->acquired++;
+    if (!m_shared->free.empty())
+    {
+      buffer = std::move(m_shared->free.back());
+      m_shared->free.pop_back();
+    }
+    else
+    {
+      m_shared->misses++;
+      m_shared->buffers++;
+    }
+  }
+
+  if (buffer)
+  {
+    buffer->clear();
+  }
+  else
+  {
+    buffer = std::make_unique<std::vector<uint8_t>>();
+    buffer->reserve(m_shared->capacity);
+  }
+  return PooledBuffer(m_shared, buffer.release());
+}
+
+PoolStats BufferPool::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_shared->mutex);
+  PoolStats                   stats;
+  stats.buffers   = m_shared->buffers;
+  stats.available = m_shared->free.size();
+  stats.acquired  = m_shared->acquired;
+  stats.misses    = m_shared->misses;
+  return stats;
+}
+}  // namespace boot_module
@@ -0,0 +1,144 @@
+#include "boot_module/notification_replay.hpp"
+
+#include <algorithm>
+
+#include "boot_module/trace.hpp"
+
+namespace boot_module
+{
+NotificationReplay::NotificationReplay(std::unique_ptr<CaptureReader> reader,
+                                       const ReplayOptions&           options)
+  : m_reader(std::move(reader)), m_options(options)
+{
+}
+
+void NotificationReplay::subscribe(const std::string& characteristicPath,
+                                   Callback           callback)
+{
+  m_callbacks[characteristicPath] = std::move(callback);
+}
+
+void NotificationReplay::subscribeAll(Callback callback)
+{
+  m_fallback = std::move(callback);
+}
+
+ReplayStats NotificationReplay::run()
+{
+  TraceSpan   span("replay", "replay");
+  ReplayStats stats;
+  if (!m_reader)
+  {
+    return stats;
+  }
+
+  std::vector<uint8_t> value;
+  CaptureRecord        record;
+  const auto           start = Clock::now();
+
+  for (size_t pass = 0; m_options.passes == 0 || pass < m_options.passes;
+       pass++)
+  {
+    m_reader->rewind();
+    // Each pass is scheduled from its own first record, so the gap between
+    // the end of the recording and its start is not replayed
+    const auto passStart = Clock::now();
+    uint64_t   origin    = 0;
+    bool       any       = false;
+
+    while (!m_stopping && m_reader->next(record))
+    {
+      if (!any)
+      {
+        origin = record.timestampNs;
+        any    = true;
+      }
+
+      const Callback* callback = route(record.characteristic);
+      if (!callback)
+      {
+        stats.skipped++;
+        continue;
+      }
+
+      if (m_options.speed > 0)
+      {
+        // A record older than the first one is due at once rather than
+        // wrapping to a wait of centuries
+        uint64_t since =
+          record.timestampNs > origin ? record.timestampNs - origin : 0;
+        auto offset = std::chrono::duration<double, std::nano>(
+          since / m_options.speed);
+        auto due =
+          passStart + std::chrono::duration_cast<Clock::duration>(offset);
+        if (!waitUntil(due))
+        {
+          break;
+        }
+        stats.maxLag = std::max(
+          stats.maxLag,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - due));
+      }
+
+      // No allocation once the buffer has grown to the largest payload
+      value.assign(record.data, record.data + record.size);
+      (*callback)(value);
+      stats.notifications++;
+      stats.bytes += record.size;
+    }
+
+    // An empty recording would otherwise spin forever with passes = 0
+    if (m_stopping || !any)
+    {
+      break;
+    }
+  }
+
+  stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    Clock::now() - start);
+  return stats;
+}
+
+void NotificationReplay::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_stopMutex);
+    m_stopping = true;
+  }
+  m_stopCondition.notify_all();
+}
+
+const NotificationReplay::Callback* NotificationReplay::route(
+  uint32_t characteristic)
+{
+  if (characteristic >= m_routes.size())
+  {
+    m_routes.resize(characteristic + 1, nullptr);
+    m_resolved.resize(characteristic + 1, false);
+  }
+  if (!m_resolved[characteristic])
+  {
+    // The log names a characteristic ahead of its first notification, so
+    // the path is known by now
+    auto it = m_callbacks.find(m_reader->characteristicPath(characteristic));
+    const Callback* callback =
+      it != m_callbacks.end() ? &it->second : &m_fallback;
+    m_routes[characteristic]   = *callback ? callback : nullptr;
+    m_resolved[characteristic] = true;
+  }
+  return m_routes[characteristic];
+}
+
+bool NotificationReplay::waitUntil(Clock::time_point due)
+{
+  if (Clock::now() >= due)
+  {
+    return !m_stopping;
+  }
+  std::unique_lock<std::mutex> lock(m_stopMutex);
+  return !m_stopCondition.wait_until(lock, due, [this]() {
+    return m_stopping.load();
+  });
+}
+}  // namespace boot_module
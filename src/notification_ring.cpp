@@ -0,0 +1,242 @@
+#include "boot_module/notification_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace boot_module
+{
+namespace
+{
+// Upper bound on any single sleep, in case a wakeup is missed
+constexpr std::chrono::milliseconds MAX_WAIT{10};
+constexpr std::chrono::milliseconds CONSUMER_IDLE_WAIT{100};
+
+size_t roundUpToPowerOfTwo(size_t value)
+{
+  size_t result = 2;
+  while (result < value)
+  {
+    result <<= 1;
+  }
+  return result;
+}
+
+uint64_t steadyNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+}  // namespace
+
+NotificationRing::NotificationRing(const RingOptions& options)
+  : m_capacity(roundUpToPowerOfTwo(options.slots)),
+    m_mask(m_capacity - 1),
+    m_slotSize(std::max<size_t>(options.slotSize, 1)),
+    m_policy(options.policy),
+    m_headers(m_capacity),
+    m_data(m_capacity * m_slotSize)
+{
+}
+
+bool NotificationRing::push(const uint8_t* data,
+                            size_t         size,
+                            uint64_t       timestampNs)
+{
+  if (m_closed)
+  {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint64_t tail    = m_tail.load(std::memory_order_relaxed);
+  uint64_t head    = m_head.load(std::memory_order_acquire);
+  bool     blocked = false;
+
+  while (tail - head >= m_capacity)
+  {
+    switch (m_policy)
+    {
+      case OverflowPolicy::DropNewest:
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+
+      case OverflowPolicy::DropOldest:
+        // Losing the race means the consumer just freed a slot
+        if (m_head.compare_exchange_weak(
+              head, head + 1, std::memory_order_acq_rel))
+        {
+          m_dropped.fetch_add(1, std::memory_order_relaxed);
+          head++;
+        }
+        break;
+
+      case OverflowPolicy::Block:
+      {
+        if (!blocked)
+        {
+          blocked = true;
+          m_blocked.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_producerWaiting = true;
+        {
+          std::unique_lock<std::mutex> lock(m_wakeMutex);
+          m_wake.wait_for(lock, MAX_WAIT, [this, tail]() {
+            return m_closed || tail - m_head.load() < m_capacity;
+          });
+        }
+        m_producerWaiting = false;
+
+        if (m_closed)
+        {
+          m_dropped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        head = m_head.load(std::memory_order_acquire);
+        break;
+      }
+    }
+  }
+
+  size_t slot   = tail & m_mask;
+  size_t stored = std::min(size, m_slotSize);
+  if (stored < size)
+  {
+    m_truncated.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::memcpy(&m_data[slot * m_slotSize], data, stored);
+  m_headers[slot] = {timestampNs, static_cast<uint32_t>(stored)};
+  m_tail.store(tail + 1, std::memory_order_release);
+
+  m_pushed.fetch_add(1, std::memory_order_relaxed);
+  size_t used = static_cast<size_t>(tail + 1 - head);
+  if (used > m_highWater.load(std::memory_order_relaxed))
+  {
+    // Only the producer writes the high-water mark
+    m_highWater.store(used, std::memory_order_relaxed);
+  }
+
+  wake(m_consumerWaiting);
+  return true;
+}
+
+bool NotificationRing::pop(uint8_t* buffer, NotificationView& view)
+{
+  while (true)
+  {
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == m_tail.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+
+    // Under DropOldest the producer may recycle this slot while we copy it.
+    // The copy is only used if the head did not move underneath us.
+    size_t     slot   = head & m_mask;
+    SlotHeader header = m_headers[slot];
+    size_t     size   = std::min<size_t>(header.size, m_slotSize);
+    std::memcpy(buffer, &m_data[slot * m_slotSize], size);
+
+    if (m_head.compare_exchange_strong(
+          head, head + 1, std::memory_order_acq_rel))
+    {
+      m_delivered.fetch_add(1, std::memory_order_relaxed);
+      view = {buffer, size, header.timestampNs};
+      wake(m_producerWaiting);
+      return true;
+    }
+  }
+}
+
+void NotificationRing::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_closed = true;
+  }
+  m_wake.notify_all();
+}
+
+void NotificationRing::waitForData(std::chrono::milliseconds timeout)
+{
+  m_consumerWaiting = true;
+  {
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait_for(lock, timeout, [this]() {
+      return m_closed || m_head.load() != m_tail.load();
+    });
+  }
+  m_consumerWaiting = false;
+}
+
+RingStats NotificationRing::stats() const
+{
+  RingStats stats;
+  stats.pushed    = m_pushed.load(std::memory_order_relaxed);
+  stats.delivered = m_delivered.load(std::memory_order_relaxed);
+  stats.dropped   = m_dropped.load(std::memory_order_relaxed);
+  stats.truncated = m_truncated.load(std::memory_order_relaxed);
+  stats.blocked   = m_blocked.load(std::memory_order_relaxed);
+  stats.highWater = m_highWater.load(std::memory_order_relaxed);
+  stats.capacity  = m_capacity;
+  return stats;
+}
+
+void NotificationRing::wake(std::atomic<bool>& waiting)
+{
+  // Pairs with the waiter setting its flag before re-checking the indices
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_relaxed))
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_all();
+  }
+}
+
+RingDispatcher::RingDispatcher(const RingOptions& options, Consumer consumer)
+  : m_ring(options), m_consumer(std::move(consumer))
+{
+  m_thread = std::thread(&RingDispatcher::run, this);
+}
+
+RingDispatcher::~RingDispatcher()
+{
+  m_running = false;
+  m_ring.close();
+  m_thread.join();
+}
+
+void RingDispatcher::push(const std::vector<uint8_t>& value)
+{
+  m_ring.push(value.data(), value.size(), steadyNowNs());
+}
+
+void RingDispatcher::run()
+{
+  // The only buffer the consumer side ever uses
+  std::vector<uint8_t> buffer(m_ring.slotSize());
+  NotificationView     view;
+
+  while (true)
+  {
+    while (m_ring.pop(buffer.data(), view))
+    {
+      m_consumer(view);
+    }
+    if (!m_running)
+    {
+      break;
+    }
+    m_ring.waitForData(CONSUMER_IDLE_WAIT);
+  }
+
+  // Anything queued just before close()
+  while (m_ring.pop(buffer.data(), view))
+  {
+    m_consumer(view);
+  }
+}
+}  // namespace boot_module
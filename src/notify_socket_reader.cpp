@@ -0,0 +1,270 @@
+#include "boot_module/notify_socket_reader.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+#include "boot_module/characteristic_writer.hpp"
+
+namespace boot_module
+{
+namespace
+{
+constexpr uint64_t WAKE_ID    = 0;
+constexpr int      MAX_EVENTS = 16;
+}  // namespace
+
+NotifySocketReader::NotifySocketReader()
+{
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeFd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_epollFd < 0 || m_wakeFd < 0)
+  {
+    int error = errno;
+    if (m_epollFd >= 0)
+    {
+      ::close(m_epollFd);
+    }
+    if (m_wakeFd >= 0)
+    {
+      ::close(m_wakeFd);
+    }
+    throw std::system_error(
+      error, std::generic_category(), "Failed to set up notify reader");
+  }
+
+  epoll_event event{};
+  event.events   = EPOLLIN;
+  event.data.u64 = WAKE_ID;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+  m_thread = std::thread(&NotifySocketReader::run, this);
+}
+
+NotifySocketReader::~NotifySocketReader()
+{
+  m_running        = false;
+  uint64_t one     = 1;
+  ssize_t  written = write(m_wakeFd, &one, sizeof(one));
+  (void)written;
+  m_thread.join();
+
+  for (auto& [id, subscription] : m_subscriptions)
+  {
+    ::close(subscription->fd);
+  }
+  ::close(m_wakeFd);
+  ::close(m_epollFd);
+}
+
+bool NotifySocketReader::add(int            fd,
+                             uint16_t       mtu,
+                             Callback       callback,
+                             ClosedCallback onClosed)
+{
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  auto subscription      = std::make_shared<Subscription>();
+  subscription->fd       = fd;
+  subscription->callback = std::move(callback);
+  subscription->onClosed = std::move(onClosed);
+  // BlueZ may report no MTU; every link carries at least the default one
+  subscription->capacity = std::max(mtu, DEFAULT_ATT_MTU);
+  subscription->buffer.resize(subscription->capacity);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  subscription->id = m_nextId++;
+
+  epoll_event event{};
+  event.events   = EPOLLIN | EPOLLRDHUP;
+  event.data.u64 = subscription->id;
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  m_idByFd[fd]                      = subscription->id;
+  m_subscriptions[subscription->id] = std::move(subscription);
+  return true;
+}
+
+void NotifySocketReader::remove(int fd)
+{
+  std::shared_ptr<Subscription> subscription;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        it = m_idByFd.find(fd);
+    if (it == m_idByFd.end())
+    {
+      return;
+    }
+    subscription = m_subscriptions[it->second];
+  }
+
+  if (std::this_thread::get_id() == m_thread.get_id())
+  {
+    // Called from a callback; the dispatch lock is already ours
+    close(*subscription);
+    return;
+  }
+
+  // Wait for any batch in flight so the callback is guaranteed idle
+  std::lock_guard<std::mutex> dispatch(m_dispatchMutex);
+  close(*subscription);
+}
+
+void NotifySocketReader::close(Subscription& subscription)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!subscription.open)
+  {
+    return;
+  }
+
+  subscription.open = false;
+  epoll_ctl(m_epollFd, EPOLL_CTL_DEL, subscription.fd, nullptr);
+  ::close(subscription.fd);
+  m_idByFd.erase(subscription.fd);
+  m_subscriptions.erase(subscription.id);
+}
+
+void NotifySocketReader::run()
+{
+  epoll_event events[MAX_EVENTS];
+
+  while (m_running)
+  {
+    int count = epoll_wait(m_epollFd, events, MAX_EVENTS, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      std::cerr << "Notify reader stopped: " << std::strerror(errno)
+                << std::endl;
+      return;
+    }
+
+    std::lock_guard<std::mutex> dispatch(m_dispatchMutex);
+    for (int i = 0; i < count; i++)
+    {
+      if (events[i].data.u64 == WAKE_ID)
+      {
+        uint64_t value;
+        ssize_t  bytes = read(m_wakeFd, &value, sizeof(value));
+        (void)bytes;
+        continue;
+      }
+
+      std::shared_ptr<Subscription> subscription;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_subscriptions.find(events[i].data.u64);
+        if (it == m_subscriptions.end())
+        {
+          continue;
+        }
+        subscription = it->second;
+      }
+
+      // Closure is only known from these: on a SOCK_SEQPACKET socket a zero
+      // length read is also what an empty notification looks like
+      bool hungUp = events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP);
+      bool alive  = true;
+      if (events[i].events & EPOLLIN)
+      {
+        alive = drain(*subscription, hungUp);
+      }
+      if (hungUp)
+      {
+        alive = false;
+      }
+
+      if (!alive && subscription->open)
+      {
+        int fd = subscription->fd;
+        close(*subscription);
+        if (subscription->onClosed)
+        {
+          subscription->onClosed(fd);
+        }
+      }
+    }
+  }
+}
+
+bool NotifySocketReader::drain(Subscription& subscription, bool hungUp)
+{
+  // After a hangup recv() returns 0 both for an empty notification still
+  // queued and at end of stream. With SO_PASSCRED every datagram comes with
+  // credentials and the end of stream without; it is only turned on then,
+  // which keeps the control message off the hot path.
+  int  enable = 1;
+  bool tagged = hungUp && setsockopt(subscription.fd,
+                                     SOL_SOCKET,
+                                     SO_PASSCRED,
+                                     &enable,
+                                     sizeof(enable)) == 0;
+  char control[CMSG_SPACE(sizeof(ucred))];
+
+  // Read every queued datagram; the buffer never grows past its capacity
+  while (subscription.open)
+  {
+    subscription.buffer.resize(subscription.capacity);
+    iovec  part = {subscription.buffer.data(), subscription.capacity};
+    msghdr message{};
+    message.msg_iov    = &part;
+    message.msg_iovlen = 1;
+    if (tagged)
+    {
+      message.msg_control    = control;
+      message.msg_controllen = sizeof(control);
+    }
+    ssize_t bytes = recvmsg(subscription.fd, &message, MSG_DONTWAIT);
+    if (bytes == 0 && hungUp && (!tagged || message.msg_controllen == 0))
+    {
+      // End of stream: everything the peer sent has been delivered
+      return false;
+    }
+    if (bytes >= 0)
+    {
+      subscription.buffer.resize(static_cast<size_t>(bytes));
+      if (subscription.callback)
+      {
+        subscription.callback(subscription.buffer);
+      }
+      if (bytes == 0 && !hungUp)
+      {
+        // Stop here rather than spin if the peer closed since the wakeup:
+        // epoll is level-triggered, so anything still queued wakes us again,
+        // this time with the hangup reported
+        return true;
+      }
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      return true;
+    }
+    else if (errno != EINTR)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace boot_module
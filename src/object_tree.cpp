@@ -0,0 +1,265 @@
+#include "boot_module/object_tree.hpp"
+
+#include <iostream>
+#include <optional>
+
+#include "boot_module/bluez_constants.hpp"
+#include "boot_module/metrics.hpp"
+#include "boot_module/trace.hpp"
+
+namespace boot_module
+{
+ObjectTree::ObjectTree(sdbus::IConnection& connection, Metrics* metrics)
+  : m_connection(connection), m_metrics(metrics)
+{
+  m_rootProxy = sdbus::createProxy(
+    m_connection, sdbus::ServiceName(BLUEZ_SERVICE), sdbus::ObjectPath{"/"});
+
+  // Subscribe before taking the snapshot so no change can slip in between
+  m_rootProxy->uponSignal("InterfacesAdded")
+    .onInterface(OBJECT_MANAGER_INTERFACE)
+    .call([this](const sdbus::ObjectPath&                        path,
+                 const std::map<std::string, PropertyMap>& interfaces) {
+      onInterfacesAdded(path, interfaces);
+    });
+  m_rootProxy->uponSignal("InterfacesRemoved")
+    .onInterface(OBJECT_MANAGER_INTERFACE)
+    .call([this](const sdbus::ObjectPath&        path,
+                 const std::vector<std::string>& interfaces) {
+      onInterfacesRemoved(path, interfaces);
+    });
+
+  // One match rule per tracked interface covers PropertiesChanged for every
+  // BlueZ object, instead of a proxy per object. GattCharacteristic1 is left
+  // out on purpose: its changes are mostly notification Values, which have
+  // their own subscribers, and the properties the mirror serves for it
+  // (UUID, Flags, Service) never change. Its MTU does, and BluetoothManager
+  // follows that with a match of its own.
+  for (const auto& interface :
+       {ADAPTER_INTERFACE, DEVICE_INTERFACE, GATT_SERVICE_INTERFACE})
+  {
+    m_propertiesSlots.push_back(m_connection.addMatch(
+      "type='signal',sender='" + BLUEZ_SERVICE + "',interface='" +
+        PROPERTIES_INTERFACE +
+        "',member='PropertiesChanged',path_namespace='" + BLUEZ_ROOT_PATH +
+        "',arg0='" + interface + "'",
+      [this](sdbus::Message message) { onPropertiesChanged(message); },
+      sdbus::return_slot));
+  }
+
+  refresh();
+}
+
+ObjectTree::~ObjectTree() = default;
+
+void ObjectTree::refresh()
+{
+  std::map<sdbus::ObjectPath, InterfaceMap> objects;
+  {
+    std::optional<OperationTimer> timer;
+    if (m_metrics)
+    {
+      timer.emplace(*m_metrics, Operation::GetManagedObjects);
+    }
+    m_rootProxy->callMethod("GetManagedObjects")
+      .onInterface(OBJECT_MANAGER_INTERFACE)
+      .storeResultsTo(objects);
+    if (timer)
+    {
+      timer->succeeded();
+    }
+  }
+
+  std::map<std::string, InterfaceMap> snapshot;
+  for (auto& [path, interfaces] : objects)
+  {
+    snapshot.emplace_hint(snapshot.end(), path, std::move(interfaces));
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_objects.swap(snapshot);
+}
+
+void ObjectTree::forEach(const std::string& interface,
+                         const std::string& pathPrefix,
+                         const Visitor&     visitor) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_objects.lower_bound(pathPrefix); it != m_objects.end();
+       ++it)
+  {
+    if (it->first.compare(0, pathPrefix.size(), pathPrefix) != 0)
+    {
+      break;
+    }
+
+    auto ifaceIt = it->second.find(interface);
+    if (ifaceIt != it->second.end())
+    {
+      visitor(it->first, ifaceIt->second);
+    }
+  }
+}
+
+bool ObjectTree::getInterface(const std::string& path,
+                              const std::string& interface,
+                              PropertyMap&       props) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto                        objectIt = m_objects.find(path);
+  if (objectIt == m_objects.end())
+  {
+    return false;
+  }
+
+  auto ifaceIt = objectIt->second.find(interface);
+  if (ifaceIt == objectIt->second.end())
+  {
+    return false;
+  }
+
+  props = ifaceIt->second;
+  return true;
+}
+
+bool ObjectTree::hasInterface(const std::string& path,
+                              const std::string& interface) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto                        objectIt = m_objects.find(path);
+  return objectIt != m_objects.end() && objectIt->second.count(interface);
+}
+
+size_t ObjectTree::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_objects.size();
+}
+
+ObjectTree::ListenerId ObjectTree::addListener(Listener listener)
+{
+  std::lock_guard<std::mutex> lock(m_listenerMutex);
+  ListenerId                  id = m_nextListenerId++;
+  m_listeners[id] = std::make_shared<Listener>(std::move(listener));
+  return id;
+}
+
+void ObjectTree::removeListener(ListenerId id)
+{
+  std::lock_guard<std::mutex> lock(m_listenerMutex);
+  m_listeners.erase(id);
+}
+
+void ObjectTree::notify(Change             change,
+                        const std::string& path,
+                        const std::string& interface,
+                        const PropertyMap& props)
+{
+  // Invoke a snapshot so listeners can (un)register without deadlocking
+  std::vector<std::shared_ptr<Listener>> listeners;
+  {
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    listeners.reserve(m_listeners.size());
+    for (const auto& [id, listener] : m_listeners)
+    {
+      listeners.push_back(listener);
+    }
+  }
+
+  for (const auto& listener : listeners)
+  {
+    (*listener)(change, path, interface, props);
+  }
+}
+
+void ObjectTree::onInterfacesAdded(
+  const std::string&                        path,
+  const std::map<std::string, PropertyMap>& added)
+{
+  TraceSpan span("InterfacesAdded", "signal", path);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto&                       interfaces = m_objects[path];
+    for (const auto& [interface, props] : added)
+    {
+      interfaces[interface] = props;
+    }
+  }
+
+  for (const auto& [interface, props] : added)
+  {
+    notify(Change::InterfacesAdded, path, interface, props);
+  }
+}
+
+void ObjectTree::onInterfacesRemoved(const std::string&              path,
+                                     const std::vector<std::string>& removed)
+{
+  TraceSpan span("InterfacesRemoved", "signal", path);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        objectIt = m_objects.find(path);
+    if (objectIt == m_objects.end())
+    {
+      return;
+    }
+
+    for (const auto& interface : removed)
+    {
+      objectIt->second.erase(interface);
+    }
+    if (objectIt->second.empty())
+    {
+      m_objects.erase(objectIt);
+    }
+  }
+
+  const PropertyMap none;
+  for (const auto& interface : removed)
+  {
+    notify(Change::InterfacesRemoved, path, interface, none);
+  }
+}
+
+void ObjectTree::onPropertiesChanged(sdbus::Message& message)
+{
+  std::string              interface;
+  PropertyMap              changed;
+  std::vector<std::string> invalidated;
+
+  try
+  {
+    message >> interface >> changed >> invalidated;
+  }
+  catch (const sdbus::Error& e)
+  {
+    std::cerr << "Error decoding PropertiesChanged: " << e.what() << std::endl;
+    return;
+  }
+
+  std::string path = message.getPath();
+  TraceSpan   span("PropertiesChanged", "signal", path);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        objectIt = m_objects.find(path);
+    if (objectIt == m_objects.end())
+    {
+      // Changes for objects we never saw added are ignored; InterfacesAdded
+      // always precedes them
+      return;
+    }
+
+    auto& props = objectIt->second[interface];
+    for (const auto& [name, value] : changed)
+    {
+      props[name] = value;
+    }
+    for (const auto& name : invalidated)
+    {
+      props.erase(name);
+    }
+  }
+
+  notify(Change::PropertiesChanged, path, interface, changed);
+}
+}  // namespace boot_module
@@ -0,0 +1,70 @@
+#include "boot_module/path_table.hpp"
+
+namespace boot_module
+{
+PathTable::Id PathTable::intern(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_ids.find(path);
+  if (it != m_ids.end())
+  {
+    return it->second;
+  }
+
+  Id id;
+  if (!m_free.empty())
+  {
+    id = m_free.back();
+    m_free.pop_back();
+    m_paths[id] = path;
+  }
+  else
+  {
+    id = static_cast<Id>(m_paths.size());
+    m_paths.push_back(path);
+  }
+  m_ids.emplace(m_paths[id], id);
+  return id;
+}
+
+void PathTable::release(Id id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (id >= m_paths.size())
+  {
+    return;
+  }
+  auto it = m_ids.find(m_paths[id]);
+  // Already released; its empty slot may even match a live "" path
+  if (it == m_ids.end() || it->second != id)
+  {
+    return;
+  }
+  m_ids.erase(it);
+  // Swapped out rather than cleared so the heap buffer is freed too
+  std::string().swap(m_paths[id]);
+  m_free.push_back(id);
+}
+
+PathTable::Id PathTable::find(std::string_view path) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto                        it = m_ids.find(path);
+  return it != m_ids.end() ? it->second : INVALID_ID;
+}
+
+const std::string& PathTable::path(Id id) const
+{
+  // The lock only guards the deque's bookkeeping; the string itself never
+  // moves once added
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_paths[id];
+}
+
+size_t PathTable::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_paths.size() - m_free.size();
+}
+}  // namespace boot_module
@@ -0,0 +1,95 @@
+#include "boot_module/proxy_pool.hpp"
+
+#include "boot_module/bluez_constants.hpp"
+
+namespace boot_module
+{
+ProxyPool::ProxyPool(sdbus::IConnection& connection, size_t capacity)
+  : m_connection(connection), m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+std::shared_ptr<sdbus::IProxy> ProxyPool::get(const std::string& objectPath)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_index.find(objectPath);
+  if (it != m_index.end())
+  {
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+  }
+
+  m_misses++;
+  std::shared_ptr<sdbus::IProxy> proxy =
+    sdbus::createProxy(m_connection,
+                       sdbus::ServiceName(BLUEZ_SERVICE),
+                       sdbus::ObjectPath(objectPath));
+
+  m_lru.emplace_front(objectPath, proxy);
+  m_index[objectPath] = m_lru.begin();
+
+  if (m_lru.size() > m_capacity)
+  {
+    m_index.erase(m_lru.back().first);
+    m_lru.pop_back();
+    m_evictions++;
+  }
+
+  return proxy;
+}
+
+void ProxyPool::evict(const std::string& objectPath)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_index.find(objectPath);
+  if (it != m_index.end())
+  {
+    m_lru.erase(it->second);
+    m_index.erase(it);
+    m_evictions++;
+  }
+}
+
+void ProxyPool::evictSubtree(const std::string& pathPrefix)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (auto it = m_lru.begin(); it != m_lru.end();)
+  {
+    if (it->first.compare(0, pathPrefix.size(), pathPrefix) == 0)
+    {
+      m_index.erase(it->first);
+      it = m_lru.erase(it);
+      m_evictions++;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void ProxyPool::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_evictions += m_lru.size();
+  m_index.clear();
+  m_lru.clear();
+}
+
+ProxyPoolStats ProxyPool::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  ProxyPoolStats stats;
+  stats.hits      = m_hits;
+  stats.misses    = m_misses;
+  stats.evictions = m_evictions;
+  stats.size      = m_lru.size();
+  stats.capacity  = m_capacity;
+  return stats;
+}
+}  // namespace boot_module
@@ -0,0 +1,260 @@
+#include "boot_module/trace.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace boot_module
+{
+namespace
+{
+// Kernel thread id, as shown by top, gdb and perf
+uint32_t currentTid()
+{
+  thread_local const auto tid = static_cast<uint32_t>(syscall(SYS_gettid));
+  return tid;
+}
+
+void writeJsonString(std::ostream& out, const char* text)
+{
+  out << '"';
+  for (const char* c = text; *c; c++)
+  {
+    switch (*c)
+    {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20)
+        {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+          out << escaped;
+        }
+        else
+        {
+          out << *c;
+        }
+    }
+  }
+  out << '"';
+}
+
+// Trace-event timestamps are microseconds
+void writeMicros(std::ostream& out, uint64_t ns)
+{
+  char text[32];
+  std::snprintf(text, sizeof(text), "%llu.%03llu",
+                static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  out << text;
+}
+}  // namespace
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::~Tracer()
+{
+  // The exit flush; threads still recording are long gone by now
+  if (m_events && !m_outputPath.empty() && recorded() > 0)
+  {
+    flush();
+  }
+}
+
+void Tracer::start(const std::string& outputPath, size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  quiesce();
+
+  capacity = std::max<size_t>(capacity, 1);
+  if (capacity != m_capacity)
+  {
+    // Value-initialized, so every page is touched now rather than by the
+    // first spans that land on it
+    m_events   = std::make_unique<Event[]>(capacity);
+    m_capacity = capacity;
+  }
+  m_next       = 0;
+  m_dropped    = 0;
+  m_outputPath = outputPath;
+  m_enabled    = true;
+}
+
+void Tracer::stop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  quiesce();
+}
+
+void Tracer::complete(const char*      name,
+                      const char*      category,
+                      uint64_t         startNs,
+                      uint64_t         endNs,
+                      std::string_view detail)
+{
+  record(Kind::Complete, name, category, startNs, endNs, detail);
+}
+
+void Tracer::async(const char*      name,
+                   const char*      category,
+                   uint64_t         startNs,
+                   uint64_t         endNs,
+                   std::string_view detail)
+{
+  record(Kind::Async, name, category, startNs, endNs, detail);
+}
+
+void Tracer::record(Kind             kind,
+                    const char*      name,
+                    const char*      category,
+                    uint64_t         startNs,
+                    uint64_t         endNs,
+                    std::string_view detail)
+{
+  // Announced before checking m_enabled, so quiesce() either sees this
+  // writer or this writer sees tracing stopped
+  m_writers.fetch_add(1);
+  if (m_enabled.load())
+  {
+    size_t slot = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (slot < m_capacity)
+    {
+      Event& event   = m_events[slot];
+      event.name     = name;
+      event.category = category;
+      event.startNs  = startNs;
+      event.endNs    = std::max(startNs, endNs);
+      event.id       = kind == Kind::Async
+                         ? m_nextAsyncId.fetch_add(1, std::memory_order_relaxed)
+                         : 0;
+      event.tid      = currentTid();
+      event.kind     = kind;
+      size_t size    = std::min(detail.size(), DETAIL_SIZE - 1);
+      std::memcpy(event.detail, detail.data(), size);
+      event.detail[size] = '\0';
+    }
+    else
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  m_writers.fetch_sub(1, std::memory_order_release);
+}
+
+bool Tracer::flush()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_outputPath.empty())
+  {
+    return false;
+  }
+
+  bool          wasEnabled = quiesce();
+  std::ofstream out(m_outputPath);
+  if (out)
+  {
+    writeJsonLocked(out);
+  }
+  m_enabled = wasEnabled;
+
+  if (!out)
+  {
+    std::cerr << "Error writing trace to " << m_outputPath << std::endl;
+    return false;
+  }
+  std::cout << "Trace written to " << m_outputPath << std::endl;
+  return true;
+}
+
+void Tracer::writeJson(std::ostream& out)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  bool                        wasEnabled = quiesce();
+  writeJsonLocked(out);
+  m_enabled = wasEnabled;
+}
+
+size_t Tracer::recorded() const
+{
+  return std::min(m_next.load(std::memory_order_relaxed), m_capacity);
+}
+
+bool Tracer::quiesce()
+{
+  bool wasEnabled = m_enabled.exchange(false);
+  while (m_writers.load(std::memory_order_acquire) != 0)
+  {
+    std::this_thread::yield();
+  }
+  return wasEnabled;
+}
+
+void Tracer::writeJsonLocked(std::ostream& out)
+{
+  const auto pid   = getpid();
+  size_t     count = recorded();
+
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  auto begin = [&](const Event& event, const char* phase, uint64_t ns) {
+    out << (first ? "\n" : ",\n") << "{\"name\":";
+    first = false;
+    writeJsonString(out, event.name);
+    out << ",\"cat\":";
+    writeJsonString(out, event.category);
+    out << ",\"ph\":\"" << phase << "\",\"ts\":";
+    writeMicros(out, ns);
+    out << ",\"pid\":" << pid << ",\"tid\":" << event.tid;
+  };
+  auto args = [&](const Event& event) {
+    if (event.detail[0] != '\0')
+    {
+      out << ",\"args\":{\"detail\":";
+      writeJsonString(out, event.detail);
+      out << "}";
+    }
+  };
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const Event& event = m_events[i];
+    if (event.kind == Kind::Complete)
+    {
+      begin(event, "X", event.startNs);
+      out << ",\"dur\":";
+      writeMicros(out, event.endNs - event.startNs);
+      args(event);
+      out << "}";
+    }
+    else
+    {
+      begin(event, "b", event.startNs);
+      out << ",\"id\":" << event.id;
+      args(event);
+      out << "}";
+      begin(event, "e", event.endNs);
+      out << ",\"id\":" << event.id << "}";
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":"
+      << m_dropped.load(std::memory_order_relaxed) << "}}\n";
+
+  m_next    = 0;
+  m_dropped = 0;
+}
+}  // namespace boot_module
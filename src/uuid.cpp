@@ -0,0 +1,149 @@
+#include "boot_module/uuid.hpp"
+
+namespace boot_module
+{
+namespace
+{
+int hexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Read count hex digits from text starting at offset into value
+bool readHex(std::string_view text,
+             size_t           offset,
+             size_t           count,
+             uint64_t&        value)
+{
+  for (size_t i = offset; i < offset + count; i++)
+  {
+    int digit = hexValue(text[i]);
+    if (digit < 0)
+    {
+      return false;
+    }
+    value = value << 4 | static_cast<uint64_t>(digit);
+  }
+  return true;
+}
+}  // namespace
+
+bool Uuid::parse(std::string_view text, Uuid& uuid)
+{
+  uint64_t high = 0;
+  uint64_t low  = 0;
+
+  switch (text.size())
+  {
+    case 4:
+    case 8:
+      if (!readHex(text, 0, text.size(), high))
+      {
+        return false;
+      }
+      uuid = fromShort(static_cast<uint32_t>(high));
+      return true;
+
+    case 32:
+      if (!readHex(text, 0, 16, high) || !readHex(text, 16, 16, low))
+      {
+        return false;
+      }
+      break;
+
+    case 36:
+      // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+      if (text[8] != '-' || text[13] != '-' || text[18] != '-' ||
+          text[23] != '-')
+      {
+        return false;
+      }
+      if (!readHex(text, 0, 8, high) || !readHex(text, 9, 4, high) ||
+          !readHex(text, 14, 4, high) || !readHex(text, 19, 4, low) ||
+          !readHex(text, 24, 12, low))
+      {
+        return false;
+      }
+      break;
+
+    default:
+      return false;
+  }
+
+  uuid = Uuid(high, low);
+  return true;
+}
+
+std::string Uuid::toString() const
+{
+  static const char DIGITS[] = "0123456789abcdef";
+
+  std::string text(36, '-');
+  size_t      out = 0;
+  for (int i = 0; i < 32; i++)
+  {
+    if (out == 8 || out == 13 || out == 18 || out == 23)
+    {
+      out++;
+    }
+    uint64_t half  = i < 16 ? m_high : m_low;
+    int      shift = 60 - 4 * (i % 16);
+    text[out++]    = DIGITS[(half >> shift) & 0x0f];
+  }
+  return text;
+}
+
+bool Uuid::isShort() const
+{
+  return (m_high & 0xffffffffULL) == BASE_HIGH && m_low == BASE_LOW;
+}
+
+std::vector<Uuid> parseUuids(const std::vector<std::string>& texts)
+{
+  std::vector<Uuid> uuids;
+  uuids.reserve(texts.size());
+  for (const auto& text : texts)
+  {
+    Uuid uuid;
+    if (Uuid::parse(text, uuid))
+    {
+      uuids.push_back(uuid);
+    }
+  }
+  return uuids;
+}
+
+bool matchesAny(const std::vector<Uuid>& uuids,
+                const std::vector<Uuid>& filter)
+{
+  if (filter.empty())
+  {
+    return true;
+  }
+  // Both lists are a handful of entries; a nested loop of integer compares
+  // beats anything that needs hashing or sorting first
+  for (const auto& uuid : uuids)
+  {
+    for (const auto& wanted : filter)
+    {
+      if (uuid == wanted)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+}  // namespace boot_module
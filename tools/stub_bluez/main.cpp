@@ -0,0 +1,335 @@
+// bscm-stub-bluez: serve the stand-in org.bluez on a D-Bus bus until
+// interrupted, for load testing BluetoothManager or the CLI without radios.
+//
+//   dbus-daemon --session --print-address --fork > bus.address
+//   bscm-stub-bluez --address "$(cat bus.address)" --notify 0:0:100:20
+//   DBUS_SYSTEM_BUS_ADDRESS="$(cat bus.address)" bscm-sdbus-cpp
+//
+// With --replay, a capture recorded from real devices is played back as
+// the notifications of one stand-in characteristic, over and over.
+
+#include <signal.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boot_module/bluez_constants.hpp"
+#include "boot_module/notification_replay.hpp"
+#include "stub_bluez/stub_bluez.hpp"
+
+namespace
+{
+using boot_module::stub::BootTargetConfig;
+using boot_module::stub::NotificationGenerator;
+using boot_module::stub::StubBluezConfig;
+
+void printUsage(const char* program)
+{
+  std::cerr
+    << "Usage: " << program << " [options]\n"
+    << "  --address ADDRESS       bus to serve on (default: session bus)\n"
+    << "  --system                serve on the system bus\n"
+    << "  --devices N             devices (default 10)\n"
+    << "  --services N            services per device (default 2)\n"
+    << "  --characteristics N     characteristics per service (default 3)\n"
+    << "  --value-size N          initial characteristic value size\n"
+    << "  --mtu N                 MTU reported by AcquireWrite/Notify\n"
+    << "  --latency-us N          delay before Connect/ReadValue/WriteValue "
+       "reply\n"
+    << "  --notify S:C:HZ:SIZE[:DEVICE]\n"
+    << "                          notify on service S, characteristic C at HZ\n"
+    << "                          per second with SIZE byte payloads, on one\n"
+    << "                          device or all of them; may be repeated\n"
+    << "  --replay PREFIX         notify the capture PREFIX.NNNN.bcap in a\n"
+    << "                          loop, every recorded characteristic merged\n"
+    << "  --replay-target S:C[:DEVICE]\n"
+    << "                          characteristic to replay on (default 0:0,\n"
+    << "                          all devices)\n"
+    << "  --replay-speed X        playback rate, 0 for as fast as possible\n"
+    << "                          (default 1)\n"
+    << "  --boot-target S:DATA:STATUS\n"
+    << "                          emulate a boot module taking firmware\n"
+    << "                          uploads on service S of every device\n"
+    << "  --boot-credits          have it grant credits as well as acks"
+    << std::endl;
+}
+
+// Where --replay sends the recorded notifications
+struct ReplayTarget
+{
+  size_t device         = NotificationGenerator::ALL_DEVICES;
+  size_t service        = 0;
+  size_t characteristic = 0;
+};
+
+size_t parseCount(const std::string& text)
+{
+  size_t used  = 0;
+  auto   value = std::stoull(text, &used);
+  if (used != text.size())
+  {
+    throw std::invalid_argument(text);
+  }
+  return static_cast<size_t>(value);
+}
+
+std::vector<std::string> splitFields(const std::string& spec)
+{
+  std::vector<std::string> fields;
+  size_t                   start = 0;
+  while (true)
+  {
+    size_t colon = spec.find(':', start);
+    fields.push_back(spec.substr(start, colon - start));
+    if (colon == std::string::npos)
+    {
+      return fields;
+    }
+    start = colon + 1;
+  }
+}
+
+NotificationGenerator parseGenerator(const std::string& spec)
+{
+  std::vector<std::string> fields = splitFields(spec);
+  if (fields.size() != 4 && fields.size() != 5)
+  {
+    throw std::invalid_argument(spec);
+  }
+
+  NotificationGenerator generator;
+  generator.service        = parseCount(fields[0]);
+  generator.characteristic = parseCount(fields[1]);
+  generator.rateHz         = std::stod(fields[2]);
+  generator.payloadSize    = parseCount(fields[3]);
+  if (fields.size() == 5)
+  {
+    generator.device = parseCount(fields[4]);
+  }
+  return generator;
+}
+
+BootTargetConfig parseBootTarget(const std::string& spec)
+{
+  std::vector<std::string> fields = splitFields(spec);
+  if (fields.size() != 3)
+  {
+    throw std::invalid_argument(spec);
+  }
+
+  BootTargetConfig target;
+  target.enabled              = true;
+  target.service              = parseCount(fields[0]);
+  target.dataCharacteristic   = parseCount(fields[1]);
+  target.statusCharacteristic = parseCount(fields[2]);
+  return target;
+}
+
+ReplayTarget parseReplayTarget(const std::string& spec)
+{
+  std::vector<std::string> fields = splitFields(spec);
+  if (fields.size() != 2 && fields.size() != 3)
+  {
+    throw std::invalid_argument(spec);
+  }
+
+  ReplayTarget target;
+  target.service        = parseCount(fields[0]);
+  target.characteristic = parseCount(fields[1]);
+  if (fields.size() == 3)
+  {
+    target.device = parseCount(fields[2]);
+  }
+  return target;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  using namespace boot_module;
+
+  StubBluezConfig config;
+  std::string     address;
+  bool            systemBus   = false;
+  bool            bootCredits = false;
+  std::string     replayPrefix;
+  ReplayTarget    replayTarget;
+  ReplayOptions   replayOptions;
+  // Until interrupted
+  replayOptions.passes = 0;
+
+  try
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg == "--system")
+      {
+        systemBus = true;
+        continue;
+      }
+      if (arg == "--boot-credits")
+      {
+        bootCredits = true;
+        continue;
+      }
+      if (arg == "--help" || i + 1 >= argc)
+      {
+        printUsage(argv[0]);
+        return arg == "--help" ? 0 : 2;
+      }
+
+      std::string value = argv[++i];
+      if (arg == "--address")
+      {
+        address = value;
+      }
+      else if (arg == "--devices")
+      {
+        config.devices = parseCount(value);
+      }
+      else if (arg == "--services")
+      {
+        config.servicesPerDevice = parseCount(value);
+      }
+      else if (arg == "--characteristics")
+      {
+        config.characteristicsPerService = parseCount(value);
+      }
+      else if (arg == "--value-size")
+      {
+        config.valueSize = parseCount(value);
+      }
+      else if (arg == "--mtu")
+      {
+        config.mtu = static_cast<uint16_t>(parseCount(value));
+      }
+      else if (arg == "--latency-us")
+      {
+        config.latency = std::chrono::microseconds(parseCount(value));
+      }
+      else if (arg == "--notify")
+      {
+        config.generators.push_back(parseGenerator(value));
+      }
+      else if (arg == "--boot-target")
+      {
+        config.bootTarget = parseBootTarget(value);
+      }
+      else if (arg == "--replay")
+      {
+        replayPrefix = value;
+      }
+      else if (arg == "--replay-target")
+      {
+        replayTarget = parseReplayTarget(value);
+      }
+      else if (arg == "--replay-speed")
+      {
+        replayOptions.speed = std::stod(value);
+      }
+      else
+      {
+        printUsage(argv[0]);
+        return 2;
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  config.bootTarget.credits = bootCredits;
+
+  bool allDevices = replayTarget.device == NotificationGenerator::ALL_DEVICES;
+  if (!replayPrefix.empty() &&
+      ((!allDevices && replayTarget.device >= config.devices) ||
+       replayTarget.service >= config.servicesPerDevice ||
+       replayTarget.characteristic >= config.characteristicsPerService))
+  {
+    std::cerr << "Replay target outside the configured devices" << std::endl;
+    return 2;
+  }
+
+  std::unique_ptr<NotificationReplay> replay;
+  if (!replayPrefix.empty())
+  {
+    auto reader = CaptureReader::open(replayPrefix);
+    if (!reader)
+    {
+      return 2;
+    }
+    replay =
+      std::make_unique<NotificationReplay>(std::move(reader), replayOptions);
+  }
+
+  // Blocked before any thread starts so every thread inherits the mask and
+  // only sigwait below sees them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try
+  {
+    auto connection =
+      !address.empty() ? sdbus::createSessionBusConnectionWithAddress(address)
+      : systemBus      ? sdbus::createSystemBusConnection()
+                       : sdbus::createSessionBusConnection();
+
+    stub::StubBluez bluez(*connection, config);
+    connection->requestName(sdbus::ServiceName{BLUEZ_SERVICE});
+    connection->enterEventLoopAsync();
+
+    std::cout << "Serving " << bluez.objectCount() << " objects ("
+              << config.devices << " devices) with "
+              << config.generators.size() << " notification generator(s)"
+              << std::endl;
+
+    std::thread replayThread;
+    if (replay)
+    {
+      replay->subscribeAll([&](const std::vector<uint8_t>& value) {
+        size_t first = allDevices ? 0 : replayTarget.device;
+        size_t last  = allDevices ? config.devices : replayTarget.device + 1;
+        for (size_t device = first; device < last; device++)
+        {
+          bluez.notify(device, replayTarget.service,
+                       replayTarget.characteristic, value);
+        }
+      });
+      replayThread = std::thread([&replay]() {
+        auto stats = replay->run();
+        std::cout << "Replayed " << stats.notifications
+                  << " notifications, at most "
+                  << stats.maxLag.count() / 1000 << " us behind"
+                  << std::endl;
+      });
+    }
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+
+    if (replay)
+    {
+      replay->stop();
+      replayThread.join();
+    }
+    connection->leaveEventLoop();
+    std::cout << "Stopped after " << bluez.generated()
+              << " generated notifications" << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Stub BlueZ failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
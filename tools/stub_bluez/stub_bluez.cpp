@@ -0,0 +1,742 @@
+#include "stub_bluez/stub_bluez.hpp"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#include "boot_module/bluez_constants.hpp"
+#include "boot_module/firmware_upload.hpp"
+
+namespace boot_module::stub
+{
+namespace
+{
+using Options = std::map<std::string, sdbus::Variant>;
+
+std::string sigUuid(uint16_t shortUuid)
+{
+  char buffer[37];
+  std::snprintf(buffer,
+                sizeof(buffer),
+                "0000%04x-0000-1000-8000-00805f9b34fb",
+                shortUuid);
+  return buffer;
+}
+
+std::string indexedPath(const std::string& parent,
+                        const char*        kind,
+                        size_t             index)
+{
+  // BlueZ numbers GATT objects with four hex digits, e.g. service000a
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "/%s%04zx", kind, index);
+  return parent + buffer;
+}
+}  // namespace
+
+StubBluez::StubBluez(sdbus::IConnection& connection, StubBluezConfig config)
+  : m_connection(connection), m_config(std::move(config))
+{
+  // Validated before anything is exported or any thread started: a throw
+  // from here skips the destructor, and a joinable thread member would
+  // terminate the process
+  const auto& boot = m_config.bootTarget;
+  if (boot.enabled &&
+      (boot.service >= m_config.servicesPerDevice ||
+       boot.dataCharacteristic >= m_config.characteristicsPerService ||
+       boot.statusCharacteristic >= m_config.characteristicsPerService ||
+       boot.ackEvery == 0))
+  {
+    throw std::invalid_argument("Boot target out of range");
+  }
+  for (const auto& generator : m_config.generators)
+  {
+    if (generator.rateHz <= 0 ||
+        generator.service >= m_config.servicesPerDevice ||
+        generator.characteristic >= m_config.characteristicsPerService ||
+        (generator.device != NotificationGenerator::ALL_DEVICES &&
+         generator.device >= m_config.devices))
+    {
+      throw std::invalid_argument("Notification generator out of range");
+    }
+  }
+
+  m_root = sdbus::createObject(m_connection, sdbus::ObjectPath{"/"});
+  m_root->addObjectManager();
+
+  exportAdapter();
+  for (size_t i = 0; i < m_config.devices; i++)
+  {
+    exportDevice(i);
+  }
+
+  // Last, once nothing else can throw
+  m_timerThread = std::thread(&StubBluez::runTimers, this);
+  for (const auto& generator : m_config.generators)
+  {
+    m_generatorThreads.emplace_back(
+      &StubBluez::runGenerator, this, generator);
+  }
+}
+
+StubBluez::~StubBluez()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    m_stopping = true;
+  }
+  m_timerCondition.notify_one();
+  m_stopCondition.notify_all();
+  m_timerThread.join();
+  for (auto& generator : m_generatorThreads)
+  {
+    generator.join();
+  }
+
+  for (auto& device : m_devices)
+  {
+    for (auto& service : device->services)
+    {
+      for (auto& chr : service->characteristics)
+      {
+        if (chr->notifyFd >= 0)
+        {
+          ::close(chr->notifyFd);
+        }
+        if (chr->writeFd >= 0)
+        {
+          // Wakes the reader thread out of recv()
+          shutdown(chr->writeFd, SHUT_RDWR);
+        }
+        if (chr->writeReader.joinable())
+        {
+          chr->writeReader.join();
+        }
+        if (chr->writeFd >= 0)
+        {
+          ::close(chr->writeFd);
+        }
+      }
+    }
+  }
+}
+
+size_t StubBluez::objectCount() const
+{
+  return 1 +
+         m_config.devices *
+           (1 + m_config.servicesPerDevice *
+                  (1 + m_config.characteristicsPerService));
+}
+
+std::string StubBluez::deviceAddress(size_t device) const
+{
+  char buffer[18];
+  std::snprintf(buffer,
+                sizeof(buffer),
+                "C0:FF:EE:%02X:%02X:%02X",
+                static_cast<unsigned>((device >> 16) & 0xff),
+                static_cast<unsigned>((device >> 8) & 0xff),
+                static_cast<unsigned>(device & 0xff));
+  return buffer;
+}
+
+std::string StubBluez::devicePath(size_t device) const
+{
+  std::string address = deviceAddress(device);
+  for (auto& c : address)
+  {
+    if (c == ':')
+    {
+      c = '_';
+    }
+  }
+  return m_config.adapterPath + "/dev_" + address;
+}
+
+std::string StubBluez::servicePath(size_t device, size_t service) const
+{
+  return indexedPath(devicePath(device), "service", service + 1);
+}
+
+std::string StubBluez::characteristicPath(size_t device,
+                                          size_t service,
+                                          size_t characteristic) const
+{
+  return indexedPath(
+    servicePath(device, service), "char", characteristic + 1);
+}
+
+void StubBluez::exportAdapter()
+{
+  m_adapter = sdbus::createObject(m_connection,
+                                  sdbus::ObjectPath{m_config.adapterPath});
+  m_adapter
+    ->addVTable(
+      sdbus::registerMethod("StartDiscovery").implementedAs([this]() {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_discovering = true;
+        }
+        m_adapter->emitPropertiesChangedSignal(
+          sdbus::InterfaceName{ADAPTER_INTERFACE},
+          {sdbus::PropertyName{"Discovering"}});
+      }),
+      sdbus::registerMethod("StopDiscovery").implementedAs([this]() {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_discovering = false;
+        }
+        m_adapter->emitPropertiesChangedSignal(
+          sdbus::InterfaceName{ADAPTER_INTERFACE},
+          {sdbus::PropertyName{"Discovering"}});
+      }),
+      sdbus::registerMethod("SetDiscoveryFilter")
+        .implementedAs([](const Options&) {}),
+      sdbus::registerMethod("RemoveDevice")
+        .implementedAs([](const sdbus::ObjectPath&) {}),
+      sdbus::registerProperty("Address").withGetter(
+        []() { return std::string("00:00:00:00:00:01"); }),
+      sdbus::registerProperty("Powered").withGetter([]() { return true; }),
+      sdbus::registerProperty("Discovering").withGetter([this]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_discovering;
+      }))
+    .forInterface(ADAPTER_INTERFACE);
+}
+
+void StubBluez::exportDevice(size_t index)
+{
+  auto device     = std::make_unique<Device>();
+  device->address = deviceAddress(index);
+  device->path    = devicePath(index);
+
+  for (size_t s = 0; s < m_config.servicesPerDevice; s++)
+  {
+    exportService(*device, s);
+  }
+
+  std::vector<std::string> uuids;
+  for (const auto& service : device->services)
+  {
+    uuids.push_back(service->uuid);
+  }
+
+  Device* dev    = device.get();
+  device->object = sdbus::createObject(m_connection,
+                                       sdbus::ObjectPath{device->path});
+  device->object
+    ->addVTable(
+      sdbus::registerMethod("Connect").implementedAs(
+        [this, dev](sdbus::Result<>&& result) {
+          auto reply = std::make_shared<sdbus::Result<>>(std::move(result));
+          delayed([this, dev, reply]() {
+            setConnected(*dev, true);
+            reply->returnResults();
+          });
+        }),
+      sdbus::registerMethod("Disconnect").implementedAs(
+        [this, dev]() { setConnected(*dev, false); }),
+      sdbus::registerProperty("Address").withGetter(
+        [dev]() { return dev->address; }),
+      sdbus::registerProperty("Name").withGetter(
+        [index]() { return "stub-" + std::to_string(index); }),
+      sdbus::registerProperty("Alias").withGetter(
+        [index]() { return "stub-" + std::to_string(index); }),
+      sdbus::registerProperty("Adapter").withGetter(
+        [this]() { return sdbus::ObjectPath{m_config.adapterPath}; }),
+      sdbus::registerProperty("Paired").withGetter([]() { return false; }),
+      sdbus::registerProperty("Trusted").withGetter([]() { return false; }),
+      sdbus::registerProperty("UUIDs").withGetter([uuids]() { return uuids; }),
+      sdbus::registerProperty("RSSI").withGetter([index]() {
+        return static_cast<int16_t>(-40 - static_cast<int16_t>(index % 50));
+      }),
+      sdbus::registerProperty("Connected").withGetter([this, dev]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return dev->connected;
+      }),
+      sdbus::registerProperty("ServicesResolved").withGetter([this, dev]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return dev->servicesResolved;
+      }))
+    .forInterface(DEVICE_INTERFACE);
+
+  m_devices.push_back(std::move(device));
+}
+
+void StubBluez::exportService(Device& device, size_t index)
+{
+  auto service    = std::make_unique<Service>();
+  service->uuid   = sigUuid(static_cast<uint16_t>(0x1800 + index));
+  // Devices are appended once their services are exported
+  service->device = m_devices.size();
+  service->index  = index;
+
+  std::string path = indexedPath(device.path, "service", index + 1);
+  for (size_t c = 0; c < m_config.characteristicsPerService; c++)
+  {
+    exportCharacteristic(*service, path, c);
+  }
+
+  std::string uuid  = service->uuid;
+  std::string owner = device.path;
+  service->object =
+    sdbus::createObject(m_connection, sdbus::ObjectPath{path});
+  service->object
+    ->addVTable(
+      sdbus::registerProperty("UUID").withGetter([uuid]() { return uuid; }),
+      sdbus::registerProperty("Primary").withGetter([]() { return true; }),
+      sdbus::registerProperty("Device").withGetter(
+        [owner]() { return sdbus::ObjectPath{owner}; }))
+    .forInterface(GATT_SERVICE_INTERFACE);
+
+  device.services.push_back(std::move(service));
+}
+
+void StubBluez::exportCharacteristic(Service&           service,
+                                     const std::string& servicePath,
+                                     size_t             index)
+{
+  auto characteristic  = std::make_unique<Characteristic>();
+  characteristic->uuid = sigUuid(static_cast<uint16_t>(0x2a00 + index));
+  characteristic->flags = {"read", "write", "write-without-response", "notify"};
+  characteristic->value.assign(m_config.valueSize,
+                               static_cast<uint8_t>(index));
+
+  const auto& boot = m_config.bootTarget;
+  characteristic->bootData = boot.enabled && service.index == boot.service &&
+                             index == boot.dataCharacteristic;
+  characteristic->device   = service.device;
+  characteristic->service  = service.index;
+
+  Characteristic* chr  = characteristic.get();
+  std::string     path = indexedPath(servicePath, "char", index + 1);
+  characteristic->object =
+    sdbus::createObject(m_connection, sdbus::ObjectPath{path});
+  characteristic->object
+    ->addVTable(
+      sdbus::registerMethod("ReadValue")
+        .implementedAs([this, chr](sdbus::Result<std::vector<uint8_t>>&& result,
+                                   const Options&) {
+          auto reply = std::make_shared<sdbus::Result<std::vector<uint8_t>>>(
+            std::move(result));
+          delayed([this, chr, reply]() {
+            std::vector<uint8_t> value;
+            {
+              std::lock_guard<std::mutex> lock(m_mutex);
+              value = chr->value;
+            }
+            reply->returnResults(value);
+          });
+        }),
+      sdbus::registerMethod("WriteValue")
+        .implementedAs([this, chr](sdbus::Result<>&&            result,
+                                   const std::vector<uint8_t>& value,
+                                   const Options&) {
+          valueWritten(*chr, value.data(), value.size());
+          auto reply = std::make_shared<sdbus::Result<>>(std::move(result));
+          delayed([reply]() { reply->returnResults(); });
+        }),
+      sdbus::registerMethod("AcquireWrite")
+        .implementedAs(
+          [this, chr](const Options&) { return acquireWrite(*chr); }),
+      sdbus::registerMethod("StartNotify").implementedAs([this, chr]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        chr->notifying = true;
+      }),
+      sdbus::registerMethod("AcquireNotify")
+        .implementedAs(
+          [this, chr](const Options&) { return acquireNotify(*chr); }),
+      sdbus::registerMethod("StopNotify").implementedAs([this, chr]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        chr->notifying = false;
+      }),
+      sdbus::registerProperty("UUID").withGetter(
+        [chr]() { return chr->uuid; }),
+      sdbus::registerProperty("Service").withGetter(
+        [servicePath]() { return sdbus::ObjectPath{servicePath}; }),
+      sdbus::registerProperty("Flags").withGetter(
+        [chr]() { return chr->flags; }),
+      sdbus::registerProperty("Value").withGetter([this, chr]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return chr->value;
+      }),
+      sdbus::registerProperty("Notifying").withGetter([this, chr]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return chr->notifying;
+      }),
+      sdbus::registerProperty("MTU").withGetter(
+        [this]() { return m_config.mtu; }))
+    .forInterface(GATT_CHAR_INTERFACE);
+
+  service.characteristics.push_back(std::move(characteristic));
+}
+
+void StubBluez::notify(size_t                      device,
+                       size_t                      service,
+                       size_t                      characteristic,
+                       const std::vector<uint8_t>& value)
+{
+  auto& chr      = findCharacteristic(device, service, characteristic);
+  int   notifyFd = -1;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    chr.value = value;
+    notifyFd  = chr.notifyFd;
+  }
+
+  if (notifyFd >= 0)
+  {
+    // Blocks while the reader's socket buffer is full, so benchmarks see
+    // every notification instead of measuring drops
+    if (send(notifyFd, value.data(), value.size(), MSG_NOSIGNAL) >= 0)
+    {
+      return;
+    }
+
+    // Client closed its end; fall back to signals as BlueZ does
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (chr.notifyFd == notifyFd)
+    {
+      ::close(chr.notifyFd);
+      chr.notifyFd  = -1;
+      chr.notifying = false;
+    }
+    return;
+  }
+
+  // Emitted with explicit contents so the getter (and its lock) is not
+  // involved and the payload cannot race with the next notification
+  Options changed{{"Value", sdbus::Variant(value)}};
+  chr.object->emitSignal("PropertiesChanged")
+    .onInterface(PROPERTIES_INTERFACE)
+    .withArguments(GATT_CHAR_INTERFACE, changed, std::vector<std::string>{});
+}
+
+WriteCounters StubBluez::writes(size_t device,
+                                size_t service,
+                                size_t characteristic) const
+{
+  auto& chr = findCharacteristic(device, service, characteristic);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return chr.writes;
+}
+
+StubBluez::Characteristic& StubBluez::findCharacteristic(
+  size_t device,
+  size_t service,
+  size_t characteristic) const
+{
+  return *m_devices.at(device)->services.at(service)->characteristics.at(
+    characteristic);
+}
+
+void StubBluez::delayed(std::function<void()> task)
+{
+  if (m_config.latency.count() <= 0)
+  {
+    task();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    m_timers.emplace(std::chrono::steady_clock::now() + m_config.latency,
+                     std::move(task));
+  }
+  m_timerCondition.notify_one();
+}
+
+void StubBluez::runTimers()
+{
+  std::unique_lock<std::mutex> lock(m_timerMutex);
+  while (!m_stopping)
+  {
+    if (m_timers.empty())
+    {
+      m_timerCondition.wait(lock);
+      continue;
+    }
+
+    auto due = m_timers.begin()->first;
+    if (std::chrono::steady_clock::now() < due)
+    {
+      m_timerCondition.wait_until(lock, due);
+      continue;
+    }
+
+    auto task = std::move(m_timers.begin()->second);
+    m_timers.erase(m_timers.begin());
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+void StubBluez::runGenerator(NotificationGenerator generator)
+{
+  using Clock = std::chrono::steady_clock;
+
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(1.0 / generator.rateHz));
+  const bool   all   = generator.device == NotificationGenerator::ALL_DEVICES;
+  const size_t first = all ? 0 : generator.device;
+  const size_t last  = all ? m_config.devices : generator.device + 1;
+
+  std::vector<uint8_t> payload(generator.payloadSize);
+  uint32_t             sequence = 0;
+  auto                 next     = Clock::now();
+
+  std::unique_lock<std::mutex> lock(m_timerMutex);
+  while (!m_stopping)
+  {
+    if (Clock::now() < next)
+    {
+      m_stopCondition.wait_until(lock, next);
+      continue;
+    }
+    // Fixed schedule: a late tick is made up for by the next ones
+    next += period;
+    lock.unlock();
+
+    for (size_t device = first; device < last; device++)
+    {
+      auto& chr = findCharacteristic(
+        device, generator.service, generator.characteristic);
+      if (!isNotifying(chr))
+      {
+        continue;
+      }
+
+      uint64_t sentNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Clock::now().time_since_epoch())
+                          .count();
+      std::memcpy(payload.data(),
+                  &sentNs,
+                  std::min(payload.size(), sizeof(sentNs)));
+      if (payload.size() > sizeof(sentNs))
+      {
+        std::memcpy(payload.data() + sizeof(sentNs),
+                    &sequence,
+                    std::min(payload.size() - sizeof(sentNs),
+                             sizeof(sequence)));
+      }
+      notify(device, generator.service, generator.characteristic, payload);
+      m_generated++;
+    }
+    sequence++;
+
+    lock.lock();
+  }
+}
+
+bool StubBluez::isNotifying(Characteristic& chr) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return chr.notifying;
+}
+
+std::tuple<sdbus::UnixFd, uint16_t> StubBluez::acquireWrite(
+  Characteristic& chr)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (chr.writeAcquired)
+  {
+    throw sdbus::Error(sdbus::Error::Name{"org.bluez.Error.NotPermitted"},
+                       "Write acquired");
+  }
+
+  // Reap the previous channel, whose reader exits once the client closes
+  std::thread previous = std::move(chr.writeReader);
+  int         oldFd    = chr.writeFd;
+  chr.writeFd          = -1;
+  lock.unlock();
+  if (previous.joinable())
+  {
+    previous.join();
+  }
+  if (oldFd >= 0)
+  {
+    ::close(oldFd);
+  }
+
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+  {
+    throw sdbus::Error(sdbus::Error::Name{"org.bluez.Error.Failed"},
+                       "socketpair failed");
+  }
+
+  lock.lock();
+  chr.writeFd       = fds[0];
+  chr.writeAcquired = true;
+  chr.writeReader   = std::thread(&StubBluez::readWrites, this,
+                                std::ref(chr), fds[0]);
+  return {sdbus::UnixFd{fds[1], sdbus::adopt_fd}, m_config.mtu};
+}
+
+void StubBluez::readWrites(Characteristic& chr, int fd)
+{
+  std::vector<uint8_t> buffer(m_config.mtu);
+  while (true)
+  {
+    ssize_t bytes = recv(fd, buffer.data(), buffer.size(), 0);
+    if (bytes < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (bytes <= 0)
+    {
+      break;
+    }
+
+    valueWritten(chr, buffer.data(), static_cast<size_t>(bytes));
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  chr.writeAcquired = false;
+}
+
+void StubBluez::valueWritten(Characteristic& chr,
+                             const uint8_t*  data,
+                             size_t          size)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    chr.value.assign(data, data + size);
+    chr.writes.packets++;
+    chr.writes.bytes += size;
+  }
+  if (chr.bootData)
+  {
+    receiveUploadPacket(chr, data, size);
+  }
+}
+
+void StubBluez::receiveUploadPacket(Characteristic& chr,
+                                    const uint8_t*  data,
+                                    size_t          size)
+{
+  if (size < UPLOAD_HEADER_SIZE)
+  {
+    return;
+  }
+  uint32_t header = static_cast<uint32_t>(data[0]) |
+                    static_cast<uint32_t>(data[1]) << 8 |
+                    static_cast<uint32_t>(data[2]) << 16 |
+                    static_cast<uint32_t>(data[3]) << 24;
+  bool     last   = (header & UPLOAD_LAST_PACKET) != 0;
+  size_t   offset = header & ~UPLOAD_LAST_PACKET;
+  size_t   end    = offset + size - UPLOAD_HEADER_SIZE;
+
+  const auto&                       boot = m_config.bootTarget;
+  std::vector<std::vector<uint8_t>> replies;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    chr.unreturned++;
+    if (offset == 0 && chr.received > 0 && !chr.resendRequested)
+    {
+      // Starting over, with the same or another image
+      chr.received = 0;
+      chr.unacked  = 0;
+    }
+
+    bool stored = false;
+    if (offset > chr.received)
+    {
+      // A packet before this one was lost
+      if (!chr.resendRequested)
+      {
+        chr.resendRequested = true;
+        replies.push_back(
+          encodeUploadMessage(UploadMessage::Resend, chr.received));
+      }
+    }
+    else if (end > chr.received || last)
+    {
+      chr.received        = std::max(chr.received, end);
+      chr.resendRequested = false;
+      chr.unacked++;
+      stored = true;
+    }
+
+    if (stored && (chr.unacked >= boot.ackEvery || last))
+    {
+      replies.push_back(
+        encodeUploadMessage(UploadMessage::Ack, chr.received));
+      chr.unacked = 0;
+      if (last)
+      {
+        chr.completed++;
+      }
+    }
+    if (boot.credits &&
+        (chr.unreturned >= boot.ackEvery || !replies.empty()))
+    {
+      replies.push_back(encodeUploadMessage(
+        UploadMessage::Credit, static_cast<uint32_t>(chr.unreturned)));
+      chr.unreturned = 0;
+    }
+  }
+
+  for (const auto& reply : replies)
+  {
+    notify(chr.device, chr.service, boot.statusCharacteristic, reply);
+  }
+}
+
+uint64_t StubBluez::completedUploads(size_t device) const
+{
+  const auto& boot = m_config.bootTarget;
+  auto&       chr  = findCharacteristic(device, boot.service,
+                                        boot.dataCharacteristic);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return chr.completed;
+}
+
+std::tuple<sdbus::UnixFd, uint16_t> StubBluez::acquireNotify(
+  Characteristic& chr)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (chr.notifying)
+  {
+    throw sdbus::Error(sdbus::Error::Name{"org.bluez.Error.NotPermitted"},
+                       "Notify acquired");
+  }
+
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+  {
+    throw sdbus::Error(sdbus::Error::Name{"org.bluez.Error.Failed"},
+                       "socketpair failed");
+  }
+
+  chr.notifyFd  = fds[0];
+  chr.notifying = true;
+  return {sdbus::UnixFd{fds[1], sdbus::adopt_fd}, m_config.mtu};
+}
+
+void StubBluez::setConnected(Device& device, bool connected)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    device.connected        = connected;
+    device.servicesResolved = connected;
+  }
+
+  // Property getters take the lock, so emit only after releasing it
+  device.object->emitPropertiesChangedSignal(
+    sdbus::InterfaceName{DEVICE_INTERFACE},
+    {sdbus::PropertyName{"Connected"}});
+  device.object->emitPropertiesChangedSignal(
+    sdbus::InterfaceName{DEVICE_INTERFACE},
+    {sdbus::PropertyName{"ServicesResolved"}});
+}
+}  // namespace boot_module::stub
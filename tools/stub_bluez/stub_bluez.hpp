@@ -0,0 +1,216 @@
+#ifndef STUB_BLUEZ_H
+#define STUB_BLUEZ_H
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace boot_module::stub
+{
+// Periodic notifications on one characteristic of one device or of every
+// device. Like BlueZ, nothing is sent while no client has notifications
+// enabled on the characteristic.
+struct NotificationGenerator
+{
+  static constexpr size_t ALL_DEVICES = SIZE_MAX;
+
+  size_t device         = ALL_DEVICES;
+  size_t service        = 0;
+  size_t characteristic = 0;
+  // Notifications per second on each targeted characteristic
+  double rateHz         = 10;
+  // Each payload starts with the steady_clock send time in nanoseconds and a
+  // 32-bit sequence number, as far as they fit, so clients can measure
+  // latency and spot gaps
+  size_t payloadSize    = 20;
+};
+
+// Makes one characteristic of every device behave like a boot module's
+// upload endpoint (see firmware_upload.hpp). Packets written to the data
+// characteristic are checked for gaps, and acks, credits and resend
+// requests are notified on the status characteristic of the same service.
+struct BootTargetConfig
+{
+  bool   enabled              = false;
+  size_t service              = 0;
+  size_t dataCharacteristic   = 0;
+  size_t statusCharacteristic = 1;
+  // Ack after this many stored packets, and after the last one
+  size_t ackEvery = 8;
+  // Also return a credit for every packet received
+  bool credits = false;
+};
+
+struct StubBluezConfig
+{
+  std::string adapterPath               = "/org/bluez/hci0";
+  size_t      devices                   = 10;
+  size_t      servicesPerDevice         = 2;
+  size_t      characteristicsPerService = 3;
+  size_t      valueSize                 = 20;
+  // ATT MTU reported by AcquireNotify, AcquireWrite and the characteristics'
+  // MTU property
+  uint16_t mtu = 247;
+  // Delay before ReadValue, WriteValue and Connect reply, standing in for a
+  // BLE round trip. Requests are delayed concurrently, like a real link with
+  // several devices or queued ATT operations.
+  std::chrono::microseconds latency{0};
+  // Started with the service and stopped when it is destroyed
+  std::vector<NotificationGenerator> generators;
+  BootTargetConfig                   bootTarget;
+};
+
+// Values received by a characteristic through WriteValue or AcquireWrite
+struct WriteCounters
+{
+  uint64_t packets = 0;
+  uint64_t bytes   = 0;
+};
+
+// Stand-in for the org.bluez service: one adapter, a configurable number of
+// devices, each with GATT services and characteristics, exported under an
+// ObjectManager at "/". It lets BluetoothManager run without radios, e.g. on
+// a private bus in benchmarks.
+//
+// The caller owns the connection, requests the org.bluez name on it and runs
+// its event loop.
+class StubBluez
+{
+public:
+  StubBluez(sdbus::IConnection& connection, StubBluezConfig config);
+  ~StubBluez();
+
+  StubBluez(const StubBluez&)            = delete;
+  StubBluez& operator=(const StubBluez&) = delete;
+
+  const StubBluezConfig& config() const { return m_config; }
+  size_t                 objectCount() const;
+
+  std::string deviceAddress(size_t device) const;
+  std::string devicePath(size_t device) const;
+  std::string servicePath(size_t device, size_t service) const;
+  std::string characteristicPath(size_t device,
+                                 size_t service,
+                                 size_t characteristic) const;
+
+  // Deliver a GATT notification the way BlueZ does: over the AcquireNotify
+  // socket if a client acquired one, otherwise as a Value PropertiesChanged
+  // signal. Safe to call from any thread.
+  void notify(size_t                      device,
+              size_t                      service,
+              size_t                      characteristic,
+              const std::vector<uint8_t>& value);
+
+  WriteCounters writes(size_t device,
+                       size_t service,
+                       size_t characteristic) const;
+  // Notifications sent by the generators so far
+  uint64_t      generated() const { return m_generated; }
+  // Images the boot target of device received in full
+  uint64_t      completedUploads(size_t device) const;
+
+private:
+  struct Characteristic
+  {
+    std::unique_ptr<sdbus::IObject> object;
+    std::string                     uuid;
+    std::vector<std::string>        flags;
+    std::vector<uint8_t>            value;
+    bool                            notifying = false;
+    // Our end of the AcquireNotify socket pair, -1 when not acquired
+    int notifyFd = -1;
+    // Our end of the AcquireWrite socket pair and the thread draining it
+    int           writeFd       = -1;
+    bool          writeAcquired = false;
+    std::thread   writeReader;
+    WriteCounters writes;
+    // Boot target data characteristic state
+    bool     bootData        = false;
+    size_t   device          = 0;
+    size_t   service         = 0;
+    size_t   received        = 0;
+    size_t   unacked         = 0;
+    size_t   unreturned      = 0;
+    bool     resendRequested = false;
+    uint64_t completed       = 0;
+  };
+
+  struct Service
+  {
+    std::unique_ptr<sdbus::IObject>              object;
+    std::string                                  uuid;
+    // Position of the device and of the service in it
+    size_t                                       device = 0;
+    size_t                                       index  = 0;
+    std::vector<std::unique_ptr<Characteristic>> characteristics;
+  };
+
+  struct Device
+  {
+    std::unique_ptr<sdbus::IObject>       object;
+    std::string                           address;
+    std::string                           path;
+    bool                                  connected        = false;
+    bool                                  servicesResolved = false;
+    std::vector<std::unique_ptr<Service>> services;
+  };
+
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  sdbus::IConnection&                  m_connection;
+  StubBluezConfig                      m_config;
+  mutable std::mutex                   m_mutex;
+  std::unique_ptr<sdbus::IObject>      m_root;
+  std::unique_ptr<sdbus::IObject>      m_adapter;
+  bool                                 m_discovering = false;
+  std::vector<std::unique_ptr<Device>> m_devices;
+  // Deferred replies, run by m_timerThread when due
+  std::mutex                                      m_timerMutex;
+  std::condition_variable                         m_timerCondition;
+  std::multimap<TimePoint, std::function<void()>> m_timers;
+  bool                                            m_stopping = false;
+  std::thread                                     m_timerThread;
+  // Wakes the generators on shutdown; shares m_timerMutex and m_stopping
+  std::condition_variable                         m_stopCondition;
+  std::vector<std::thread>                        m_generatorThreads;
+  std::atomic<uint64_t>                           m_generated{0};
+
+  void exportAdapter();
+  void exportDevice(size_t index);
+  void exportService(Device& device, size_t index);
+  void exportCharacteristic(Service&           service,
+                            const std::string& servicePath,
+                            size_t             index);
+  void setConnected(Device& device, bool connected);
+  // Run task after the configured latency, inline when there is none
+  void delayed(std::function<void()> task);
+  void runTimers();
+  void runGenerator(NotificationGenerator generator);
+  bool isNotifying(Characteristic& chr) const;
+  std::tuple<sdbus::UnixFd, uint16_t> acquireNotify(Characteristic& chr);
+  std::tuple<sdbus::UnixFd, uint16_t> acquireWrite(Characteristic& chr);
+  void            readWrites(Characteristic& chr, int fd);
+  // Value written to a characteristic, by WriteValue or AcquireWrite
+  void            valueWritten(Characteristic& chr,
+                               const uint8_t*  data,
+                               size_t          size);
+  void            receiveUploadPacket(Characteristic& chr,
+                                      const uint8_t*  data,
+                                      size_t          size);
+  Characteristic& findCharacteristic(size_t device,
+                                     size_t service,
+                                     size_t characteristic) const;
+};
+}  // namespace boot_module::stub
+
+#endif  // STUB_BLUEZ_H